@@ -8,6 +8,8 @@ struct ExperimentConfig{
   bool useSimdHash = false;
   bool useSimdSel = false;
   bool useSimdProj = false;
+  bool useSimdAggr = false;
+  bool useUniqueJoin = false;
   vectorwise::primitives::F2 hash_int32_t_col();
   vectorwise::primitives::F3 hash_sel_int32_t_col();
   vectorwise::primitives::F2 rehash_int32_t_col();
@@ -21,6 +23,11 @@ struct ExperimentConfig{
   vectorwise::primitives::F4 selsel_less_int64_t_col_int64_t_val();
   vectorwise::primitives::F4 selsel_greater_equal_int64_t_col_int64_t_val();
   vectorwise::primitives::F4 selsel_less_equal_int64_t_col_int64_t_val();
+  vectorwise::primitives::F2 aggr_static_plus_int64_t_col();
+  vectorwise::primitives::F2 aggr_static_wide_plus_int64_t_col();
+  vectorwise::primitives::FAggr aggr_plus_int64_t_col();
+  vectorwise::primitives::FAggrSel aggr_sel_plus_int64_t_col();
+  vectorwise::primitives::FAggr aggr_count_star();
   joinFun joinAll();
   joinFun joinSel();
 };
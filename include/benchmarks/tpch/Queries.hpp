@@ -5,6 +5,7 @@
 #include "benchmarks/Config.hpp"
 #include "common/runtime/Concurrency.hpp"
 #include "common/runtime/Database.hpp"
+#include "common/runtime/StringSearch.hpp"
 #include "common/runtime/Types.hpp"
 #include "vectorwise/Operators.hpp"
 #include "vectorwise/Query.hpp"
@@ -146,7 +147,7 @@ class Q6Builder : public vectorwise::QueryBuilder {
       types::Numeric<12, 2> c4 = types::Numeric<12, 2>::castString("0.07");
       types::Numeric<12, 2> c5 = types::Numeric<12, 2>(types::Integer(24));
       size_t n;
-      int64_t aggregator = 0;
+      types::NumericSum<12, 4> aggregator;
       std::unique_ptr<vectorwise::Operator> rootOp;
    };
 
@@ -183,10 +184,14 @@ struct Q9Builder : public Query, private vectorwise::QueryBuilder {
       result_proj_minus,
       amount,
       o_year,
-      sum_profit
+      sum_profit,
+      n_name_late
    };
    struct Q9 {
-      types::Varchar<55> contains = types::Varchar<55>::castString("green");
+      runtime::StringPattern contains{"green"};
+      /// estimated fraction of the rows carrying n_name which reach the
+      /// aggregate output, 175 groups of about 300k joined lineitems at SF 1
+      double groupSelectivity = 0.001;
       types::Numeric<12, 2> one = types::Numeric<12, 2>::castString("1.00");
       std::unique_ptr<vectorwise::Operator> rootOp;
    };
@@ -225,12 +230,16 @@ struct Q18Builder : public Query, private vectorwise::QueryBuilder {
       group_sum,
       lineitem_matches_grouped,
       compact_quantity,
-      compact_l_orderkey
+      compact_l_orderkey,
+      late_c_name
    };
    struct Q18 {
       uint64_t zero = 0;
       types::Numeric<12, 2> qty_bound =
           types::Numeric<12, 2>::castString("300");
+      /// estimated fraction of the customers which have an order with a
+      /// quantity above qty_bound, 57 of 150k at SF 1
+      double customerSelectivity = 0.001;
       std::unique_ptr<vectorwise::Operator> rootOp;
    };
    Q18Builder(runtime::Database& db, vectorwise::SharedStateManager& shared,
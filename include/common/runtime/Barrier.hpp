@@ -2,44 +2,141 @@
 #include "Util.hpp"
 #include "common/Compat.hpp"
 #include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <functional>
 #include <new>
+#include <stdexcept>
+#include <thread>
 #include <vector>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace runtime {
 
-class Barrier {
+class BarrierAborted : public std::runtime_error {
+ public:
+   BarrierAborted() : std::runtime_error("Barrier aborted.") {}
+};
+
+class Barrier
+/// Spin-then-park barrier. Waiting threads spin for spinBudget rounds and
+/// then sleep on a futex until the last thread arrives, so idle workers of
+/// imbalanced phases give their cores back.
+{
+ public:
+   struct Stats {
+      /// number of waits of threads which were not the last to arrive
+      uint64_t waits = 0;
+      /// number of times a waiting thread went to sleep
+      uint64_t parks = 0;
+      /// time waited in total
+      uint64_t waitNanos = 0;
+      Stats& operator+=(const Stats& other) {
+         waits += other.waits;
+         parks += other.parks;
+         waitNanos += other.waitNanos;
+         return *this;
+      }
+   };
+   /// spin budget of new barriers, never park with ~0u
+   static std::atomic<uint32_t> defaultSpinBudget;
+
  private:
+   static constexpr uint32_t abortedBit = 1u << 31;
    const std::size_t threadCount;
+   const uint32_t spinBudget;
    alignas(CACHELINE_SIZE) std::atomic<std::size_t> cntr;
-   alignas(CACHELINE_SIZE) std::atomic<uint8_t> round;
+   /// round number in the low bits, abortedBit when aborted. Futex word
+   alignas(CACHELINE_SIZE) std::atomic<uint32_t> state;
+   std::atomic<uint32_t> sleepers;
+   alignas(CACHELINE_SIZE) std::atomic<uint64_t> waits;
+   std::atomic<uint64_t> parks;
+   std::atomic<uint64_t> waitNanos;
+
+   /// sleep while state is expected
+   void park(uint32_t expected) {
+      sleepers++;
+#ifdef __linux__
+      syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state),
+              FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+      if (state.load() == expected) std::this_thread::yield();
+#endif
+      sleepers--;
+      parks.fetch_add(1, std::memory_order_relaxed);
+   }
+   /// wake all sleeping threads after state changed
+   void wakeAll() {
+#ifdef __linux__
+      if (sleepers.load())
+         syscall(SYS_futex, reinterpret_cast<uint32_t*>(&state),
+                 FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+   }
 
  public:
-   explicit Barrier(std::size_t threadCount)
-       : threadCount(threadCount), cntr(threadCount), round(0) {}
+   explicit Barrier(std::size_t threadCount,
+                    uint32_t spinBudget = defaultSpinBudget)
+       : threadCount(threadCount), spinBudget(spinBudget), cntr(threadCount),
+         state(0), sleepers(0), waits(0), parks(0), waitNanos(0) {}
 
    template <typename F> bool wait(F finalizer) {
-      auto prevRound = round.load(); // Must happen before fetch_sub
-      auto prev = cntr.fetch_sub(1);
-      if (prev == 1) {
+      auto prev = state.load(); // Must happen before fetch_sub
+      if (cntr.fetch_sub(1) == 1) {
          // last thread arrived
          cntr = threadCount;
          auto r = finalizer();
-         round++;
+         // next round, keeping the aborted bit
+         auto s = state.load();
+         while (!state.compare_exchange_weak(
+             s, (s & abortedBit) | ((s + 1) & ~abortedBit)))
+            ;
+         wakeAll();
          return r;
-      } else {
-         while (round == prevRound) {
+      }
+      auto start = std::chrono::steady_clock::now();
+      uint32_t s;
+      for (uint32_t spin = 0;
+           ((s = state.load()) & ~abortedBit) == (prev & ~abortedBit);
+           ++spin) {
+         // a thread of the group failed and will never arrive
+         if (s & abortedBit) throw BarrierAborted();
+         if (spin < spinBudget) {
             // wait until barrier is ready for re-use
             asm("pause");
             asm("pause");
             asm("pause");
-         }
-         return false;
+         } else
+            park(s);
       }
+      waits.fetch_add(1, std::memory_order_relaxed);
+      waitNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count(),
+                          std::memory_order_relaxed);
+      return false;
    }
    inline bool wait() {
       return wait([]() { return true; });
    }
+   /// release all waiting threads and those arriving later with
+   /// BarrierAborted, e.g. after one thread of the group failed
+   void abort() {
+      state.fetch_or(abortedBit);
+      wakeAll();
+   }
+   Stats stats() const {
+      Stats result;
+      result.waits = waits.load();
+      result.parks = parks.load();
+      result.waitNanos = waitNanos.load();
+      return result;
+   }
 };
 
 class HierarchicBarrier {
@@ -101,6 +198,32 @@ class HierarchicBarrier {
          free(parents.back());
    }
 
+   /// abort these barriers and their parents
+   static void abort(std::vector<HierarchicBarrier*>& these) {
+      std::vector<HierarchicBarrier*> parents;
+      for (size_t i = 0; i < these.size(); i += threadsPerBarrier)
+         parents.push_back(these[i]->parent);
+      for (auto barrier : these) barrier->barrier.abort();
+      if (parents.size() > 1)
+         abort(parents);
+      else if (parents.back())
+         parents.back()->barrier.abort();
+   }
+
+   /// sum of the wait statistics of these barriers and their parents
+   static Barrier::Stats stats(const std::vector<HierarchicBarrier*>& these) {
+      Barrier::Stats result;
+      std::vector<HierarchicBarrier*> parents;
+      for (size_t i = 0; i < these.size(); i += threadsPerBarrier)
+         parents.push_back(these[i]->parent);
+      for (auto barrier : these) result += barrier->barrier.stats();
+      if (parents.size() > 1)
+         result += stats(parents);
+      else if (parents.back())
+         result += parents.back()->barrier.stats();
+      return result;
+   }
+
    template <typename F> bool wait(F finalizer);
 
    inline bool wait() {
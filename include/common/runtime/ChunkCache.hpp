@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace runtime {
+
+class ChunkCache
+/// Keeps the memory mappings of finished queries, e.g. the chunks of their
+/// pools and hash table directories, for later queries which ask for the same
+/// size. Repeated queries then work on already faulted pages instead of
+/// faulting in fresh mappings. Released mappings stay faulted up to warmLimit
+/// bytes, beyond that their pages are returned to the OS with
+/// madvise(MADV_DONTNEED) and only the address range is kept. Like fresh
+/// mappings, all memory is handed out zeroed. Mappings bound to a NUMA node
+/// are only reused for the same node.
+{
+   struct Mapping {
+      void* p;
+      /// number of leading bytes which may have been written since the
+      /// mapping was created or its pages were dropped
+      size_t dirty;
+   };
+
+   std::mutex mutex;
+   // guarded by mutex
+   /// cached mappings by size and node, most recently released last
+   std::map<std::pair<size_t, unsigned>, std::vector<Mapping>> cached;
+   size_t warmBytes = 0;
+   size_t cachedBytes = 0;
+
+ public:
+   /// node of mappings which are not bound to a NUMA node
+   static constexpr unsigned anyNode = ~0u;
+   /// maximal number of bytes kept faulted in cached mappings
+   std::atomic<size_t> warmLimit{size_t(2) << 30};
+
+   ChunkCache() = default;
+   ChunkCache(const ChunkCache&) = delete;
+   ~ChunkCache();
+
+   /// zeroed mapping of size bytes, reused from the cache if possible. Its
+   /// pages are placed on node, unless node is anyNode
+   void* allocate(size_t size, unsigned node = anyNode);
+   /// hand back mapping p of size bytes from allocate for node. Only the
+   /// first dirty bytes may have been written
+   void release(void* p, size_t size, size_t dirty, unsigned node = anyNode);
+   void release(void* p, size_t size) { release(p, size, size); }
+   /// return the pages of cached mappings to the OS until at most limit bytes
+   /// stay faulted
+   void trim(size_t limit);
+   /// unmap all cached mappings
+   void clear();
+   /// number of faulted bytes in cached mappings
+   size_t warm();
+   /// number of bytes in cached mappings
+   size_t size();
+
+   /// cache shared by all queries of the process
+   static ChunkCache& global();
+};
+} // namespace runtime
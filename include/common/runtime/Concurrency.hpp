@@ -3,25 +3,89 @@
 #include "common/Compat.hpp"
 #include "common/runtime/Barrier.hpp"
 #include "common/runtime/MemoryPool.hpp"
+#include "common/runtime/Topology.hpp"
+#include "common/runtime/Util.hpp"
 #include "tbb/task_group.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <deque>
+#include <exception>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <pthread.h>
+#include <stdexcept>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace runtime {
 
 class Worker;
 class WorkerGroup;
+class Query;
 
 extern thread_local Worker* this_worker;
 extern GlobalPool defaultPool;
 extern thread_local bool currentBarrier;
+/// cpus to which the workers of groups run by this thread are pinned, e.g.
+/// the cores of its query. Workers follow Topology::placement if empty
+extern thread_local std::vector<unsigned> workerCpus;
+
+class QueryCancelled : public std::runtime_error {
+ public:
+   using std::runtime_error::runtime_error;
+};
+
+class Cancellation
+/// Cancels a query on request or once its deadline has passed. Workers check
+/// it once per vector or morsel and unwind with QueryCancelled, which aborts
+/// the barriers of their group
+{
+   std::atomic<bool> cancelled{false};
+   /// steady clock time in nanoseconds, max for no deadline
+   std::atomic<int64_t> deadline{std::numeric_limits<int64_t>::max()};
+
+ public:
+   using clock = std::chrono::steady_clock;
+
+   void cancel() { cancelled = true; }
+   void setDeadline(clock::time_point t) {
+      deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     t.time_since_epoch())
+                     .count();
+   }
+   void setTimeout(clock::duration d) { setDeadline(clock::now() + d); }
+   /// query is cancelled or past its deadline
+   inline bool requested();
+   /// throws QueryCancelled if requested, e.g. before each vector or morsel
+   void checkpoint() {
+      if (requested()) throw QueryCancelled("Query cancelled.");
+   }
+
+   /// cancellation of the queries created by the calling thread and by the
+   /// workers of its groups, e.g. set by the QueryManager. Queries get one
+   /// of their own if null
+   static thread_local std::shared_ptr<Cancellation> current;
+};
+
+inline bool Cancellation::requested() {
+   if (cancelled.load(std::memory_order_relaxed)) return true;
+   auto d = deadline.load(std::memory_order_relaxed);
+   if (d == std::numeric_limits<int64_t>::max()) return false;
+   auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  clock::now().time_since_epoch())
+                  .count();
+   if (now < d) return false;
+   cancelled = true;
+   return true;
+}
 
 class Worker
 /// information about the worker thread.
@@ -32,13 +96,26 @@ class Worker
    WorkerGroup* group;
    Allocator allocator;
    HierarchicBarrier* barrier;
+   /// query this worker participates in, if any
+   Query* query = nullptr;
 
    void start() {
-      // set reference to worker in this thread
+      // set reference to worker in this thread. The thread may be the one
+      // waiting for the group, restore its worker afterwards
+      auto previous = this_worker;
+      auto previousBarrier = currentBarrier;
       this_worker = this;
       currentBarrier = 0;
 
-      function();
+      try {
+         function();
+      } catch (...) {
+         this_worker = previous;
+         currentBarrier = previousBarrier;
+         throw;
+      }
+      this_worker = previous;
+      currentBarrier = previousBarrier;
    };
    Worker(WorkerGroup* g, std::function<void()> f, HierarchicBarrier* b)
        : group(g), barrier(b), function(f){};
@@ -54,6 +131,21 @@ class Worker
    std::function<void()> function;
 };
 
+class MemoryScope
+/// charges the refills of the current worker's allocator and its hash table
+/// directories to account while in scope, e.g. to the account of an operator
+{
+   MemoryAccount* previous;
+
+ public:
+   explicit MemoryScope(MemoryAccount& account)
+       : previous(this_worker->allocator.operatorAccount) {
+      this_worker->allocator.operatorAccount = &account;
+   }
+   ~MemoryScope() { this_worker->allocator.operatorAccount = previous; }
+   MemoryScope(const MemoryScope&) = delete;
+};
+
 class WorkerGroup
 /// Group of worker threads which work on the same task, share a barrier etc.
 {
@@ -62,6 +154,8 @@ class WorkerGroup
  public:
    std::deque<Barrier> barriers;
    size_t size = std::thread::hardware_concurrency();
+   /// time the workers waited in the barriers of all runs
+   Barrier::Stats barrierStats;
    WorkerGroup(WorkerGroup&) = delete;
    WorkerGroup() {
       barriers.emplace_back(size);
@@ -79,30 +173,46 @@ class WorkerGroup
 inline void WorkerGroup::run(std::function<void()> f) {
    tbb::task_group g;
    auto barriers = HierarchicBarrier::create(size);
+   // the first exception of a worker fails the whole group, e.g. an exceeded
+   // memory limit. The other workers are released from the barriers
+   std::exception_ptr failure;
+   std::mutex failureMutex;
+   auto fail = [&]() {
+      {
+         std::lock_guard<std::mutex> lock(failureMutex);
+         if (!failure) failure = std::current_exception();
+      }
+      HierarchicBarrier::abort(barriers);
+   };
+   // workers are placed on the cpus of the process according to the
+   // topology, unless the calling thread restricts them
+   auto cpus = workerCpus.empty() ? Topology::get().place(size) : workerCpus;
+   // queries created by the workers are cancelled with the caller's ones
+   auto cancellation = Cancellation::current;
    int64_t group = -1;
    for (size_t i = 0; i < size - 1; ++i) {
       if (i % HierarchicBarrier::threadsPerBarrier == 0) ++group;
       threads.emplace_back(this, f, barriers[group]);
       auto worker = &threads.back();
-      g.run([worker, i]() {
+      auto cpu = cpus[i % cpus.size()];
+      g.run([worker, i, cpu, cancellation, &fail]() {
 
 #ifndef __APPLE__
-         pthread_t currentThread = pthread_self();
-         pthread_setname_np(currentThread,
+         pthread_setname_np(pthread_self(),
                             ("workerPool " + std::to_string(i)).c_str());
-         cpu_set_t cpuset;
-         CPU_ZERO(&cpuset);
-         CPU_SET(i, &cpuset);
-         if (pthread_setaffinity_np(currentThread, sizeof(cpu_set_t),
-                                    &cpuset) != 0) {
-            throw std::runtime_error("Could not pin thread " +
-                                     std::to_string(i) + " to thread " +
-                                     std::to_string(i));
-         }
 #else
          compat::unused(i);
 #endif
-         worker->start();
+         // outside of the cpuset, e.g. in a container, workers run unpinned
+         pinThread(cpu);
+         auto previousCancellation = Cancellation::current;
+         Cancellation::current = cancellation;
+         try {
+            worker->start();
+         } catch (...) {
+            fail();
+         }
+         Cancellation::current = previousCancellation;
       });
    }
    // calling worker temporarily joins this group
@@ -113,50 +223,178 @@ inline void WorkerGroup::run(std::function<void()> f) {
    this_worker->group = this;
    this_worker->barrier = barriers.back();
    currentBarrier = 0;
-   f();
+   try {
+      f();
+   } catch (...) {
+      fail();
+   }
    this_worker->group = prevGroup;
    currentBarrier = prevBarrier;
    this_worker->barrier = prevBarrierPtr;
 
    g.wait();
 
+   barrierStats += HierarchicBarrier::stats(barriers);
    HierarchicBarrier::destroy(barriers);
+   if (failure) std::rethrow_exception(failure);
 }
 
-template <typename T> class thread_specific {
-   std::mutex m;
+/// index of the calling thread. Indexes are dense, the index of a finished
+/// thread is reused by the next new thread
+inline size_t threadIndex();
+/// assign an index to the calling thread
+size_t newThreadIndex();
+extern thread_local size_t currentThreadIndex;
+/// distinguishes the threads which got the same index, set with the index.
+/// Never 0
+extern thread_local size_t currentThreadGeneration;
+
+inline size_t threadIndex() {
+   auto index = currentThreadIndex;
+   return index != ~size_t(0) ? index : newThreadIndex();
+}
+
+template <typename T> class thread_specific
+/// Thread local instances of T in slots indexed by threadIndex(). Lookups are
+/// wait free, slots are padded to cache lines and allocated in chunks on
+/// first use. Elements must only be iterated while no thread creates them.
+/// The element of a finished thread stays until a new thread with its index
+/// uses the thread_specific, which then gets a new element instead
+{
+   static constexpr size_t chunkSize = 16;
+   static constexpr size_t maxChunks = 256;
+   struct alignas(CACHELINE_SIZE) Slot {
+      bool constructed = false;
+      /// currentThreadGeneration of the thread which constructed the element
+      size_t owner = 0;
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+      T& get() { return *reinterpret_cast<T*>(&data); }
+   };
+   std::atomic<Slot*> chunks[maxChunks];
+
+   /// slot of the calling thread, without the element of a previous thread
+   Slot& slot() {
+      auto index = threadIndex();
+      if (index / chunkSize >= maxChunks)
+         throw std::runtime_error("Too many threads for thread_specific.");
+      auto& chunk = chunks[index / chunkSize];
+      auto c = chunk.load(std::memory_order_acquire);
+      if (!c) {
+         auto fresh = static_cast<Slot*>(
+             compat::aligned_alloc(CACHELINE_SIZE, sizeof(Slot) * chunkSize));
+         for (size_t i = 0; i < chunkSize; ++i) new (&fresh[i]) Slot();
+         if (chunk.compare_exchange_strong(c, fresh))
+            c = fresh;
+         else
+            free(fresh);
+      }
+      auto& s = c[index % chunkSize];
+      if (s.constructed && s.owner != currentThreadGeneration) {
+         s.get().~T();
+         s.constructed = false;
+      }
+      return s;
+   }
 
  public:
-   std::unordered_map<std::thread::id, T> threadData;
-   T& local();
-   T& put(T t);
-   template <typename... Args> T& create(Args&&... args);
-};
+   using value_type = T;
 
-template <typename T> T& thread_specific<T>::local() {
-   std::lock_guard<std::mutex> lock(m);
-   auto t = threadData.find(std::this_thread::get_id());
-   if (t == threadData.end())
-      throw std::runtime_error("Thread specific element not found.");
-   return t->second;
-}
-template <typename T> T& thread_specific<T>::put(T t) {
-   std::lock_guard<std::mutex> lock(m);
-   return threadData
-       .emplace(move(std::make_pair(std::this_thread::get_id(), std::move(t))))
-       .first->second;
-}
+   class iterator {
+      thread_specific* owner;
+      size_t index;
+      Slot* current() {
+         auto c = owner->chunks[index / chunkSize].load();
+         return c ? &c[index % chunkSize] : nullptr;
+      }
+      void skip() {
+         for (; index < maxChunks * chunkSize; ++index) {
+            if (!owner->chunks[index / chunkSize].load()) {
+               index = (index / chunkSize) * chunkSize + chunkSize - 1;
+               continue;
+            }
+            if (current()->constructed) return;
+         }
+      }
 
-template <typename T>
-template <typename... Args>
-T& thread_specific<T>::create(Args&&... args) {
-   std::lock_guard<std::mutex> lock(m);
-   return threadData
-       .emplace(std::piecewise_construct,
-                std::forward_as_tuple(std::this_thread::get_id()),
-                std::forward_as_tuple(args...))
-       .first->second;
-}
+    public:
+      iterator(thread_specific* o, size_t i) : owner(o), index(i) { skip(); }
+      T& operator*() { return current()->get(); }
+      T* operator->() { return &current()->get(); }
+      iterator& operator++() {
+         ++index;
+         skip();
+         return *this;
+      }
+      bool operator!=(const iterator& other) const {
+         return index != other.index;
+      }
+      bool operator==(const iterator& other) const {
+         return index == other.index;
+      }
+   };
+
+   thread_specific() {
+      for (auto& chunk : chunks) chunk = nullptr;
+   }
+   ~thread_specific() {
+      for (auto& chunk : chunks) {
+         auto c = chunk.load();
+         if (!c) continue;
+         for (size_t i = 0; i < chunkSize; ++i)
+            if (c[i].constructed) c[i].get().~T();
+         free(c);
+      }
+   }
+   thread_specific(thread_specific&& other) {
+      for (size_t i = 0; i < maxChunks; ++i)
+         chunks[i] = other.chunks[i].exchange(nullptr);
+   }
+   thread_specific(const thread_specific&) = delete;
+
+   /// element of the calling thread, default constructed on first use
+   T& local() {
+      bool exists;
+      return local(exists);
+   }
+   /// element of the calling thread, exists is false if it was constructed
+   T& local(bool& exists) {
+      auto& s = slot();
+      exists = s.constructed;
+      if (!exists) {
+         new (&s.data) T();
+         s.constructed = true;
+         s.owner = currentThreadGeneration;
+      }
+      return s.get();
+   }
+   /// element of the calling thread, constructed from t on first use
+   T& put(T t) { return create(std::move(t)); }
+   /// element of the calling thread, constructed from args on first use
+   template <typename... Args> T& create(Args&&... args) {
+      auto& s = slot();
+      if (!s.constructed) {
+         new (&s.data) T(std::forward<Args>(args)...);
+         s.constructed = true;
+         s.owner = currentThreadGeneration;
+      }
+      return s.get();
+   }
+
+   iterator begin() { return iterator(this, 0); }
+   iterator end() { return iterator(this, maxChunks * chunkSize); }
+   /// all elements, e.g. to process them with tbb::parallel_for
+   std::vector<T*> elements() {
+      std::vector<T*> result;
+      for (auto& element : *this) result.push_back(&element);
+      return result;
+   }
+   /// number of threads with an element
+   size_t size() {
+      size_t n = 0;
+      for (auto it = begin(); it != end(); ++it) n++;
+      return n;
+   }
+};
 
 inline bool __attribute__((noinline)) barrier()
 /// Shorthand for using the current thread groups barrier
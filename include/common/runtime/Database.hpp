@@ -1,12 +1,12 @@
 #pragma once
 #include "common/algebra/Types.hpp"
+#include "common/runtime/Concurrency.hpp"
 #include "common/runtime/MemoryPool.hpp"
 #include "common/runtime/Mmap.hpp"
 #include "common/runtime/Util.hpp"
 #include <deque>
 #include <exception>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -110,6 +110,7 @@ class BlockRelation {
       Block& operator*() { return b; }
    };
 
+   /// Blocks of the relation, as of the last call to finalize
    inline BlockIter begin() {
       if (blocks.size())
          return {this, blocks[0], blocks.begin(), blocks.end()};
@@ -122,14 +123,18 @@ class BlockRelation {
    }
 
    /// Creates a new block for data storage in this relation
-   /// Thread save against other calls to this function.
+   /// Thread safe against other calls to this function, without locking.
+   /// Blocks are read once all threads are done creating them and the
+   /// relation is finalized
    const size_t minBlockSize = 128;
    Block createBlock(size_t minNrElements);
+   /// appends the blocks created by all threads to the relation. Called once
+   /// the writers are done, e.g. by the ResultWriter or when a query is left
+   void finalize();
    Attribute addAttribute(std::string name, size_t elementSize);
    inline Attribute getAttribute(std::string name);
 
  private:
-   std::mutex insertMutex;
    struct BlockHeader {
       size_t size;
       size_t maxNrElements;
@@ -145,6 +150,9 @@ class BlockRelation {
    std::unordered_map<std::string, Attribute> attributeNames;
    std::deque<AttributeInfo> attributes;
    std::vector<BlockHeader*> blocks;
+   /// blocks created by each thread, e.g. the workers of a query writing its
+   /// result, moved to blocks by finalize
+   thread_specific<std::vector<BlockHeader*>> threadBlocks;
 };
 
 inline void* BlockRelation::Block::data(const Attribute& attr) {
@@ -1,6 +1,6 @@
 #pragma once
 #include "common/defs.hpp"
-#include "common/runtime/Memory.hpp"
+#include "common/runtime/ChunkCache.hpp"
 #include "common/runtime/SIMD.hpp"
 #include "common/runtime/Stack.hpp"
 #include <assert.h>
@@ -71,6 +71,11 @@ class Hashmap {
    inline Vec8u tag(Vec8u p);
    inline Hashmap::EntryHeader* update(Hashmap::EntryHeader* old,
                                        Hashmap::EntryHeader* p, hash_t hash);
+   /// book bytes of a directory with the memory accounts of the current
+   /// worker. Directories are not credited on destruction, their bytes are
+   /// returned with the pool of the query
+   static void chargeDirectory(size_t bytes);
+   static void creditDirectory(size_t bytes);
 };
 
 extern Hashmap::EntryHeader notFound;
@@ -79,7 +84,8 @@ inline Hashmap::EntryHeader* Hashmap::end() { return nullptr; }
 
 inline Hashmap::~Hashmap() {
   if (entries)
-     mem::free_huge(entries, capacity * sizeof(std::atomic<EntryHeader*>));
+     ChunkCache::global().release(
+         entries, capacity * sizeof(std::atomic<EntryHeader*>));
 }
 
 inline Hashmap::ptr_t Hashmap::tag(Hashmap::hash_t hash) {
@@ -192,17 +198,23 @@ void inline Hashmap::insertAll_tagged(EntryHeader* first, size_t n,
 
 size_t inline Hashmap::setSize(size_t nrEntries) {
    assert(nrEntries != 0);
-   if (entries)
-      mem::free_huge(entries, capacity * sizeof(std::atomic<EntryHeader*>));
-
    const auto loadFactor = 0.7;
    size_t exp = 64 - __builtin_clzll(nrEntries);
    assert(exp < sizeof(hash_t) * 8);
    if (((size_t)1 << exp) < nrEntries / loadFactor) exp++;
+   // book the new directory first, a failing charge leaves the table intact
+   chargeDirectory((((size_t)1) << exp) * sizeof(std::atomic<EntryHeader*>));
+   if (entries) {
+      ChunkCache::global().release(
+          entries, capacity * sizeof(std::atomic<EntryHeader*>));
+      creditDirectory(capacity * sizeof(std::atomic<EntryHeader*>));
+   }
+
    capacity = ((size_t)1) << exp;
    mask = capacity - 1;
-   entries = static_cast<std::atomic<EntryHeader*>*>(
-       mem::malloc_huge(capacity * sizeof(std::atomic<EntryHeader*>)));
+   entries =
+       static_cast<std::atomic<EntryHeader*>*>(ChunkCache::global().allocate(
+           capacity * sizeof(std::atomic<EntryHeader*>)));
    //clear();
    return capacity * loadFactor;
 }
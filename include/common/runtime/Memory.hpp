@@ -1,6 +1,10 @@
 #pragma once
 #include <stdexcept>
 #include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace mem {
 inline void* malloc_huge(size_t size) {
@@ -13,6 +17,22 @@ inline void* malloc_huge(size_t size) {
    return p;
 }
 
+/// place the pages of mapping p on NUMA node when they are faulted, returns
+/// false if the kernel does not support it
+inline bool bind_node(void* p, size_t size, unsigned node) {
+#if defined(__linux__) && defined(SYS_mbind)
+   const int preferred = 1; // MPOL_PREFERRED
+   unsigned long mask[16] = {};
+   if (node >= sizeof(mask) * 8) return false;
+   mask[node / (sizeof(long) * 8)] = 1ul << (node % (sizeof(long) * 8));
+   return syscall(SYS_mbind, p, size, preferred, mask, sizeof(mask) * 8, 0) ==
+          0;
+#else
+   (void)p, (void)size, (void)node;
+   return false;
+#endif
+}
+
 inline void free_huge(void* p, size_t size) {
    auto r = munmap(p, size);
    if (r) throw std::runtime_error("Memory unmapping failed.");
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+
+namespace runtime {
+
+class MemoryLimitExceeded : public std::runtime_error {
+ public:
+   using std::runtime_error::runtime_error;
+};
+
+class MemoryAccount
+/// Counts the bytes of memory reserved by a query or one of its operators.
+/// Charges are propagated to the parent account, e.g. from a query to the
+/// process. A charge which exceeds the limit of an account or of one of its
+/// parents is not booked and fails with MemoryLimitExceeded.
+{
+   std::atomic<size_t> current{0};
+   std::atomic<size_t> peakBytes{0};
+
+ public:
+   MemoryAccount* parent;
+   /// maximal number of bytes, 0 for no limit
+   std::atomic<size_t> limit{0};
+
+   explicit MemoryAccount(MemoryAccount* p = nullptr) : parent(p) {}
+   MemoryAccount(const MemoryAccount&) = delete;
+
+   /// book bytes, throws MemoryLimitExceeded if a limit would be exceeded
+   void allocate(size_t bytes);
+   /// return bytes booked before
+   void free(size_t bytes);
+   size_t used() const { return current.load(std::memory_order_relaxed); }
+   /// highest number of used bytes since creation or resetPeak
+   size_t peak() const { return peakBytes.load(std::memory_order_relaxed); }
+   void resetPeak() { peakBytes = used(); }
+
+   /// account of the process, parent of the accounts of all pools
+   static MemoryAccount& process();
+   /// limit for the accounts of pools created afterwards, 0 for no limit
+   static std::atomic<size_t> queryLimit;
+};
+} // namespace runtime
@@ -1,9 +1,11 @@
 #pragma once
+#include "common/runtime/MemoryAccount.hpp"
 #include <algorithm>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <memory>
 #include <mutex>
 #include <new>
 
@@ -12,39 +14,66 @@
 
 namespace runtime {
 
-class GlobalPool {
+class GlobalPool
+/// Bump allocator from which the allocators of a query take their memory.
+/// On machines with several NUMA nodes, each node has an arena of its own,
+/// whose chunks are placed on that node. Threads allocate from the arena of
+/// the node they run on, so the memory of pinned workers stays local.
+{
    struct Chunk {
       Chunk* next = nullptr;
       size_t size;
       Chunk(size_t s) : size(s) {}
    };
 
-   std::atomic<int8_t*> start;
-   std::atomic<int8_t*> end;
+   struct Arena {
+      std::atomic<int8_t*> start{nullptr};
+      std::atomic<int8_t*> end{nullptr};
 
-   std::mutex refill;
-   // guarded by refill mutex
-   Chunk* current = nullptr;
-   size_t allocSize = 128 * 1024 * 1024;
+      std::mutex refill;
+      // guarded by refill mutex
+      Chunk* current = nullptr;
+      size_t allocSize = 128 * 1024 * 1024;
+   };
+   std::unique_ptr<Arena[]> arenas;
+   size_t nrArenas;
+
+   Chunk* newChunk(size_t size, unsigned node);
 
  public:
+   /// memory reserved from this pool by the allocators of a query
+   MemoryAccount memory;
+   /// new pools have an arena per NUMA node, a single one if false
+   static bool nodeLocal;
+
    GlobalPool();
    ~GlobalPool();
    GlobalPool(GlobalPool&&) = delete;
    GlobalPool(const GlobalPool&) = delete;
 
-   Chunk* newChunk(size_t size);
+   /// size bytes from the arena of the node of the calling thread
    void* allocate(size_t size);
+   /// size bytes from the arena of node
+   void* allocate(size_t size, unsigned node);
+   /// number of arenas, i.e. of nodes
+   size_t nodes() const { return nrArenas; }
 };
 
 class Allocator {
    size_t allocSize =
        1024 * 1024 * 2; // start with a multiple of the huge page size
+   /// refills grow up to this size, larger ones would mostly stay untouched
+   static const size_t maxAllocSize = 64 * 1024 * 1024;
    uint8_t* start = nullptr;
    size_t free = 0;
 
  public:
    GlobalPool* memorySource = nullptr;
+   /// charged with each refill, the account of the memory source by default
+   MemoryAccount* account = nullptr;
+   /// additionally charged with each refill if set, e.g. by the MemoryScope
+   /// of an operator. Operator accounts are for reporting and have no limit
+   MemoryAccount* operatorAccount = nullptr;
    Allocator() = default;
    Allocator(Allocator&&) = default;
    Allocator(const Allocator&) = delete;
@@ -59,7 +88,9 @@ inline void* Allocator::allocate(size_t size) {
    auto aligndiff = 64 - ((uintptr_t)start % 64);
    size += aligndiff;
    if (free < size) {
-      allocSize = std::max(allocSize * 2, size + 64);
+      allocSize = std::max(std::min(allocSize * 2, maxAllocSize), size + 64);
+      if (account) account->allocate(allocSize);
+      if (operatorAccount) operatorAccount->allocate(allocSize);
       start = (uint8_t*)memorySource->allocate(allocSize);
 
       aligndiff = 64 - ((uintptr_t)start % 64);
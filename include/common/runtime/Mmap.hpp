@@ -178,6 +178,8 @@ template <class T> class Vector {
    }
 
    uint64_t size() const { return count; }
+   /// descriptor of the mapped file, -1 if not persistent
+   int file() const { return persistent ? fd : -1; }
    T* data() const { return data_; }
    T* begin() const { return data_; }
    T* end() const { return data_ + count; }
@@ -1,14 +1,103 @@
+#pragma once
 #include "common/defs.hpp"
 #include "common/runtime/Concurrency.hpp"
 #include "common/runtime/MemoryPool.hpp"
 #include "common/runtime/Util.hpp"
+#include <algorithm>
 #include <assert.h>
+#include <cpuid.h>
 #include <cstdlib>
 #include <cstring>
+#include <unistd.h>
 #include <vector>
+#include <x86intrin.h>
 
 namespace runtime {
 
+inline size_t dtlbEntries()
+/// entries of the first level data TLB for 4K pages as reported by cpuid,
+/// 64 if the cpu does not report them, e.g. in some virtual machines
+{
+   static const size_t entries = []() -> size_t {
+      unsigned a, b, c, d;
+      size_t found = 0;
+      // deterministic address translation parameters (Intel)
+      if (__get_cpuid_max(0, nullptr) >= 0x18) {
+         __cpuid_count(0x18, 0, a, b, c, d);
+         for (unsigned sub = 0, last = a; sub <= last; ++sub) {
+            __cpuid_count(0x18, sub, a, b, c, d);
+            auto type = d & 0x1f, level = (d >> 5) & 0x7;
+            // data, unified or store-only TLB with 4K pages
+            if (level == 1 && (type == 1 || type == 3 || type == 5) &&
+                (b & 1))
+               found = std::max(found, size_t(b >> 16) * c);
+         }
+      }
+      // L1 TLB identifiers (AMD), reserved and 0 on Intel
+      if (!found && __get_cpuid_max(0x80000000, nullptr) >= 0x80000005) {
+         __cpuid(0x80000005, a, b, c, d);
+         found = (b >> 16) & 0xff;
+      }
+      return found ? found : 64;
+   }();
+   return entries;
+}
+
+inline size_t spillFanOut(size_t nrThreads, size_t entrySize)
+/// number of spill partitions for nrThreads workers. The global aggregation
+/// wants a few partitions per worker. Small entries go through write
+/// combining buffers, which should stay in half of the L2 cache. Larger
+/// entries are written to their chunks directly, so every partition touches
+/// its own page and the fan-out stays below the number of L1 dTLB entries.
+{
+   const size_t cacheLine = 64;
+   size_t limit = dtlbEntries();
+   if (entrySize % 8 == 0 && entrySize <= cacheLine / 2) {
+      long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+      limit = (l2 > 0 ? size_t(l2) : 256 * 1024) / 2 / cacheLine;
+   }
+   return std::max(nrThreads, std::min(nrThreads * 4, limit));
+}
+
+inline void streamCopy(void* dst, const void* src, size_t bytes)
+/// copies bytes with non-temporal stores, dst and bytes must be multiples of
+/// 8. Aligned vectors, full cache lines with AVX-512, are written with the
+/// widest store available, the unaligned head and the tail with 8 byte stores
+{
+#if defined(__AVX512F__)
+   const size_t width = 64;
+#elif defined(__AVX__)
+   const size_t width = 32;
+#else
+   const size_t width = 16;
+#endif
+   auto d = reinterpret_cast<uint8_t*>(dst);
+   auto s = reinterpret_cast<const uint8_t*>(src);
+   auto end = d + bytes;
+   auto store64 = [&]() {
+      long long word;
+      std::memcpy(&word, s, sizeof(word));
+      _mm_stream_si64(reinterpret_cast<long long*>(d), word);
+      d += sizeof(word);
+      s += sizeof(word);
+   };
+   while (d != end && reinterpret_cast<uintptr_t>(d) % width) store64();
+   for (; size_t(end - d) >= width; d += width, s += width) {
+#if defined(__AVX512F__)
+      _mm512_stream_si512(reinterpret_cast<__m512i*>(d),
+                          _mm512_loadu_si512(s));
+#elif defined(__AVX__)
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(d),
+                          _mm256_loadu_si256(
+                              reinterpret_cast<const __m256i*>(s)));
+#else
+      _mm_stream_si128(reinterpret_cast<__m128i*>(d),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+#endif
+   }
+   while (d != end) store64();
+}
+
 template <size_t chunkSize>
 class PartitionedDeque
 /// Queue with multiple partitions
@@ -17,8 +106,9 @@ class PartitionedDeque
    using hash_t = defs::hash_t;
 
  public:
-   struct Chunk
-   /// Extensible storage for content
+   struct alignas(64) Chunk
+   /// Extensible storage for content. The header fills a cache line, so
+   /// the content of chunks allocated at cache lines is aligned for streaming
    {
       static const size_t size = chunkSize;
       Chunk* next = nullptr;
@@ -35,32 +125,44 @@ class PartitionedDeque
       Chunk* last = nullptr;
       void* current = nullptr;
       void* end = nullptr;
+      /// number of entries in the write combining buffer
+      size_t buffered = 0;
       void push_back(void* element, size_t size);
+      /// append n entries with non-temporal stores, see streamCopy.
+      /// entrySize must be a multiple of 8
+      void stream(void* elements, size_t n, size_t entrySize);
       size_t size(Chunk* chunk, size_t entrySize) const;
 
       Partition() = default;
       Partition(const Partition&) = delete;
       Partition(Partition&& o)
-          : first(o.first), last(o.last), current(o.current), end(o.end) {
+          : first(o.first), last(o.last), current(o.current), end(o.end),
+            buffered(o.buffered) {
          o.first = nullptr;
          o.last = nullptr;
          o.current = nullptr;
          o.end = nullptr;
+         o.buffered = 0;
       };
 
     private:
       Chunk* newChunk(size_t entrySize);
+      void reserve(size_t entrySize);
    };
 
    PartitionedDeque(size_t nrPartitions_ = 0, size_t entrySize_ = 0);
-   // required so that we are able to cope with the tbb interface for
-   // enumerable_thread_specific
+   // required so that we are able to cope with the default construction of
+   // thread_specific
    void postConstruct(size_t nrPartitions_ = 0, size_t entrySize_ = 0);
    PartitionedDeque(const PartitionedDeque&) = delete;
    ~PartitionedDeque();
 
    void push_back(void* element, hash_t hash);
+   /// write out the write combining buffers. Must be called by the owning
+   /// thread before other threads read the partitions
+   void flush();
 
+   /// Partitions, the deque must be flushed
    const std::vector<Partition>& getPartitions();
 
    /// Size of one entry in bytes
@@ -70,6 +172,16 @@ class PartitionedDeque
    /// Mask to go from hash to partition number
    std::vector<Partition> partitions;
    uint8_t shift;
+
+   static const size_t cacheLine = 64;
+   /// Software write combining: entries of up to half a cache line are
+   /// collected in a cache line sized buffer per partition and written to the
+   /// chunks a line at a time with non-temporal stores. Entries per buffer,
+   /// 0 if entries are written directly
+   size_t wcEntries = 0;
+   uint8_t* wcBuffers = nullptr;
+   std::vector<uint8_t> wcStorage;
+   void initWriteCombining();
 };
 
 template <size_t chunkSize>
@@ -93,6 +205,18 @@ PartitionedDeque<chunkSize>::PartitionedDeque(size_t nrPartitions_,
    auto exp = 64 - leadingZeros;
    auto capacity = ((size_t)1) << exp;
    partitions.resize(capacity);
+   initWriteCombining();
+}
+
+template <size_t chunkSize>
+void PartitionedDeque<chunkSize>::initWriteCombining() {
+   wcEntries = 0;
+   if (entrySize == 0 || entrySize % 8 != 0 || entrySize > cacheLine / 2)
+      return;
+   wcEntries = cacheLine / entrySize;
+   wcStorage.resize((partitions.size() + 1) * cacheLine);
+   auto misaligned = reinterpret_cast<uintptr_t>(wcStorage.data()) % cacheLine;
+   wcBuffers = wcStorage.data() + (misaligned ? cacheLine - misaligned : 0);
 }
 
 template <size_t chunkSize>
@@ -105,6 +229,7 @@ void PartitionedDeque<chunkSize>::postConstruct(size_t nrPartitions_,
    auto exp = 64 /* bultin clzll counts 64 */ - leadingZeros;
    auto capacity = ((size_t)1) << exp;
    partitions.resize(capacity);
+   initWriteCombining();
 }
 
 template <size_t chunkSize> PartitionedDeque<chunkSize>::~PartitionedDeque() {
@@ -119,12 +244,32 @@ template <size_t chunkSize> PartitionedDeque<chunkSize>::~PartitionedDeque() {
 template <size_t chunkSize>
 void PartitionedDeque<chunkSize>::push_back(void* element, hash_t hash) {
    // use upper bits of hash
-   partitions[hash >> shift].push_back(element, entrySize);
+   auto nr = hash >> shift;
+   auto& partition = partitions[nr];
+   if (!wcEntries) return partition.push_back(element, entrySize);
+   auto buffer = wcBuffers + nr * cacheLine;
+   std::memcpy(buffer + partition.buffered * entrySize, element, entrySize);
+   if (++partition.buffered == wcEntries) {
+      partition.stream(buffer, wcEntries, entrySize);
+      partition.buffered = 0;
+   }
+}
+
+template <size_t chunkSize> void PartitionedDeque<chunkSize>::flush() {
+   if (!wcEntries) return;
+   for (size_t nr = 0; nr < partitions.size(); ++nr) {
+      auto& partition = partitions[nr];
+      if (!partition.buffered) continue;
+      partition.stream(wcBuffers + nr * cacheLine, partition.buffered,
+                       entrySize);
+      partition.buffered = 0;
+   }
+   // make streamed data visible to other threads
+   _mm_sfence();
 }
 
 template <size_t chunkSize>
-void PartitionedDeque<chunkSize>::Partition::push_back(void* element,
-                                                       size_t entrySize) {
+void PartitionedDeque<chunkSize>::Partition::reserve(size_t entrySize) {
    if (!first) {
       auto created = newChunk(entrySize);
       first = created;
@@ -139,10 +284,33 @@ void PartitionedDeque<chunkSize>::Partition::push_back(void* element,
       current = created->template data<void>();
       end = addBytes(current, entrySize * chunkSize);
    }
+}
+
+template <size_t chunkSize>
+void PartitionedDeque<chunkSize>::Partition::push_back(void* element,
+                                                       size_t entrySize) {
+   reserve(entrySize);
    std::memcpy(current, element, entrySize);
    current = addBytes(current, entrySize);
 }
 
+template <size_t chunkSize>
+void PartitionedDeque<chunkSize>::Partition::stream(void* elements, size_t n,
+                                                    size_t entrySize) {
+   auto src = reinterpret_cast<uint8_t*>(elements);
+   while (n) {
+      reserve(entrySize);
+      auto fit = (reinterpret_cast<uint8_t*>(end) -
+                  reinterpret_cast<uint8_t*>(current)) /
+                 entrySize;
+      auto count = std::min(n, size_t(fit));
+      streamCopy(current, src, count * entrySize);
+      src += count * entrySize;
+      current = addBytes(current, count * entrySize);
+      n -= count;
+   }
+}
+
 template <size_t chunkSize>
 size_t PartitionedDeque<chunkSize>::Partition::size(Chunk* chunk,
                                                     size_t entrySize) const {
@@ -0,0 +1,91 @@
+#pragma once
+#include "common/runtime/Types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+namespace runtime {
+
+/// Up to this number of pre-aggregated groups over all threads, the global
+/// aggregation merges them in one pass instead of partitioning them
+const size_t singlePhaseGroupLimit = 4096;
+
+/// Keys which pack into at most this many bits are aggregated in thread local
+/// arrays indexed by their code instead of hash tables
+const unsigned packedKeyLimit = 16;
+
+template <typename K> struct PackedKey
+/// packs keys of a tiny domain into codes below 1 << bits. Keys without
+/// packing have more than packedKeyLimit bits
+{
+   static const unsigned bits = 64;
+};
+template <> struct PackedKey<types::Char<1>> {
+   static const unsigned bits = 8;
+   static uint32_t code(const types::Char<1>& k) { return uint8_t(k.value); }
+   static types::Char<1> key(uint32_t code) {
+      types::Char<1> k;
+      k.value = char(code);
+      return k;
+   }
+};
+template <> struct PackedKey<int8_t> {
+   static const unsigned bits = 8;
+   static uint32_t code(int8_t k) { return uint8_t(k); }
+   static int8_t key(uint32_t code) { return int8_t(code); }
+};
+template <typename A, typename B> struct PackedKey<std::tuple<A, B>> {
+   static const unsigned bits = PackedKey<A>::bits + PackedKey<B>::bits;
+   static uint32_t code(const std::tuple<A, B>& k) {
+      return PackedKey<A>::code(std::get<0>(k)) << PackedKey<B>::bits |
+             PackedKey<B>::code(std::get<1>(k));
+   }
+   static std::tuple<A, B> key(uint32_t code) {
+      return std::make_tuple(
+          PackedKey<A>::key(code >> PackedKey<B>::bits),
+          PackedKey<B>::key(code & ((uint32_t(1) << PackedKey<B>::bits) - 1)));
+   }
+};
+
+class AdaptivePreAggregation
+/// Decides whether thread local pre-aggregation pays off. It is switched off
+/// when a flushed table did not reduce its input by at least minReduction,
+/// tuples are then partitioned into the spill storage without aggregation.
+/// Pre-aggregation is switched on again when a bypassed window still shows
+/// that reduction (e.g. by combining equal keys within a vector), or after
+/// retryWindows bypassed windows.
+{
+ public:
+   /// minimal ratio of consumed tuples to flushed groups
+   static const size_t minReduction = 2;
+   /// number of bypassed windows before pre-aggregation is retried
+   static const size_t retryWindows = 8;
+
+ private:
+   size_t tuples = 0;
+   size_t bypassedWindows = 0;
+   size_t bypasses = 0;
+   bool bypass = false;
+
+ public:
+   /// true if tuples should be aggregated in the local table
+   inline bool aggregate() const { return !bypass; }
+   /// number of windows which bypassed pre-aggregation so far
+   inline size_t bypassed() const { return bypasses; }
+   inline void consumed(size_t n) { tuples += n; }
+   inline void flushed(size_t groups)
+   /// a window ends, either by flushing a table with groups entries or by
+   /// spilling groups unaggregated tuples
+   {
+      if (bypass) {
+         bypass = tuples < groups * minReduction &&
+                  ++bypassedWindows < retryWindows;
+      } else {
+         bypass = tuples < groups * minReduction;
+         bypassedWindows = 0;
+      }
+      bypasses += bypass;
+      tuples = 0;
+   }
+};
+} // namespace runtime
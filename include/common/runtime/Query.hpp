@@ -1,16 +1,51 @@
 #pragma once
+#include "common/runtime/Concurrency.hpp"
+#include "common/runtime/Database.hpp"
 #include "common/runtime/MemoryPool.hpp"
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace runtime {
 
 class Query {
+   std::mutex workersMutex;
+   /// resources of the scheduler threads which joined this query
+   std::unordered_map<size_t, std::unique_ptr<Worker>> workers;
+
  public:
    GlobalPool pool;
    std::unique_ptr<BlockRelation> result;
-   Query() { result = std::make_unique<BlockRelation>(); }
-   GlobalPool* participate() { return this_worker->allocator.setSource(&pool); }
-   void leave(GlobalPool* prev) { this_worker->allocator.setSource(prev); }
+   /// checked by the workers of this query once per vector or morsel
+   std::shared_ptr<Cancellation> cancellation;
+   Query()
+       : cancellation(Cancellation::current
+                          ? Cancellation::current
+                          : std::make_shared<Cancellation>()) {
+      result = std::make_unique<BlockRelation>();
+   }
+   GlobalPool* participate() {
+      this_worker->query = this;
+      return this_worker->allocator.setSource(&pool);
+   }
+   void leave(GlobalPool* prev) {
+      this_worker->query = nullptr;
+      this_worker->allocator.setSource(prev);
+   }
+   /// resources of scheduler thread id for this query, created when the
+   /// thread joins the query for the first time
+   Worker& worker(size_t id) {
+      std::lock_guard<std::mutex> lock(workersMutex);
+      auto& w = workers[id];
+      if (!w) {
+         w = std::make_unique<Worker>();
+         w->group = nullptr;
+         w->barrier = nullptr;
+         w->query = this;
+         w->allocator.setSource(&pool);
+      }
+      return *w;
+   }
 };
 
 } // namespace runtime
@@ -0,0 +1,81 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace runtime {
+
+class Query;
+class Cancellation;
+
+class QueryManager
+/// Runs multiple queries at once, each on a thread of its own. Queries are
+/// admitted when enough cores and memory are free. Memory counts as used if
+/// it is reserved by the estimate of a running query or booked in the
+/// process MemoryAccount since the manager was created. Waiting queries are
+/// admitted by priority, then in submission order. A query which does not
+/// fit yet blocks the queries behind it, so large queries do not starve.
+/// Each admitted query gets a set of cores of its own, to which its worker
+/// groups are pinned, and submits its morsels to the shared scheduler with
+/// its priority.
+{
+ public:
+   /// runs a query with the given number of threads
+   using QueryFn = std::function<std::unique_ptr<Query>(size_t nrThreads)>;
+
+ private:
+   struct Pending {
+      QueryFn fn;
+      size_t threads;
+      size_t memory;
+      int priority;
+      std::shared_ptr<Cancellation> cancellation;
+      std::promise<std::unique_ptr<Query>> result;
+   };
+
+   const size_t memoryBudget;
+   /// memory of the process account before the first query
+   const size_t baseMemory;
+   /// cpu of each core, following the default placement
+   const std::vector<unsigned> cpus;
+   std::mutex mutex;
+   std::condition_variable finished;
+   // guarded by mutex
+   std::list<Pending> waiting;
+   std::vector<bool> coreUsed;
+   size_t freeCores;
+   size_t reservedMemory = 0;
+   size_t running = 0;
+
+   /// bytes of the budget in use, the larger of the estimates of the running
+   /// queries and the bytes they actually booked
+   size_t usedMemory() const;
+   /// start waiting queries which fit, requires mutex
+   void admit();
+   void run(Pending query, std::vector<unsigned> cores);
+
+ public:
+   /// manage cores and memoryBudget bytes, 0 for no memory budget
+   QueryManager(size_t cores, size_t memoryBudget = 0);
+   /// waits for all submitted queries
+   ~QueryManager();
+   QueryManager(const QueryManager&) = delete;
+
+   /// run fn with threads threads once admitted. memory is the expected
+   /// number of bytes the query reserves. The query fails with
+   /// QueryCancelled when cancellation is cancelled or its deadline passes,
+   /// also while it waits for admission
+   std::future<std::unique_ptr<Query>>
+   submit(QueryFn fn, size_t threads, size_t memory = 0, int priority = 0,
+          std::shared_ptr<Cancellation> cancellation = nullptr);
+   /// wait until all submitted queries are finished
+   void wait();
+   size_t nrRunning();
+   size_t nrWaiting();
+};
+} // namespace runtime
@@ -0,0 +1,135 @@
+#pragma once
+#include "common/runtime/Database.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+class AsyncReader
+/// Reads file ranges into a bounded ring of buffers with asynchronous I/O,
+/// with io_uring where the kernel allows it and a pool of threads doing
+/// pread otherwise. Reads are issued round robin into the buffers, a buffer
+/// is reused once the read before is complete. Not thread safe
+{
+ public:
+   enum class Backend { uring, threads };
+
+ private:
+   struct Buffer {
+      void* data;
+      int fd = -1;
+      size_t offset = 0;
+      size_t size = 0;
+      /// bytes read or negative errno, valid when done
+      long result = 0;
+      bool busy = false;
+      bool done = false;
+   };
+   struct Uring;
+
+   const size_t bufferSize;
+   std::vector<Buffer> buffers;
+   size_t nextBuffer = 0;
+   size_t bytes = 0;
+   Backend backend_;
+   std::unique_ptr<Uring> uring;
+
+   // thread backend
+   std::vector<std::thread> threads;
+   std::mutex mutex;
+   std::condition_variable requested, completed;
+   // guarded by mutex
+   std::deque<size_t> queue;
+   bool stopping = false;
+
+   void readerMain();
+   /// waits until buffer i is done
+   void complete(size_t i);
+   /// waits for the read into buffer i without checking its result
+   void release(size_t i);
+
+ public:
+   AsyncReader(size_t nrBuffers, size_t bufferSize,
+               Backend preferred = Backend::uring);
+   /// waits for all reads in flight
+   ~AsyncReader();
+   AsyncReader(const AsyncReader&) = delete;
+
+   /// starts reading size bytes, at most bufferSize, of fd at offset into the
+   /// next buffer of the ring and returns its index. Waits if the read
+   /// before into that buffer is still in flight
+   size_t read(int fd, size_t offset, size_t size);
+   /// true if read would not wait
+   bool available();
+   /// waits for the read into buffer i and returns the number of bytes read,
+   /// throws on I/O errors. The data stays valid until the buffer is reused
+   size_t wait(size_t i);
+   /// waits for all reads in flight
+   void drain();
+   const void* data(size_t i) const { return buffers[i].data; }
+   size_t nrBuffers() const { return buffers.size(); }
+   Backend backend() const { return backend_; }
+   /// bytes of all completed reads
+   size_t bytesRead() const { return bytes; }
+};
+
+class ReadAhead
+/// Reads the files of mmapped columns ahead of a scan, so that its page
+/// faults are served from the page cache instead of waiting for the device,
+/// e.g. in cold queries. Scans report the first tuple of each vector or
+/// morsel they claim, from any number of threads, and the next depth windows
+/// are read with an AsyncReader. The scan never waits for the reader: while
+/// all of its buffers are in flight, windows are only announced to the
+/// kernel with posix_fadvise
+{
+   struct Column {
+      int fd;
+      size_t elementSize;
+   };
+   std::vector<Column> columns;
+   const size_t nrTuples;
+   std::mutex mutex;
+   // guarded by mutex
+   std::unique_ptr<AsyncReader> reader;
+   std::vector<bool> issued;
+   size_t bytes = 0;
+   size_t advisedBytes = 0;
+
+ public:
+   /// tuples per window
+   static constexpr size_t windowSize = 1 << 16;
+   /// windows read ahead of the scan position
+   static size_t depth;
+   /// buffers of the reader of each scan, only posix_fadvise with 0
+   static size_t buffers;
+   /// scans read ahead of their position, off by default
+   static bool enabled;
+
+   ReadAhead(const std::vector<Attribute*>& attributes, size_t nrTuples);
+   /// read ahead for the attributes if enabled, nullptr if disabled or none
+   /// of them is a mapped file
+   static std::unique_ptr<ReadAhead>
+   create(const std::vector<Attribute*>& attributes, size_t nrTuples);
+   static std::unique_ptr<ReadAhead>
+   create(Relation& rel, const std::vector<std::string>& attributes);
+
+   /// a scan reached tuple pos. Returns immediately if another thread is
+   /// requesting windows
+   void advance(size_t pos);
+   static void advance(ReadAhead* r, size_t pos) {
+      if (r) r->advance(pos);
+   }
+   /// bytes of the windows requested so far
+   size_t requested();
+   /// bytes of the windows only requested with posix_fadvise
+   size_t advised();
+   /// waits for the reads in flight, returns the bytes read so far
+   size_t finish();
+};
+} // namespace runtime
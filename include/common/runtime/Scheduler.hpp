@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace runtime {
+
+class Query;
+
+class Scheduler
+/// Morsel-driven work-stealing scheduler shared by all queries. A job splits
+/// a range into morsels, processed by the threads of the scheduler and the
+/// submitting thread. Each thread starts on its own slice of the range and
+/// steals morsels from the other slices when it runs dry. Between morsels,
+/// threads switch to jobs of higher priority, so they join and leave running
+/// queries at morsel boundaries.
+{
+ public:
+   /// processes the morsel [begin, end)
+   using Morsel = std::function<void(size_t begin, size_t end)>;
+
+   class Job {
+      friend class Scheduler;
+      struct alignas(64) Slice {
+         std::atomic<size_t> next;
+         size_t end;
+      };
+
+      const Morsel& fn;
+      const size_t morselSize;
+      const int priority;
+      Query* const query;
+      std::unique_ptr<Slice[]> slices;
+      size_t nrSlices;
+      /// number of processed elements
+      std::atomic<size_t> done{0};
+      const size_t n;
+      /// number of threads holding a reference to this job
+      std::atomic<size_t> users{0};
+      /// the submitting thread sleeps on released until users drops to 0
+      std::mutex usersMutex;
+      std::condition_variable released;
+      std::mutex failureMutex;
+      std::exception_ptr failure;
+
+      Job(size_t n, size_t morselSize, const Morsel& fn, int priority,
+          Query* query, size_t nrSlices);
+      /// claim the next morsel, starting with slice first. Returns false if
+      /// all morsels are claimed
+      bool claim(size_t first, size_t& begin, size_t& end);
+      /// process morsels starting on slice first until all are claimed or
+      /// stop returns true
+      template <typename S> void work(size_t first, S stop);
+      bool finished() const { return done.load() == n; }
+      /// drop the reference of a scheduler thread
+      void leave();
+   };
+
+ private:
+   std::vector<std::thread> threads;
+   std::mutex mutex;
+   std::condition_variable wakeup;
+   // guarded by mutex
+   std::vector<Job*> jobs;
+   bool stopping = false;
+   /// highest priority of all submitted jobs
+   std::atomic<int> topPriority;
+
+   void threadMain(size_t id);
+   /// recompute topPriority, requires mutex
+   void updatePriority();
+   /// job with the highest priority which still has morsels, users is
+   /// incremented. Round robin among jobs of equal priority
+   Job* pick(size_t id);
+
+ public:
+   /// start nrThreads threads, submitting threads work in addition to them
+   explicit Scheduler(size_t nrThreads);
+   ~Scheduler();
+   Scheduler(const Scheduler&) = delete;
+
+   /// process [0, n) in morsels of morselSize with fn and wait until all are
+   /// done. Jobs of higher priority are preferred. Morsels run with the
+   /// resources of query, by default the query of the submitting thread.
+   /// The first exception thrown by fn skips the remaining morsels and is
+   /// rethrown
+   void parallelFor(size_t n, size_t morselSize, const Morsel& fn,
+                    int priority = threadPriority, Query* query = nullptr);
+   /// number of threads, including one submitting thread
+   size_t size() const { return threads.size() + 1; }
+
+   /// default priority of the jobs submitted by this thread, e.g. the
+   /// priority of the query it runs
+   static thread_local int threadPriority;
+   /// id of the calling scheduler thread, 0 for other threads
+   static size_t threadId();
+   /// size of the global scheduler, set before its first use
+   static size_t globalThreads;
+   /// scheduler shared by all queries of the process
+   static Scheduler& global();
+};
+} // namespace runtime
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace runtime {
+
+class StringPattern
+/// constant pattern for LIKE predicates of the form 'x%', '%x' and '%x%'.
+/// Shared by the vectorwise selection primitives and the hyper queries.
+{
+   std::string text;
+
+ public:
+   StringPattern(std::string t) : text(std::move(t)) {}
+
+   inline const char* data() const { return text.data(); }
+   inline size_t size() const { return text.size(); }
+
+   inline bool prefixOf(const char* str, size_t len) const
+   /// LIKE 'pattern%'
+   {
+      return (len >= size()) && (memcmp(str, data(), size()) == 0);
+   }
+
+   inline bool suffixOf(const char* str, size_t len) const
+   /// LIKE '%pattern'
+   {
+      return (len >= size()) &&
+             (memcmp(str + len - size(), data(), size()) == 0);
+   }
+
+   /// position of the first occurrence of the pattern in str, or nullptr.
+   /// Candidates are filtered by comparing the first and last character of
+   /// the pattern against 32 positions at once (AVX2), only candidates
+   /// matching both are compared fully.
+   const char* findIn(const char* str, size_t len) const;
+
+   inline bool containedIn(const char* str, size_t len) const
+   /// LIKE '%pattern%'
+   {
+      return findIn(str, len) != nullptr;
+   }
+};
+} // namespace runtime
@@ -0,0 +1,80 @@
+#pragma once
+#include "tbb/task_scheduler_observer.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace runtime {
+
+/// order in which workers are placed on the cpus of the process
+enum class Placement {
+   /// one thread per physical core first, SMT siblings afterwards
+   physical,
+   /// fill all SMT siblings of a core before using the next core
+   compact,
+   /// round robin over NUMA nodes, physical cores first on each node
+   spread
+};
+
+class Topology
+/// Logical cpus the process may run on, i.e. its cpuset, with their cores,
+/// sockets and NUMA nodes as found in /sys/devices/system/cpu
+{
+ public:
+   struct Cpu {
+      unsigned id;
+      unsigned package;
+      unsigned core;
+      unsigned node;
+      /// index among the SMT siblings of its core
+      unsigned sibling;
+   };
+   std::vector<Cpu> cpus;
+   size_t nrNodes = 1;
+   /// node of each cpu of the cpuset by id
+   std::vector<unsigned> nodeOf;
+   /// node ids of the kernel, e.g. for mbind, by node
+   std::vector<unsigned> osNodes;
+
+   /// topology of the allowed cpus described by the sysfs cpu directory root
+   static Topology read(const std::string& root,
+                        const std::vector<unsigned>& allowed);
+   /// topology of this process
+   static Topology detect();
+   /// the detected topology of this process
+   static const Topology& get();
+
+   /// cpu ids for n workers, worker i runs on cpu place(n)[i]. Cpus are
+   /// reused round robin when n exceeds the number of cpus
+   std::vector<unsigned> place(size_t n, Placement p) const;
+   std::vector<unsigned> place(size_t n) const { return place(n, placement); }
+
+   /// kernel id of node
+   unsigned osNode(unsigned node) const;
+   /// NUMA node the calling thread currently runs on
+   static unsigned currentNode();
+
+   /// default placement of the process
+   static Placement placement;
+   /// placement of the given name, e.g. "spread"
+   static Placement parsePlacement(const std::string& name);
+};
+
+/// pin the calling thread to cpu, returns false if this is not possible,
+/// e.g. because cpu is not in the cpuset of the process
+bool pinThread(unsigned cpu);
+
+class ArenaPlacement : public tbb::task_scheduler_observer
+/// pins the threads entering the tbb arena of the hyper queries to the cpus
+/// of the default placement, in the order they enter
+{
+   std::vector<unsigned> cpus;
+   std::atomic<size_t> next{0};
+
+ public:
+   explicit ArenaPlacement(size_t nrThreads);
+   ~ArenaPlacement();
+   void on_scheduler_entry(bool worker) override;
+};
+} // namespace runtime
@@ -691,6 +691,96 @@ std::ostream& operator<<(std::ostream& out,
    return out;
 }
 //---------------------------------------------------------------------------
+/// A 128 bit sum of 64 bit integers, for sums which may exceed 64 bits. The
+/// value is high * 2^64 + low with a signed low part. Additions go to low,
+/// only an overflow of low (the overflow flag of the addition) touches high.
+/// Sums which fit into 64 bits cost the same as a 64 bit sum
+class Sum128 {
+ public:
+   int64_t low;
+   int64_t high;
+
+   Sum128() : low(0), high(0) {}
+   Sum128(int64_t v) : low(v), high(0) {}
+
+   /// Add
+   inline void add(int64_t v) {
+      if (__builtin_expect(__builtin_add_overflow(low, v, &low), 0))
+         high += v < 0 ? -1 : 1;
+   }
+   /// Add, e.g. the partial sum of another thread
+   inline void add(const Sum128& s) {
+      add(s.low);
+      high += s.high;
+   }
+   /// Does the value fit into 64 bits
+   bool fits64() const { return high == 0; }
+   /// Get the value
+   __int128 getRaw() const {
+      return (__int128)((unsigned __int128)high << 64) + low;
+   }
+};
+//---------------------------------------------------------------------------
+/// Sum of Numerics, e.g. for SUM and AVG over large inputs
+template <unsigned len, unsigned precision>
+class NumericSum : public Sum128 {
+ public:
+   NumericSum() {}
+   NumericSum(Numeric<len, precision> x) : Sum128(x.value) {}
+
+   /// Add
+   NumericSum& operator+=(const Numeric<len, precision>& n) {
+      add(n.value);
+      return *this;
+   }
+   /// Add
+   NumericSum& operator+=(const NumericSum<len, precision>& s) {
+      add(s);
+      return *this;
+   }
+   /// Comparison
+   bool operator==(const NumericSum<len, precision>& s) const {
+      return getRaw() == s.getRaw();
+   }
+   /// Comparison
+   bool operator==(const Numeric<len, precision>& n) const {
+      return fits64() && low == n.value;
+   }
+   /// Cast, throws if the sum does not fit into a Numeric
+   Numeric<len, precision> castN() const {
+      if (!fits64()) throw "numeric overflow: sum exceeds 64 bits";
+      return Numeric<len, precision>::buildRaw(low);
+   }
+   /// Average of count summands
+   Numeric<len, precision> avg(int64_t count) const {
+      auto r = getRaw() / count;
+      if (r != int64_t(r)) throw "numeric overflow: average exceeds 64 bits";
+      return Numeric<len, precision>::buildRaw(int64_t(r));
+   }
+};
+//---------------------------------------------------------------------------
+template <unsigned len, unsigned precision>
+std::ostream& operator<<(std::ostream& out,
+                         const NumericSum<len, precision>& value)
+// Dump the value
+{
+   auto v = value.getRaw();
+   if (v < 0) {
+      out << '-';
+      v = -v;
+   }
+   // at most 39 digits and a separator
+   char digits[41];
+   auto end = digits + sizeof(digits), start = end;
+   unsigned digit = 0;
+   do {
+      if (precision && digit++ == precision) *--start = '.';
+      *--start = '0' + int(v % 10);
+      v /= 10;
+   } while (v || digit <= precision);
+   return out.write(start, end - start);
+}
+//---------------------------------------------------------------------------
 /// A timestamp
 class Date {
  public:
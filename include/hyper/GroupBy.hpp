@@ -1,11 +1,56 @@
+#include "common/runtime/Concurrency.hpp"
 #include "common/runtime/Hashmap.hpp"
+#include "common/runtime/PartitionedDeque.hpp"
+#include "common/runtime/PreAggregation.hpp"
 #include "common/runtime/Stack.hpp"
 #include "tbb/tbb.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace aggregates {
+/// Decomposable aggregate functions, usable as update of GroupBy and
+/// PartialGroupBy. Partial aggregates of f are combined with mergeOf(f).
+struct Sum {
+   template <typename A, typename VALUE>
+   inline void operator()(A& acc, const VALUE& value) const {
+      acc += value;
+   }
+};
+struct Count {
+   template <typename A, typename VALUE>
+   inline void operator()(A& acc, const VALUE&) const {
+      acc += 1;
+   }
+};
+struct Min {
+   template <typename A, typename VALUE>
+   inline void operator()(A& acc, const VALUE& value) const {
+      if (value < acc) acc = value;
+   }
+};
+struct Max {
+   template <typename A, typename VALUE>
+   inline void operator()(A& acc, const VALUE& value) const {
+      if (acc < value) acc = value;
+   }
+};
+
+/// merge function for partial aggregates of update. Partial counts are
+/// summed up, other updates, e.g. sums in lambdas, merge themselves
+template <typename UPDATE> inline UPDATE mergeOf(UPDATE update) {
+   return update;
+}
+inline Sum mergeOf(Count) { return Sum(); }
+} // namespace aggregates
 
 template <typename K, typename V, typename HASH, typename UPDATE>
 class GroupBy {
    /// Hashmap for grouping
-   tbb::enumerable_thread_specific<runtime::Hashmapx<K, V, HASH, false>> groups;
+   runtime::thread_specific<runtime::Hashmapx<K, V, HASH, false>> groups;
 
  public:
    /// type of entry struct in hashmap
@@ -13,19 +58,55 @@ class GroupBy {
 
  private:
    /// Memory for materialized entries in hashmap
-   tbb::enumerable_thread_specific<runtime::Stack<group_t>> entries;
+   runtime::thread_specific<runtime::Stack<group_t>> entries;
    /// Memory for spilling hastable entries
-   tbb::enumerable_thread_specific<runtime::PartitionedDeque<1024>>
-       partitionedDeques;
+   runtime::thread_specific<runtime::PartitionedDeque<1024>> partitionedDeques;
+   /// Thread local decision about pre-aggregation, kept across morsels
+   runtime::thread_specific<runtime::AdaptivePreAggregation> adaptivity;
+
+   /// keys of a tiny domain are aggregated in arrays instead of hashtables
+   static const bool packed =
+       runtime::PackedKey<K>::bits <= runtime::packedKeyLimit;
+   static const size_t domain =
+       packed ? size_t(1) << (packed ? runtime::PackedKey<K>::bits : 0) : 0;
+   using packed_t = std::integral_constant<bool, packed>;
+
+   /// Thread local aggregates of all codes of a packed key. The aggregate of
+   /// a code is initialized by its first tuple, pages of codes which are not
+   /// used are not touched
+   struct PackedGroups {
+      std::vector<uint8_t> used;
+      V* values;
+      PackedGroups()
+          : used(domain, 0),
+            values(static_cast<V*>(std::malloc(domain * sizeof(V)))) {}
+      PackedGroups(const PackedGroups&) = delete;
+      ~PackedGroups() {
+         for (size_t code = 0; code < domain; ++code)
+            if (used[code]) values[code].~V();
+         std::free(values);
+      }
+      inline V& get(uint32_t code, const V& init) {
+         if (!used[code]) {
+            new (&values[code]) V(init);
+            used[code] = 1;
+         }
+         return values[code];
+      }
+   };
+   runtime::thread_specific<PackedGroups> packedGroups;
 
    UPDATE update;
+   /// combines pre-aggregated groups of the same key
+   decltype(aggregates::mergeOf(std::declval<UPDATE>())) merge;
    V init;
 
    size_t nrThreads;
 
  public:
    GroupBy(UPDATE u, V i, size_t nrThreads_)
-       : update(u), init(i), nrThreads(nrThreads_) {}
+       : update(u), merge(aggregates::mergeOf(u)), init(i),
+         nrThreads(nrThreads_) {}
 
    GroupBy(const GroupBy& g) = delete;
    GroupBy(GroupBy&& g) = default;
@@ -38,7 +119,9 @@ class GroupBy {
       runtime::Hashmapx<K, V, HASH, false>& groups;
       runtime::Stack<group_t>& entries;
       runtime::PartitionedDeque<1024>& spillStorage;
+      runtime::AdaptivePreAggregation& adaptivity;
       size_t maxFill;
+      PackedGroups* packedGroups;
 
       void spill() {
          for (auto block : entries)
@@ -46,49 +129,63 @@ class GroupBy {
                spillStorage.push_back(&entry, entry.h.hash);
       }
 
+      void spillAndClear(size_t nrGroups) {
+         spill();
+         adaptivity.flushed(nrGroups);
+         groups.clear();
+         entries.clear();
+      }
+
+      template <typename KEY> inline V* findGroup(KEY&& key) {
+         return findGroup(std::forward<KEY>(key), packed_t());
+      }
+
+      template <typename KEY> inline V* findGroup(KEY&& key, std::true_type) {
+         return &packedGroups->get(runtime::PackedKey<K>::code(key),
+                                   parent.init);
+      }
+
+      template <typename KEY>
+      inline V* findGroup(KEY&& key, std::false_type) {
+         auto hash = groups.hash(key);
+         adaptivity.consumed(1);
+         if (!adaptivity.aggregate()) {
+            // pre-aggregation does not reduce the input, every tuple becomes
+            // a group of its own and is spilled without hashtable lookup
+            if (entries.size() >= maxFill) spillAndClear(entries.size());
+            entries.emplace_back(hash, key, parent.init);
+            return &entries.back().v;
+         }
+         return groups.findOrCreate(key, hash, parent.init, entries, [&]() {
+            if (groups.size() >= maxFill) spillAndClear(groups.size());
+         });
+      }
+
     public:
       Locals(GroupBy& p, runtime::Hashmapx<K, V, HASH, false>& g,
              runtime::Stack<group_t>& e, runtime::PartitionedDeque<1024>& s,
-             size_t m)
-          : parent(p), groups(g), entries(e), spillStorage(s), maxFill(m) {}
+             runtime::AdaptivePreAggregation& a, size_t m, PackedGroups* pg)
+          : parent(p), groups(g), entries(e), spillStorage(s), adaptivity(a),
+            maxFill(m), packedGroups(pg) {}
+      /// the owning thread writes out the spill buffers at the end of its
+      /// pre-aggregation
+      ~Locals() { spillStorage.flush(); }
 
       /// consume key and value
       template <typename KEY, typename VALUE>
       inline void consume(KEY&& key, VALUE&& value) {
-         auto group = groups.findOrCreate(key, groups.hash(key), parent.init,
-                                          entries, [&]() {
-                                             if (groups.size() >= maxFill) {
-                                                spill();
-                                                groups.clear();
-                                                entries.clear();
-                                             }
-                                          });
+         auto group = findGroup(std::forward<KEY>(key));
          parent.update(*group, std::forward<VALUE>(value));
       }
 
       template <typename KEY, typename VALUECB>
       inline void consume_callback(KEY&& key, VALUECB cb) {
-         auto group = groups.findOrCreate(key, groups.hash(key), parent.init,
-                                          entries, [&]() {
-                                             if (groups.size() >= maxFill) {
-                                                spill();
-                                                groups.clear();
-                                                entries.clear();
-                                             }
-                                          });
-         cb(*group);
+         cb(*findGroup(std::forward<KEY>(key)));
       }
 
      template<typename KEY>
       inline V& getGroup(KEY&& key) {
-       return *groups.findOrCreate(std::forward<KEY>(key), groups.hash(std::forward<KEY>(key)), parent.init,
-                                     entries, [&]() {
-                                        if (groups.size() >= maxFill) {
-                                           spill();
-                                           groups.clear();
-                                           entries.clear();
-                                        }
-                                     });
+       return *findGroup(std::forward<KEY>(key));
       }
    };
 
@@ -105,20 +202,27 @@ class GroupBy {
       auto& e = entries.local();
 
       auto& spillStorage = partitionedDeques.local(exists);
-      if (!exists) spillStorage.postConstruct(nrThreads * 4, sizeof(group_t));
+      if (!exists)
+         spillStorage.postConstruct(
+             runtime::spillFanOut(nrThreads, sizeof(group_t)), sizeof(group_t));
 
-      return Locals(*this, g, e, spillStorage, maxFill);
+      return Locals(*this, g, e, spillStorage, adaptivity.local(), maxFill,
+                    packed ? &packedGroups.local() : nullptr);
    }
    /// Spill all
    void spillAll() {
-      tbb::parallel_for(entries.range(), [&](const auto& e) {
+      auto all = entries.elements();
+      tbb::parallel_for(size_t(0), all.size(), [&](size_t i) {
 
          bool exists;
          auto& deque = partitionedDeques.local(exists);
-         if (!exists) deque.postConstruct(nrThreads * 4, sizeof(group_t));
-         for (auto& entries : e)
-            for (auto block : entries)
-               for (auto& entry : block) deque.push_back(&entry, entry.h.hash);
+         if (!exists)
+            deque.postConstruct(
+                runtime::spillFanOut(nrThreads, sizeof(group_t)),
+                sizeof(group_t));
+         for (auto block : *all[i])
+            for (auto& entry : block) deque.push_back(&entry, entry.h.hash);
+         deque.flush();
       });
    }
 
@@ -130,8 +234,86 @@ class GroupBy {
       return newCapacity;
    }
 
+   /// Number of windows in which threads bypassed pre-aggregation
+   size_t bypassedWindows() {
+      size_t windows = 0;
+      for (auto& a : adaptivity) windows += a.bypassed();
+      return windows;
+   }
+
+   /// Number of pre-aggregated groups of all threads, or ~0 if any thread
+   /// had to spill
+   size_t localGroupCount() {
+      for (auto& deque : partitionedDeques)
+         for (auto& partition : deque.getPartitions())
+            if (partition.first) return ~size_t(0);
+      size_t count = 0;
+      for (auto& e : entries) count += e.size();
+      return count;
+   }
+
+   /// Merge the few groups of all thread local tables in one pass over them.
+   /// Groups are split by hash into one part per 256 groups, which are
+   /// merged in parallel. Each thread's entries are split once into the parts
+   template <typename C> inline void mergeLocalGroups(C consume, size_t count) {
+      auto all = entries.elements();
+      auto nrParts = std::max(size_t(1), std::min(nrThreads, count / 256));
+      // entries of thread t for part p in parts[t * nrParts + p]
+      std::vector<std::vector<group_t*>> parts(all.size() * nrParts);
+      tbb::parallel_for(size_t(0), all.size(), [&](size_t t) {
+         auto split = parts.begin() + t * nrParts;
+         for (auto block : *all[t])
+            for (auto& entry : block)
+               split[entry.h.hash % nrParts].push_back(&entry);
+      });
+      tbb::parallel_for(size_t(0), nrParts, [&](size_t part) {
+         runtime::Hashmapx<K, V, HASH, false> ht;
+         runtime::Stack<group_t> merged;
+         ht.setSize(count / nrParts + 1);
+         for (size_t t = 0; t < all.size(); ++t)
+            for (auto entry : parts[t * nrParts + part])
+               merge(*ht.findOrCreate(entry->k, entry->h.hash, init, merged),
+                     entry->v);
+         if (!merged.empty()) consume(merged);
+      });
+   }
+
    /// Iterate over all groups of tuples consumed by Locals::consume
    template <typename C> inline void forallGroups(C consume) {
+      forallGroups(consume, packed_t());
+   }
+
+   /// Merge the arrays of packed keys of all threads, each task merges a
+   /// range of codes
+   template <typename C> void forallGroups(C consume, std::true_type) {
+      auto all = packedGroups.elements();
+      tbb::parallel_for(
+          tbb::blocked_range<size_t>(0, domain, 4096), [&](const auto& r) {
+             auto& ht = groups.local();
+             auto& localEntries = entries.local();
+             localEntries.clear();
+             for (auto code = r.begin(); code != r.end(); ++code) {
+                V* group = nullptr;
+                for (auto t : all) {
+                   if (!t->used[code]) continue;
+                   if (group) {
+                      merge(*group, t->values[code]);
+                      continue;
+                   }
+                   auto key = runtime::PackedKey<K>::key(code);
+                   localEntries.emplace_back(ht.hash(key), key,
+                                             t->values[code]);
+                   group = &localEntries.back().v;
+                }
+             }
+             if (!localEntries.empty()) consume(localEntries);
+          });
+   }
+
+   template <typename C> void forallGroups(C consume, std::false_type) {
+      auto count = localGroupCount();
+      if (count <= runtime::singlePhaseGroupLimit)
+         return mergeLocalGroups(consume, count);
 
       spillAll();
 
@@ -162,7 +344,7 @@ class GroupBy {
                             maxFill = this->grow(ht, localEntries);
                          }
                       });
-                  update(*group, value->v);
+                  merge(*group, value->v);
                }
             }
          }
@@ -178,3 +360,83 @@ GroupBy<K, V, HASH, UPDATE> make_GroupBy(UPDATE u, V i,
                                                size_t nrThreads) {
    return std::move(GroupBy<K, V, HASH, UPDATE>(u, i, nrThreads));
 }
+
+template <typename K, typename V, typename HASH, typename UPDATE>
+class PartialGroupBy
+/// Thread local partial aggregation, e.g. below a join (eager aggregation).
+/// Groups are passed on when the local hashtable is full and when Locals are
+/// destroyed, e.g. at the end of a morsel. There is no global aggregation, a
+/// key may be passed on several times and its partial aggregates have to be
+/// merged later on with merge(), e.g. in a GroupBy above the join.
+{
+   runtime::thread_specific<runtime::Hashmapx<K, V, HASH, false>> groups;
+
+ public:
+   using group_t = typename decltype(groups)::value_type::Entry;
+
+ private:
+   runtime::thread_specific<runtime::Stack<group_t>> entries;
+
+   UPDATE update;
+   V init;
+
+ public:
+   PartialGroupBy(UPDATE u, V i) : update(u), init(i) {}
+
+   PartialGroupBy(const PartialGroupBy& g) = delete;
+   PartialGroupBy(PartialGroupBy&& g) = default;
+
+   /// Thread local state, passes groups on to pass(key, partialAggregate)
+   template <typename PASS> class Locals {
+      PartialGroupBy& parent;
+      runtime::Hashmapx<K, V, HASH, false>& groups;
+      runtime::Stack<group_t>& entries;
+      size_t maxFill;
+      PASS pass;
+
+      void flush() {
+         for (auto block : entries)
+            for (auto& entry : block) pass(entry.k, entry.v);
+         groups.clear();
+         entries.clear();
+      }
+
+    public:
+      Locals(PartialGroupBy& p, runtime::Hashmapx<K, V, HASH, false>& g,
+             runtime::Stack<group_t>& e, size_t m, PASS cb)
+          : parent(p), groups(g), entries(e), maxFill(m), pass(cb) {}
+      ~Locals() { flush(); }
+
+      /// consume key and value
+      template <typename KEY, typename VALUE>
+      inline void consume(KEY&& key, VALUE&& value) {
+         auto hash = groups.hash(key);
+         auto group = groups.findOrCreate(key, hash, parent.init, entries,
+                                          [&]() {
+                                             if (groups.size() >= maxFill)
+                                                flush();
+                                          });
+         parent.update(*group, std::forward<VALUE>(value));
+      }
+   };
+
+   /// Create thread local state for partial aggregation
+   template <typename PASS> Locals<PASS> locals(PASS pass) {
+      bool exists = false;
+      auto& g = groups.local(exists);
+      size_t maxFill;
+      if (!exists)
+         maxFill = g.setSize(1024);
+      else
+         maxFill = g.capacity * 0.7;
+      return Locals<PASS>(*this, g, entries.local(), maxFill, pass);
+   }
+
+   /// function which merges the partial aggregates
+   auto merge() const { return aggregates::mergeOf(update); }
+};
+
+template <typename K, typename V, typename HASH, typename UPDATE>
+PartialGroupBy<K, V, HASH, UPDATE> make_PartialGroupBy(UPDATE u, V i) {
+   return PartialGroupBy<K, V, HASH, UPDATE>(u, i);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "common/runtime/Concurrency.hpp"
+#include "common/runtime/Hashmap.hpp"
+#include "common/runtime/Stack.hpp"
+#include "tbb/tbb.h"
+#include <x86intrin.h>
+
+template <typename K, typename V, typename A, typename HASH>
+class GroupJoin
+/// Join with unique build keys, where probe tuples are aggregated into the
+/// build entry of their join partner (groupjoin). Replaces a join followed by
+/// a group by on the join key, the group by needs no hash table of its own.
+{
+ public:
+   struct Group {
+      /// build payload
+      V v;
+      /// aggregate of all join partners
+      A a;
+      /// spin lock for updates of a
+      uint8_t lock;
+      /// set if group has at least one join partner
+      uint8_t matched;
+   };
+   using ht_t = runtime::Hashmapx<K, Group, HASH>;
+   using group_t = typename ht_t::Entry;
+
+ private:
+   ht_t ht;
+   /// Memory for materialized build entries
+   runtime::thread_specific<runtime::Stack<group_t>> entries;
+
+   A init;
+
+ public:
+   GroupJoin(A i) : init(i) {}
+
+   GroupJoin(const GroupJoin& g) = delete;
+
+   inline void build(const K& key, const V& value)
+   /// materialize a build tuple, thread safe
+   {
+      entries.local().emplace_back(ht.hash(key), key,
+                                   Group{value, init, 0, 0});
+   }
+
+   void finishBuild()
+   /// insert all build tuples into the hash table
+   {
+      size_t n = 0;
+      for (auto& e : entries) n += e.size();
+      ht.setSize(n);
+      auto all = entries.elements();
+      tbb::parallel_for(size_t(0), all.size(),
+                        [&](size_t i) { ht.insertAll(*all[i]); });
+   }
+
+   template <typename UPDATE> inline bool probe(const K& key, UPDATE update)
+   /// update the aggregate of the group of key with update(aggregate), thread
+   /// safe. Returns false if key has no join partner
+   {
+      auto group = ht.findOne(key);
+      if (!group) return false;
+      while (__atomic_exchange_n(&group->lock, 1, __ATOMIC_ACQUIRE))
+         // wait for the holder without writing the contended line
+         while (__atomic_load_n(&group->lock, __ATOMIC_RELAXED)) _mm_pause();
+      update(group->a);
+      group->matched = 1;
+      __atomic_store_n(&group->lock, 0, __ATOMIC_RELEASE);
+      return true;
+   }
+
+   template <typename C> inline void forallGroups(C consume)
+   /// calls consume for each thread's build entries in parallel. Only entries
+   /// with group.v.matched set had a join partner
+   {
+      auto all = entries.elements();
+      tbb::parallel_for(size_t(0), all.size(),
+                        [&](size_t i) { consume(*all[i]); });
+   }
+};
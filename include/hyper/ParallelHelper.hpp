@@ -1,4 +1,6 @@
 #include "common/runtime/Query.hpp"
+#include "common/runtime/ReadAhead.hpp"
+#include "common/runtime/Scheduler.hpp"
 #include <deque>
 #include <tbb/tbb.h>
 
@@ -7,6 +9,16 @@ static const size_t morselSize = 10000;
 struct ProcessingResources {
    std::vector<runtime::Worker> workers;
    std::unique_ptr<runtime::Query> query;
+
+   ProcessingResources() = default;
+   ProcessingResources(ProcessingResources&&) = default;
+   /// leaves the query if the query function did not, e.g. because a morsel
+   /// threw QueryCancelled
+   ~ProcessingResources() {
+      if (!workers.empty()) leave();
+   }
+   /// restores the worker pointers of the threads which joined the query
+   inline void leave();
 };
 
 inline ProcessingResources initQuery(size_t nrThreads) {
@@ -28,46 +40,63 @@ inline ProcessingResources initQuery(size_t nrThreads) {
    return r;
 }
 
-inline void leaveQuery(size_t nrThreads) {
-   runtime::Barrier b(nrThreads);
-   tbb::parallel_for(size_t(0), nrThreads, size_t(1), [&](auto) {
-      // reset thread local worker pointer
-      runtime::this_worker = runtime::this_worker->previousWorker;
+inline void ProcessingResources::leave() {
+   // the query is done writing its result
+   if (query) query->result->finalize();
+   auto first = workers.data(), last = first + workers.size();
+   runtime::Barrier b(workers.size());
+   tbb::parallel_for(size_t(0), workers.size(), size_t(1), [&](auto) {
+      // reset thread local worker pointer, if this thread joined the query
+      auto w = runtime::this_worker;
+      if (w >= first && w < last) runtime::this_worker = w->previousWorker;
       b.wait();
    });
+   workers.clear();
 }
 
+/// leaves the query of resources, afterwards the threads use their previous
+/// workers again
+inline void leaveQuery(ProcessingResources& resources) { resources.leave(); }
+
+/// pipelines over base tables run on the morsel-driven scheduler, with the
+/// resources of the query of the calling thread
 #define PARALLEL_SCAN(N, ENTRIES, BLOCK)                                       \
-   tbb::parallel_for(tbb::blocked_range<size_t>(0, N, morselSize),             \
-                     [&](const tbb::blocked_range<size_t>& r) {                \
-                        auto& entries = ENTRIES.local();                       \
-                        for (auto i = r.begin(), end = r.end(); i != end; ++i) \
-                           BLOCK                                               \
-                     })
+   runtime::Scheduler::global().parallelFor(                                   \
+       N, morselSize, [&](size_t begin, size_t end) {                          \
+          auto& entries = ENTRIES.local();                                     \
+          for (auto i = begin; i != end; ++i) BLOCK                            \
+       })
 
 template <typename E, typename L>
 void parallel_scan(size_t n, E& entriesGlobal, L& cb) {
-   tbb::parallel_for(tbb::blocked_range<size_t>(0, n, morselSize),
-                     [&](const tbb::blocked_range<size_t>& r) {
-                        auto& entries = entriesGlobal.local();
-                        for (auto i = r.begin(), end = r.end(); i != end; ++i)
-                           cb(i, entries);
-                     });
+   runtime::Scheduler::global().parallelFor(
+       n, morselSize, [&](size_t begin, size_t end) {
+          auto& entries = entriesGlobal.local();
+          for (auto i = begin; i != end; ++i) cb(i, entries);
+       });
 }
 
+/// PARALLEL_SELECT which reads the columns of ReadAhead* AHEAD ahead of its
+/// morsels
+#define PARALLEL_SELECT_AHEAD(N, AHEAD, ENTRIES, BLOCK)                        \
+   [&]() {                                                                     \
+      std::atomic<size_t> selected(0);                                         \
+      runtime::Scheduler::global().parallelFor(                                \
+          N, morselSize, [&](size_t begin, size_t end) {                       \
+             runtime::ReadAhead::advance(AHEAD, begin);                        \
+             auto& entries = ENTRIES.local();                                  \
+             size_t found = 0;                                                 \
+             for (size_t i = begin; i != end; ++i) BLOCK                       \
+             selected += found;                                                \
+          });                                                                  \
+      return selected.load();                                                  \
+   }()
+
 #define PARALLEL_SELECT(N, ENTRIES, BLOCK)                                     \
-   tbb::parallel_reduce(                                                       \
-       tbb::blocked_range<size_t>(0, N, morselSize), 0,                        \
-       [&](const tbb::blocked_range<size_t>& r, const size_t& f) {             \
-          auto& entries = ENTRIES.local();                                     \
-          auto found = f;                                                      \
-          for (size_t i = r.begin(), end = r.end(); i != end; ++i) BLOCK       \
-          return found;                                                        \
-       },                                                                      \
-       [](const size_t& a, const size_t& b) { return a + b; })
+   PARALLEL_SELECT_AHEAD(N, nullptr, ENTRIES, BLOCK)
 
 template <typename E, typename HT> void parallel_insert(E& entries, HT& ht) {
-   tbb::parallel_for(entries.range(), [&ht](const auto& r) {
-      for (auto& entries : r) ht.insertAll(entries);
-   });
+   auto all = entries.elements();
+   tbb::parallel_for(size_t(0), all.size(),
+                     [&](size_t i) { ht.insertAll(*all[i]); });
 }
@@ -1,4 +1,5 @@
 #include "common/Compat.hpp"
+#include "common/runtime/MemoryAccount.hpp"
 #include <cstdlib>
 #include <cstring>
 #include <functional>
@@ -277,6 +278,10 @@ void PerfEvents::timeAndProfile(std::string s, uint64_t count,
 
    uint64_t memStart = 0;
    if (mem) memStart = getCurrentRSS();
+   // peak of the memory reserved by queries, above what is kept between runs
+   auto& memory = runtime::MemoryAccount::process();
+   memory.resetPeak();
+   auto memBase = memory.used();
    startAll();
    double start = gettime();
    size_t performedRep = 0;
@@ -291,6 +296,7 @@ void PerfEvents::timeAndProfile(std::string s, uint64_t count,
    if (writeHeader) {
       std::cout << setw(20) << "name"
                 << "," << setw(printFieldWidth) << " time"
+                << "," << setw(printFieldWidth) << " peak MB"
                 << "," << setw(printFieldWidth) << " CPUs"
                 << "," << setw(printFieldWidth) << " IPC"
                 << "," << setw(printFieldWidth) << " GHz"
@@ -303,6 +309,8 @@ void PerfEvents::timeAndProfile(std::string s, uint64_t count,
    auto runtime = end - start;
    std::cout << setw(20) << s << "," << setw(printFieldWidth)
              << (runtime * 1e3 / performedRep) << ",";
+   std::cout << setw(printFieldWidth)
+             << (memory.peak() - memBase) / (1024.0 * 1024) << ",";
 #ifdef __linux__
    if (!getenv("EXTERNALPROFILE")) {
       std::cout << setw(printFieldWidth)
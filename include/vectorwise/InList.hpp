@@ -0,0 +1,128 @@
+#pragma once
+#include "common/runtime/Hash.hpp"
+#include "common/runtime/Types.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vectorwise {
+
+template <typename T> struct InListKey
+/// maps values to a dense integer domain, if the type has one
+{
+   static const bool dense = false;
+   static int64_t get(const T&) { return 0; }
+};
+template <> struct InListKey<int8_t> {
+   static const bool dense = true;
+   static int64_t get(const int8_t& v) { return v; }
+};
+template <> struct InListKey<int16_t> {
+   static const bool dense = true;
+   static int64_t get(const int16_t& v) { return v; }
+};
+template <> struct InListKey<int32_t> {
+   static const bool dense = true;
+   static int64_t get(const int32_t& v) { return v; }
+};
+template <> struct InListKey<int64_t> {
+   static const bool dense = true;
+   static int64_t get(const int64_t& v) { return v; }
+};
+template <> struct InListKey<types::Date> {
+   static const bool dense = true;
+   static int64_t get(const types::Date& v) { return v.value; }
+};
+
+template <typename T>
+class InList
+/// constant list for IN predicates, used as value parameter of the
+/// sel_in primitives. Small lists are compared constant by constant against
+/// a chunk of the input (with AVX-512 registers in the sel_in_*_avx512
+/// primitives), larger lists are probed in a bitmap (dense integer domains)
+/// or an open addressing hash set.
+{
+ public:
+   /// lists up to this size are compared constant by constant
+   static const size_t smallLimit = 8;
+   /// maximal number of bits spent on a bitmap, per list element
+   static const size_t bitsPerElement = 64;
+
+   std::vector<T> values;
+
+ private:
+   std::vector<uint64_t> bitmap;
+   int64_t bitmapMin = 0;
+   uint64_t bitmapRange = 0;
+
+   std::vector<T> slots;
+   std::vector<uint8_t> used;
+   uint64_t mask = 0;
+
+   static uint64_t hashOf(const T& v) {
+      return runtime::MurMurHash()(v, defs::hash_t(0x5bd1e995));
+   }
+
+ public:
+   InList() = default;
+   InList(std::vector<T> v) { set(std::move(v)); }
+
+   void set(std::vector<T> v)
+   /// set the list of constants and build the lookup structure for it
+   {
+      values = std::move(v);
+      bitmap.clear();
+      bitmapRange = 0;
+      slots.clear();
+      used.clear();
+      if (isSmall()) return;
+      if (InListKey<T>::dense) {
+         int64_t min = std::numeric_limits<int64_t>::max();
+         int64_t max = std::numeric_limits<int64_t>::min();
+         for (auto& e : values) {
+            min = std::min(min, InListKey<T>::get(e));
+            max = std::max(max, InListKey<T>::get(e));
+         }
+         // max - min + 1 wraps to 0 for lists spanning the whole domain
+         uint64_t span = uint64_t(max) - uint64_t(min);
+         if (span < values.size() * bitsPerElement) {
+            uint64_t range = span + 1;
+            bitmapMin = min;
+            bitmapRange = range;
+            bitmap.assign((range + 63) / 64, 0);
+            for (auto& e : values) {
+               uint64_t bit = uint64_t(InListKey<T>::get(e)) - uint64_t(min);
+               bitmap[bit / 64] |= uint64_t(1) << (bit % 64);
+            }
+            return;
+         }
+      }
+      size_t capacity = 16;
+      while (capacity < values.size() * 2) capacity *= 2;
+      mask = capacity - 1;
+      slots.resize(capacity);
+      used.assign(capacity, 0);
+      for (auto& e : values) {
+         auto pos = hashOf(e) & mask;
+         while (used[pos] && !(slots[pos] == e)) pos = (pos + 1) & mask;
+         slots[pos] = e;
+         used[pos] = 1;
+      }
+   }
+
+   inline bool isSmall() const { return values.size() <= smallLimit; }
+
+   inline bool contains(const T& v) const
+   /// membership test for lists that are not small
+   {
+      if (bitmapRange) {
+         uint64_t bit = uint64_t(InListKey<T>::get(v)) - uint64_t(bitmapMin);
+         return bit < bitmapRange && ((bitmap[bit / 64] >> (bit % 64)) & 1);
+      }
+      for (auto pos = hashOf(v) & mask; used[pos]; pos = (pos + 1) & mask)
+         if (slots[pos] == v) return true;
+      return false;
+   }
+};
+} // namespace vectorwise
@@ -182,4 +182,19 @@ struct F4_Op : public Op
          operation(o) {}
    virtual pos_t run(pos_t n) override;
 };
+
+struct F5_Op : public Op
+/// selection with input select and three params
+{
+   void* inputSelectionV;
+   void* outputSelectionV;
+   void* param1;
+   void* param2;
+   void* param3;
+   primitives::F5 operation;
+   F5_Op(void* in, void* out, void* p1, void* p2, void* p3, primitives::F5 o)
+       : inputSelectionV(in), outputSelectionV(out), param1(p1), param2(p2),
+         param3(p3), operation(o) {}
+   virtual pos_t run(pos_t n) override;
+};
 }
@@ -5,7 +5,9 @@
 #include "common/runtime/Database.hpp"
 #include "common/runtime/Hashmap.hpp"
 #include "common/runtime/PartitionedDeque.hpp"
+#include "common/runtime/PreAggregation.hpp"
 #include "common/runtime/Query.hpp"
+#include "common/runtime/ReadAhead.hpp"
 #include "vectorwise/Primitives.hpp"
 #include <atomic>
 #include <cstdint>
@@ -69,18 +71,27 @@ class SharedState
 class SharedStateManager {
    std::mutex m;
    std::unordered_map<size_t, std::unique_ptr<SharedState>> state;
+   /// states with small ids, readable without the lock
+   static constexpr size_t nrCached = 64;
+   std::atomic<SharedState*> cached[nrCached];
    std::atomic<size_t> oncesExecuted;
    std::mutex onceMutex;
 
  public:
-   SharedStateManager() : oncesExecuted(0) {}
+   SharedStateManager() : oncesExecuted(0) {
+      for (auto& c : cached) c = nullptr;
+   }
    template <typename T> T& get(size_t i) {
-      std::lock_guard<std::mutex> lock(m);
-      auto s = state.find(i);
-      if (s == state.end()) {
-         s = state.insert(std::make_pair(i, move(std::make_unique<T>()))).first;
+      SharedState* shared =
+          i < nrCached ? cached[i].load(std::memory_order_acquire) : nullptr;
+      if (!shared) {
+         std::lock_guard<std::mutex> lock(m);
+         auto& s = state[i];
+         if (!s) s = std::make_unique<T>();
+         shared = s.get();
+         if (i < nrCached) cached[i].store(shared, std::memory_order_release);
       }
-      T* res = dynamic_cast<T*>(s->second.get());
+      T* res = dynamic_cast<T*>(shared);
       if (!res)
          throw std::runtime_error(
              "Failed to retrieve shared state. Wrong type found.");
@@ -140,6 +151,9 @@ class Scan : public Operator {
  public:
    struct Shared : public SharedState {
       std::atomic<size_t> pos;
+      /// read ahead of the scanned columns, created by the first worker
+      std::unique_ptr<runtime::ReadAhead> readAhead;
+      std::once_flag readAheadOnce;
       Shared() : pos(0){};
    };
 
@@ -155,10 +169,16 @@ class Scan : public Operator {
    std::vector<std::pair<void**, size_t>> consumers;
 
  public:
+   /// attributes of the consumed columns, read ahead if enabled
+   std::vector<runtime::Attribute*> columns;
+
    Scan(Shared& sm, size_t nrTuples, size_t vecSize);
    /// Add consumer to scan operator, typeSize is size of
    /// type pointed to by colPtr
    void addConsumer(void** colPtr, size_t typeSize);
+   /// Row id of the first tuple in the current vector, used to fetch late
+   /// materialized columns
+   size_t* currentOffset() { return &lastOffset; }
    virtual size_t next() override;
 };
 
@@ -188,10 +208,31 @@ class ResultWriter : public UnaryOperator {
 
 class Hashjoin : public BinaryOperator {
  public:
+   /// Semantics of the join
+   enum class Mode {
+      /// all matching pairs
+      Inner,
+      /// probe tuples with at least one match
+      Semi,
+      /// probe tuples without match
+      Anti,
+      /// all matching pairs and probe tuples without match, the latter with
+      /// zeroed build values
+      LeftOuter,
+      /// all probe tuples, marker tells if a match exists
+      Mark,
+      /// groupjoin: probe tuples are aggregated into their matching build
+      /// entry, produces the build entries with at least one match after the
+      /// probe side is consumed. Build keys must be unique
+      Group
+   };
+
    struct Shared : public SharedState {
       std::atomic<size_t> found;
       std::atomic<bool> sizeIsSet;
       runtime::Hashmap ht;
+      /// memory reserved by all threads of this join
+      runtime::MemoryAccount memory;
       Shared() : found(0), sizeIsSet(false){};
    };
 
@@ -216,6 +257,38 @@ class Hashjoin : public BinaryOperator {
    } contCon;
    bool consumed = false;
    std::vector<std::pair<void*, size_t>> allocations;
+   /// next probe to check for an outer result in current probe vector
+   pos_t outerNext = 0;
+   /// zeroed ht entry, build side of outer results
+   runtime::Hashmap::EntryHeader* nullEntry = nullptr;
+
+   /// position of i-th probe in the probe side vectors
+   inline pos_t probePos(pos_t i) { return probeSel ? probeSel[i] : i; }
+   /// sets probeMatched (and firstMatch, if present) for all probes of the
+   /// current probe vector by walking the hash chains in rounds. A probe
+   /// leaves after its first key match.
+   void findFirstMatches();
+   /// emits probes without match of the current probe vector
+   pos_t joinOuterRest();
+   /// probe side is consumed by a groupjoin
+   bool probed = false;
+   /// next ht entry of this thread to emit as group, as allocation and entry
+   /// in the allocation
+   size_t nextAllocation = 0;
+   size_t nextEntry = 0;
+   /// aggregates all probe tuples, then emits the matched build entries of
+   /// this thread in batches
+   size_t nextGroup();
+   /// inner, semi and group joins have no result when build side is empty
+   bool needsMatch() const;
+   /// hash table is empty and the join has no result
+   bool empty = false;
+   /// build phase 1: materializes the ht entries of the build side
+   void materialize();
+   /// build phase 2: inserts the ht entries materialized by this thread
+   void insert();
+   /// builds the hash tables of this join and of its concurrent builds
+   void build();
 
  public:
    size_t followupBufferSize = 1025;
@@ -234,8 +307,30 @@ class Hashjoin : public BinaryOperator {
    Expression probeHash;
    runtime::Hashmap::hash_t* probeHashes;
    Expression keyEquality;
+   /// lookups of probe side positions pushed into the join, evaluated on the
+   /// key checked join result
+   Expression probeLookup;
    pos_t* probeSel = nullptr;
    pos_t* probeMatches;
+   Mode mode = Mode::Inner;
+   /// per probe position, set if a join partner was found
+   uint8_t* probeMatched = nullptr;
+   /// per probe position, the matching build entry, for unique build keys
+   runtime::Hashmap::EntryHeader** firstMatch = nullptr;
+   /// build keys are declared unique, joinUnique produces the pairs
+   bool uniqueBuildKeys = false;
+   /// per output tuple of mark and left outer joins, set if tuple has a match
+   uint8_t* marker = nullptr;
+   /// updates aggregates in buildMatches with the probes in probeMatches,
+   /// for groupjoins
+   Aggregates probeAggregates;
+   /// offset of a byte in ht entries of groupjoins, set if entry has a match
+   size_t groupMatchedOffset;
+   /// joins with independent build pipelines, including this one, which are
+   /// built together by the first of them that is pulled: threads move on to
+   /// the next build side instead of waiting, the hash tables are sized and
+   /// filled behind a single pair of barriers. Empty if built on its own
+   std::vector<Hashjoin*> concurrentBuilds;
 
    /// function which computes join result into buildMatches and probeMatches
    pos_t (Hashjoin::*join)();
@@ -260,6 +355,19 @@ class Hashjoin : public BinaryOperator {
    /// selection vector probeSel for probe side
    /// Implementation: For SkylakeX using AVX512
    pos_t joinSelSIMD();
+   /// computes semi join result into probeMatches, stops chain traversal at
+   /// first match, respects probeSel if set
+   pos_t joinSemi();
+   /// computes anti join result into probeMatches, stops chain traversal at
+   /// first match, respects probeSel if set
+   pos_t joinAnti();
+   /// writes all probes into probeMatches and sets marker if a match exists,
+   /// stops chain traversal at first match, respects probeSel if set
+   pos_t joinMark();
+   /// computes join result for unique build keys into probeMatches and
+   /// buildMatches, at most one match per probe. Stops chain traversal at
+   /// first match and needs no continuation, respects probeSel if set
+   pos_t joinUnique();
 
    virtual size_t next() override;
    ~Hashjoin();
@@ -282,8 +390,14 @@ class HashGroup : public UnaryOperator {
 
    struct Shared : SharedState {
       std::atomic<size_t> partition;
+      /// number of groups spilled by all threads in phase 1
+      std::atomic<size_t> spilledGroups;
       runtime::thread_specific<deque_t> spillStorage;
-      Shared() : partition(0) {}
+      /// partition numbers, largest partitions first
+      std::vector<size_t> partitionOrder;
+      /// memory reserved by all threads of this aggregation
+      runtime::MemoryAccount memory;
+      Shared() : partition(0), spilledGroups(0) {}
    } & shared;
 
    HashGroup(Shared& shared);
@@ -334,7 +448,12 @@ class HashGroup : public UnaryOperator {
 
       /// ------ group creation
       /// Creates missing groups. Returns number of groups created.
-      size_t createMissingGroups(decltype(ht) & ht, bool allowResize = false);
+      size_t createMissingGroups(decltype(ht) & ht, bool allowResize = false,
+                                 bool insert = true);
+      /// Creates one group per distinct key of the first n tuples without
+      /// looking up or inserting into the hashtable. Returns number of groups
+      /// created.
+      size_t createVectorGroups(pos_t n, decltype(ht) & ht);
       /// Expression to execute partitioning on groupsNotFound
       Expression partitionKeys;
       /// Expression to scatter
@@ -380,33 +499,55 @@ class HashGroup : public UnaryOperator {
    ColumnGroupLookup preAggregation;
    /// update aggregates
    Aggregates updateGroups;
+   /// switches pre-aggregation off for inputs with little key locality
+   runtime::AdaptivePreAggregation adaptivity;
 
    /// ------ phase 2: global aggregation
    RowGroupLookup globalAggregation;
    pos_t findGroupsFromPartition(void* data, size_t n);
    Aggregates updateGroupsFromPartition;
+   /// aggregate partition partNr of all threads into ht
+   void aggregatePartition(size_t partNr);
 
    /// ------ produce result
    /// Gather primitives to produce vectors after
    /// global grouping is done
    Aggregates gatherGroups;
+   /// groups of small blocks are collected here to fill result vectors
+   void* resultBuffer = nullptr;
 
    struct Continuation
    /// state for control flow
    {
       decltype(globalAggregation.allocations.begin()) iter;
+      /// groups of the block at iter which are already passed on
+      size_t blockPos = 0;
+      /// index into shared.partitionOrder
       decltype(nrPartitions) partition = 0;
       /// Is the input to this operator already consumed?
       bool consumed = false;
       /// Does the current partition need aggregation or can the result already
       /// be passed on to the next iterator?
       bool partitionNeedsAggregation = true;
+      /// Few groups were spilled, aggregate all partitions at once in a
+      /// single worker
+      bool singlePhase = false;
+      /// next block of preAggregation.allocations to pass on, partial only
+      size_t partialBlock = 0;
    } cont;
 
+   /// Partial aggregation, e.g. below a join (eager aggregation). Groups of
+   /// the thread local hashtable are passed on whenever it is full, there is
+   /// no global aggregation. A group may occur several times in the output and
+   /// needs to be merged by an aggregation later on.
+   bool partial = false;
+
    virtual size_t next() override;
 
  private:
    void clearHashtable();
+   /// next for partial aggregation
+   size_t nextPartial();
 };
 
 template <typename T>
@@ -485,7 +626,7 @@ void HashGroup::GroupLookup<T>::getGroupRepresentatives(pos_t nrGroups,
 
 template <typename T>
 size_t INTERPRET_SEPARATE HashGroup::GroupLookup<T>::createMissingGroups(
-    runtime::Hashmap& ht, bool allowResize) {
+    runtime::Hashmap& ht, bool allowResize, bool insert) {
    auto n = groupsNotFound->size();
    if (!n) return 0;
    // find groups
@@ -505,7 +646,9 @@ size_t INTERPRET_SEPARATE HashGroup::GroupLookup<T>::createMissingGroups(
    buildScatter.evaluate(groups);
    using header_t = runtime::Hashmap::EntryHeader;
    // insert groups into ht
-   if (allowResize && entries_in_ht > parent.maxFill) {
+   if (!insert) {
+      // groups are spilled right away, without hashtable
+   } else if (allowResize && entries_in_ht > parent.maxFill) {
       // clear hashtable and prepare it for new size
       parent.maxFill = ht.setSize(entries_in_ht * 2);
       // reinsert all entries
@@ -530,6 +673,14 @@ size_t INTERPRET_SEPARATE HashGroup::GroupLookup<T>::createMissingGroups(
    return groups;
 }
 
+template <typename T>
+size_t HashGroup::GroupLookup<T>::createVectorGroups(pos_t n,
+                                                    runtime::Hashmap& ht) {
+   groupsNotFound->clear();
+   for (pos_t i = 0; i < n; ++i) groupsNotFound->push_back(i);
+   return createMissingGroups(ht, false, false);
+}
+
 template <typename T>
 void INTERPRET_SEPARATE
 HashGroup::GroupLookup<T>::clearHashtable(runtime::Hashmap& ht) {
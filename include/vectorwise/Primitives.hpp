@@ -2,10 +2,13 @@
 #include "common/defs.hpp"
 #include "common/runtime/HashmapSmall.hpp"
 #include "common/runtime/SIMD.hpp"
+#include "common/runtime/StringSearch.hpp"
 #include "common/runtime/Types.hpp"
 #include "common/runtime/Util.hpp"
+#include "vectorwise/InList.hpp"
 #include "vectorwise/VectorAllocator.hpp"
 #include "vectorwise/defs.hpp"
+#include <limits>
 #include <unordered_map>
 // #include "/home/kersten/tools/iaca-lin64/iacaMarks.h"
 
@@ -137,6 +140,284 @@ pos_t selsel_col_col_bf(pos_t n, pos_t* RES inSel, pos_t* RES result,
    return result - rStart;
 }
 
+//------------------------------------------------------------------------------
+//--- range selection templates
+template <typename T> struct between
+/// lower <= value <= upper
+{
+   bool operator()(const T& v, const T& lower, const T& upper) {
+      return (v >= lower) & (v <= upper);
+   }
+};
+
+template <typename T> struct between_halfopen
+/// lower <= value < upper
+{
+   bool operator()(const T& v, const T& lower, const T& upper) {
+      return (v >= lower) & (v < upper);
+   }
+};
+
+template <typename T, template <typename> class Op>
+pos_t sel_col_range(pos_t n, pos_t* RES result, T* RES param1, T* RES param2,
+                    T* RES param3)
+/// select with column and lower and upper bound in a single pass
+{
+   uint64_t found = 0;
+   const auto lower = *param2;
+   const auto upper = *param3;
+   for (uint64_t i = 0; i < n; ++i)
+      if (Op<T>()(param1[i], lower, upper)) result[found++] = i;
+   return found;
+}
+
+template <typename T, template <typename> class Op>
+pos_t selsel_col_range(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                       T* RES param1, T* RES param2, T* RES param3)
+/// select with input selection vector, column and lower and upper bound
+{
+   uint64_t found = 0;
+   const auto lower = *param2;
+   const auto upper = *param3;
+   for (uint64_t i = 0; i < n; ++i) {
+      const auto idx = inSel[i];
+      if (Op<T>()(param1[idx], lower, upper)) result[found++] = idx;
+   }
+   return found;
+}
+
+template <typename T, template <typename> class Op>
+pos_t sel_col_range_bf(pos_t n, pos_t* RES result, T* RES param1,
+                       T* RES param2, T* RES param3)
+/// select with column and lower and upper bound in a single pass
+{
+   const auto lower = *param2;
+   const auto upper = *param3;
+   auto rStart = result;
+   for (uint64_t i = 0; i < n; ++i) {
+      bool decision = Op<T>()(param1[i], lower, upper);
+      *result = i;
+      result += decision;
+   }
+   return result - rStart;
+}
+
+template <typename T, template <typename> class Op>
+pos_t selsel_col_range_bf(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                          T* RES param1, T* RES param2, T* RES param3)
+/// select with input selection vector, column and lower and upper bound
+{
+   const auto lower = *param2;
+   const auto upper = *param3;
+   auto rStart = result;
+   for (uint64_t i = 0; i < n; ++i) {
+      const auto idx = inSel[i];
+      bool decision = Op<T>()(param1[idx], lower, upper);
+      *result = idx;
+      result += decision;
+   }
+   return result - rStart;
+}
+
+//------------------------------------------------------------------------------
+//--- IN-list selection templates
+/// number of rows a small IN-list is compared against at once
+const uint64_t inChunk = 64;
+
+template <typename T>
+inline void in_broadcast(uint64_t n, T* RES input, const InList<T>& list,
+                         bool* RES match)
+/// compare each constant of a small list against a chunk of the input
+{
+   for (uint64_t j = 0; j < n; ++j) match[j] = false;
+   for (const auto& con : list.values)
+      for (uint64_t j = 0; j < n; ++j) match[j] |= input[j] == con;
+}
+
+template <typename T>
+inline void in_broadcast_sel(uint64_t n, pos_t* RES inSel, T* RES input,
+                             const InList<T>& list, bool* RES match)
+/// compare each constant of a small list against a chunk of the input
+{
+   for (uint64_t j = 0; j < n; ++j) match[j] = false;
+   for (const auto& con : list.values)
+      for (uint64_t j = 0; j < n; ++j) match[j] |= input[inSel[j]] == con;
+}
+
+template <typename T>
+pos_t sel_col_in(pos_t n, pos_t* RES result, T* RES param1,
+                 InList<T>* RES param2)
+/// select with column and list of constants
+{
+   const auto& list = *param2;
+   uint64_t found = 0;
+   if (list.isSmall()) {
+      bool match[inChunk];
+      for (uint64_t i = 0; i < n; i += inChunk) {
+         const auto m = std::min(inChunk, n - i);
+         in_broadcast(m, param1 + i, list, match);
+         for (uint64_t j = 0; j < m; ++j)
+            if (match[j]) result[found++] = i + j;
+      }
+   } else
+      for (uint64_t i = 0; i < n; ++i)
+         if (list.contains(param1[i])) result[found++] = i;
+   return found;
+}
+
+template <typename T>
+pos_t selsel_col_in(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                    T* RES param1, InList<T>* RES param2)
+/// select with input selection vector, column and list of constants
+{
+   const auto& list = *param2;
+   uint64_t found = 0;
+   if (list.isSmall()) {
+      bool match[inChunk];
+      for (uint64_t i = 0; i < n; i += inChunk) {
+         const auto m = std::min(inChunk, n - i);
+         in_broadcast_sel(m, inSel + i, param1, list, match);
+         for (uint64_t j = 0; j < m; ++j)
+            if (match[j]) result[found++] = inSel[i + j];
+      }
+   } else
+      for (uint64_t i = 0; i < n; ++i) {
+         const auto idx = inSel[i];
+         if (list.contains(param1[idx])) result[found++] = idx;
+      }
+   return found;
+}
+
+template <typename T>
+pos_t sel_col_in_bf(pos_t n, pos_t* RES result, T* RES param1,
+                    InList<T>* RES param2)
+/// select with column and list of constants
+{
+   const auto& list = *param2;
+   auto rStart = result;
+   if (list.isSmall()) {
+      bool match[inChunk];
+      for (uint64_t i = 0; i < n; i += inChunk) {
+         const auto m = std::min(inChunk, n - i);
+         in_broadcast(m, param1 + i, list, match);
+         for (uint64_t j = 0; j < m; ++j) {
+            *result = i + j;
+            result += match[j];
+         }
+      }
+   } else
+      for (uint64_t i = 0; i < n; ++i) {
+         bool decision = list.contains(param1[i]);
+         *result = i;
+         result += decision;
+      }
+   return result - rStart;
+}
+
+template <typename T>
+pos_t selsel_col_in_bf(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                       T* RES param1, InList<T>* RES param2)
+/// select with input selection vector, column and list of constants
+{
+   const auto& list = *param2;
+   auto rStart = result;
+   if (list.isSmall()) {
+      bool match[inChunk];
+      for (uint64_t i = 0; i < n; i += inChunk) {
+         const auto m = std::min(inChunk, n - i);
+         in_broadcast_sel(m, inSel + i, param1, list, match);
+         for (uint64_t j = 0; j < m; ++j) {
+            *result = inSel[i + j];
+            result += match[j];
+         }
+      }
+   } else
+      for (uint64_t i = 0; i < n; ++i) {
+         const auto idx = inSel[i];
+         bool decision = list.contains(param1[idx]);
+         *result = idx;
+         result += decision;
+      }
+   return result - rStart;
+}
+
+//------------------------------------------------------------------------------
+//--- LIKE selection templates
+template <typename T> struct like_prefix {
+   bool operator()(const T& str, const runtime::StringPattern& pattern) {
+      return pattern.prefixOf(str.value, str.len);
+   }
+};
+
+template <typename T> struct like_suffix {
+   bool operator()(const T& str, const runtime::StringPattern& pattern) {
+      return pattern.suffixOf(str.value, str.len);
+   }
+};
+
+template <typename T> struct like_contains {
+   bool operator()(const T& str, const runtime::StringPattern& pattern) {
+      return pattern.containedIn(str.value, str.len);
+   }
+};
+
+template <typename T, template <typename> class Op>
+pos_t sel_col_pattern(pos_t n, pos_t* RES result, T* RES param1,
+                      runtime::StringPattern* RES param2)
+/// select with string column and pattern
+{
+   uint64_t found = 0;
+   const auto& pattern = *param2;
+   for (uint64_t i = 0; i < n; ++i)
+      if (Op<T>()(param1[i], pattern)) result[found++] = i;
+   return found;
+}
+
+template <typename T, template <typename> class Op>
+pos_t selsel_col_pattern(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                         T* RES param1, runtime::StringPattern* RES param2)
+/// select with input selection vector, string column and pattern
+{
+   uint64_t found = 0;
+   const auto& pattern = *param2;
+   for (uint64_t i = 0; i < n; ++i) {
+      const auto idx = inSel[i];
+      if (Op<T>()(param1[idx], pattern)) result[found++] = idx;
+   }
+   return found;
+}
+
+template <typename T, template <typename> class Op>
+pos_t sel_col_pattern_bf(pos_t n, pos_t* RES result, T* RES param1,
+                         runtime::StringPattern* RES param2)
+/// select with string column and pattern
+{
+   const auto& pattern = *param2;
+   auto rStart = result;
+   for (uint64_t i = 0; i < n; ++i) {
+      bool decision = Op<T>()(param1[i], pattern);
+      *result = i;
+      result += decision;
+   }
+   return result - rStart;
+}
+
+template <typename T, template <typename> class Op>
+pos_t selsel_col_pattern_bf(pos_t n, pos_t* RES inSel, pos_t* RES result,
+                            T* RES param1, runtime::StringPattern* RES param2)
+/// select with input selection vector, string column and pattern
+{
+   const auto& pattern = *param2;
+   auto rStart = result;
+   for (uint64_t i = 0; i < n; ++i) {
+      const auto idx = inSel[i];
+      bool decision = Op<T>()(param1[idx], pattern);
+      *result = idx;
+      result += decision;
+   }
+   return result - rStart;
+}
+
 //------------------------------------------------------------------------------
 //--- projection templates
 template <typename T, template <typename> class Op>
@@ -311,6 +592,20 @@ pos_t aggr_sel_col(pos_t n, T* RES entries[], pos_t* selParam1, T* RES param1,
    return n;
 }
 
+template <typename T>
+pos_t aggr_sel_atomic_plus_col(pos_t n, T* RES entries[], pos_t* selParam1,
+                               T* RES param1, size_t offset)
+/// add param1 with selection vector into aggregators given by result. The
+/// aggregators are shared between threads, e.g. the build entries of a
+/// groupjoin, and are updated atomically
+{
+   for (uint64_t i = 0; i < n; ++i) {
+      auto aggregate = addBytes(entries[i], offset);
+      __atomic_fetch_add(aggregate, param1[selParam1[i]], __ATOMIC_RELAXED);
+   }
+   return n;
+}
+
 template <typename T, template <typename> class Op>
 pos_t aggr_row(pos_t n, T* RES entries[], size_t offset, T** RES dataPtr,
                size_t* inSizePtr, size_t inOffset)
@@ -326,6 +621,14 @@ pos_t aggr_row(pos_t n, T* RES entries[], size_t offset, T** RES dataPtr,
    return n;
 }
 
+/// aggregation operations for min and max, used like std::plus
+template <typename T> struct minimum {
+   T operator()(const T& a, const T& b) const { return a < b ? a : b; }
+};
+template <typename T> struct maximum {
+   T operator()(const T& a, const T& b) const { return a < b ? b : a; }
+};
+
 template <typename T, template <typename> class Op> struct OpTraits;
 template <typename T> struct OpTraits<T, std::plus> {
    static const T neutral = 0;
@@ -342,6 +645,12 @@ template <typename T> struct OpTraits<T, std::divides> {
 template <typename T> struct OpTraits<T, std::modulus> {
    static const T neutral = 1;
 };
+template <typename T> struct OpTraits<T, minimum> {
+   static const T neutral = std::numeric_limits<T>::max();
+};
+template <typename T> struct OpTraits<T, maximum> {
+   static const T neutral = std::numeric_limits<T>::lowest();
+};
 
 template <typename T, template <typename> class Op>
 pos_t aggr_init(pos_t n, T** RES toInit, size_t* struct_size, size_t offset) {
@@ -352,6 +661,42 @@ pos_t aggr_init(pos_t n, T** RES toInit, size_t* struct_size, size_t offset) {
    return n;
 }
 
+template <typename T>
+pos_t aggr_static_wide_col(pos_t n, types::Sum128* RES result, T* RES param1)
+/// sum column into a 128 bit sum. The column is summed in 64 bits first,
+/// only if that overflows the values are added to the 128 bit sum one by one
+{
+   T sum = 0;
+   bool overflow = false;
+   for (uint64_t i = 0; i < n; ++i)
+      overflow |= __builtin_add_overflow(sum, param1[i], &sum);
+   if (!overflow)
+      result->add(sum);
+   else
+      for (uint64_t i = 0; i < n; ++i) result->add(param1[i]);
+   return n > 0;
+}
+
+template <typename T>
+pos_t aggr_wide_col(pos_t n, types::Sum128* RES entries[], T* RES param1,
+                    size_t offset)
+/// add column into the 128 bit sums given by entries
+{
+   for (uint64_t i = 0; i < n; ++i)
+      addBytes(entries[i], offset)->add(param1[i]);
+   return n;
+}
+
+template <typename T>
+pos_t aggr_wide_sel_col(pos_t n, types::Sum128* RES entries[],
+                        pos_t* selParam1, T* RES param1, size_t offset)
+/// add column with selection vector into the 128 bit sums given by entries
+{
+   for (uint64_t i = 0; i < n; ++i)
+      addBytes(entries[i], offset)->add(param1[selParam1[i]]);
+   return n;
+}
+
 //------------------------------------------------------------------------------
 //--- scatter templates
 template <typename T>
@@ -423,6 +768,25 @@ pos_t gather_val(pos_t n, T** RES input, size_t offset, size_t* struct_size,
    return n;
 }
 
+//------------------------------------------------------------------------------
+//--- late materialization templates
+template <typename T>
+pos_t materialize_sel(pos_t n, pos_t* RES inSel, T* RES result, T* RES input)
+/// copies the selected rows of the current vector into a dense vector
+{
+   for (uint64_t i = 0; i < n; ++i) result[i] = input[inSel[i]];
+   return n;
+}
+
+template <typename T>
+pos_t materialize_rowid(pos_t n, uint64_t* RES rowIds, T* RES result,
+                        T* RES column)
+/// fetches values of a base table column by row id
+{
+   for (uint64_t i = 0; i < n; ++i) result[i] = column[rowIds[i]];
+   return n;
+}
+
 //------------------------------------------------------------------------------
 //--- hashing templates
 using hash_t = defs::hash_t;
@@ -1106,9 +1470,19 @@ using FPartitionByKeyRow = pos_t (*)(pos_t n, pos_t* sel,
 #define EACH_COMP(m, c)                                                        \
    m(c, equal_to) m(c, greater_equal) m(c, greater) m(c, less_equal) m(c, less)
 
+/// apply all range predicates as second argument to m, pass c as first arg
+#define EACH_RANGE(m, c) m(c, between) m(c, between_halfopen)
+
+/// apply all LIKE predicates as second argument to m, pass c as first arg
+#define EACH_LIKE(m, c) m(c, like_prefix) m(c, like_suffix) m(c, like_contains)
+
 #define EACH_ARITH_COMM(m, c) m(c, plus) m(c, multiplies)
 #define EACH_ARITH_NON_COMM(m, c) m(c, minus) m(c, divides) m(c, modulus)
 #define EACH_ARITH(m, c) EACH_ARITH_COMM(m, c) EACH_ARITH_NON_COMM(m, c)
+/// apply min and max aggregations as second argument to m
+#define EACH_EXTREMUM(m, c) m(c, minimum) m(c, maximum)
+/// apply aggregations which can be merged from partial aggregates
+#define EACH_DECOMPOSABLE(m, c) m(c, plus) EACH_EXTREMUM(m, c)
 
 using Char_1 = types::Char<1>;
 using Char_6 = types::Char<6>;
@@ -1128,6 +1502,10 @@ using Varchar_55 = types::Varchar<55>;
 #define EACH_TYPE_FULL(m, c)                                                   \
    m(int32_t, c) m(int64_t, c) m(int8_t, c) m(int16_t, c)
 #define EACH_TYPE(m, c) EACH_TYPE_BASIC(m, c) EACH_TYPE_FULL(m, c)
+/// apply all string types with a length as first argument to m
+#define EACH_TYPE_STRING(m, c)                                                 \
+   m(Char_6, c) m(Char_7, c) m(Char_9, c) m(Char_10, c) m(Char_12, c)          \
+       m(Char_15, c) m(Char_25, c) m(Char_55, c) m(Varchar_55, c)
 
 #define NIL(t, m) m(t)
 
@@ -1151,6 +1529,31 @@ using Varchar_55 = types::Varchar<55>;
 #define MK_SELSEL_COLVAL_BF_DECL(type, op)                                     \
    extern F4 selsel_##op##_##type##_col_##type##_val_bf;
 
+#define MK_SEL_RANGE_DECL(type, op)                                            \
+   extern F4 sel_##op##_##type##_col_##type##_val_##type##_val;
+#define MK_SELSEL_RANGE_DECL(type, op)                                         \
+   extern F5 selsel_##op##_##type##_col_##type##_val_##type##_val;
+#define MK_SEL_RANGE_BF_DECL(type, op)                                         \
+   extern F4 sel_##op##_##type##_col_##type##_val_##type##_val_bf;
+#define MK_SELSEL_RANGE_BF_DECL(type, op)                                      \
+   extern F5 selsel_##op##_##type##_col_##type##_val_##type##_val_bf;
+
+#define MK_SEL_IN_DECL(type) extern F3 sel_in_##type##_col_##type##_list;
+#define MK_SELSEL_IN_DECL(type) extern F4 selsel_in_##type##_col_##type##_list;
+#define MK_SEL_IN_BF_DECL(type)                                                \
+   extern F3 sel_in_##type##_col_##type##_list_bf;
+#define MK_SELSEL_IN_BF_DECL(type)                                             \
+   extern F4 selsel_in_##type##_col_##type##_list_bf;
+
+#define MK_SEL_PATTERN_DECL(type, op)                                          \
+   extern F3 sel_##op##_##type##_col_pattern;
+#define MK_SELSEL_PATTERN_DECL(type, op)                                       \
+   extern F4 selsel_##op##_##type##_col_pattern;
+#define MK_SEL_PATTERN_BF_DECL(type, op)                                       \
+   extern F3 sel_##op##_##type##_col_pattern_bf;
+#define MK_SELSEL_PATTERN_BF_DECL(type, op)                                    \
+   extern F4 selsel_##op##_##type##_col_pattern_bf;
+
 #define MK_PROJ_COLCOL_DECL(type, op)                                          \
    extern F3 proj_##op##_##type##_col_##type##_col;
 #define MK_PROJ_COLVAL_DECL(type, op)                                          \
@@ -1178,6 +1581,8 @@ using Varchar_55 = types::Varchar<55>;
 #define MK_AGGR_SEL_COL_DECL(type, op)                                         \
    extern FAggrSel aggr_sel_##op##_##type##_col;
 #define MK_AGGR_ROW_DECL(type, op) extern FAggrRow aggr_row_##op##_##type##_col;
+#define MK_AGGR_SEL_ATOMIC_PLUS_DECL(type)                                     \
+   extern FAggrSel aggr_sel_atomic_plus_##type##_col;
 #define MK_AGGR_INIT_DECL(type, op)                                            \
    extern FAggrInit aggr_init_##op##_##type##_col;
 
@@ -1196,6 +1601,11 @@ using Varchar_55 = types::Varchar<55>;
    extern FGatherSel gather_sel_col_##type##_col;
 #define MK_GATHER_VAL_DECL(type) extern FGatherVal gather_val_##type##_col;
 
+#define MK_MATERIALIZE_SEL_DECL(type)                                          \
+   extern F3 materialize_sel_##type##_col;
+#define MK_MATERIALIZE_ROWID_DECL(type)                                        \
+   extern F3 materialize_rowid_##type##_col;
+
 #define MK_KEYS_EQUAL_DECL(type) extern EQCheck keys_equal_##type##_col;
 #define MK_KEYS_NOT_EQUAL_DECL(type)                                           \
    extern NEQCheck keys_not_equal_##type##_col;
@@ -1223,8 +1633,23 @@ EACH_COMP(EACH_TYPE, MK_SEL_COLVAL_BF_DECL)
 EACH_COMP(EACH_TYPE, MK_SELSEL_COLCOL_BF_DECL)
 EACH_COMP(EACH_TYPE, MK_SELSEL_COLVAL_BF_DECL)
 
+EACH_RANGE(EACH_TYPE, MK_SEL_RANGE_DECL)
+EACH_RANGE(EACH_TYPE, MK_SELSEL_RANGE_DECL)
+EACH_RANGE(EACH_TYPE, MK_SEL_RANGE_BF_DECL)
+EACH_RANGE(EACH_TYPE, MK_SELSEL_RANGE_BF_DECL)
+
+EACH_TYPE(NIL, MK_SEL_IN_DECL)
+EACH_TYPE(NIL, MK_SELSEL_IN_DECL)
+EACH_TYPE(NIL, MK_SEL_IN_BF_DECL)
+EACH_TYPE(NIL, MK_SELSEL_IN_BF_DECL)
+
 extern F3 sel_contains_Varchar_55_col_Varchar_55_val;
 
+EACH_LIKE(EACH_TYPE_STRING, MK_SEL_PATTERN_DECL)
+EACH_LIKE(EACH_TYPE_STRING, MK_SELSEL_PATTERN_DECL)
+EACH_LIKE(EACH_TYPE_STRING, MK_SEL_PATTERN_BF_DECL)
+EACH_LIKE(EACH_TYPE_STRING, MK_SELSEL_PATTERN_BF_DECL)
+
 EACH_ARITH(EACH_TYPE_FULL, MK_PROJ_COLCOL_DECL)
 EACH_ARITH(EACH_TYPE_FULL, MK_PROJ_COLVAL_DECL)
 EACH_ARITH(EACH_TYPE_FULL, MK_PROJ_SEL_BOTH_COLCOL_DECL)
@@ -1244,9 +1669,40 @@ EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_COL_DECL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_SEL_COL_DECL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_ROW_DECL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_INIT_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_STATIC_COL_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_STATIC_SEL_COL_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_COL_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_SEL_COL_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_ROW_DECL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_INIT_DECL)
+EACH_TYPE_FULL(NIL, MK_AGGR_SEL_ATOMIC_PLUS_DECL)
+
+struct AggrMerge
+/// primitives which merge partial aggregates of a decomposable aggregation,
+/// e.g. partial sums and counts are merged by adding them up
+{
+   FAggrInit init;
+   FAggr aggr;
+   FAggrSel aggrSel;
+   FAggrRow aggrRow;
+   FGatherVal gather;
+};
+/// merge primitives for partial aggregates which are combined by aggrRow in
+/// global aggregation, throws if the aggregation is not decomposable
+AggrMerge aggrMergeOf(FAggrRow aggrRow);
 extern F1 aggr_static_count_star;
 extern FAggr aggr_count_star;
 
+/// sums of int64_t columns, e.g. Numerics, into 128 bit sums (types::Sum128),
+/// which do not overflow
+extern F2 aggr_static_wide_plus_int64_t_col;
+extern FAggr aggr_wide_plus_int64_t_col;
+extern FAggrSel aggr_wide_sel_plus_int64_t_col;
+/// merge 128 bit sums in global aggregation
+extern FAggrRow aggr_row_wide_plus_col;
+extern FAggrInit aggr_init_wide_plus_col;
+extern FGatherVal gather_val_Sum128_col;
+
 EACH_TYPE(NIL, MK_HASH_DECL)
 EACH_TYPE(NIL, MK_HASH_SEL_DECL)
 EACH_TYPE(NIL, MK_REHASH_DECL)
@@ -1260,6 +1716,11 @@ EACH_TYPE(NIL, MK_GATHER_COL_DECL)
 EACH_TYPE(NIL, MK_GATHER_SEL_COL_DECL)
 EACH_TYPE(NIL, MK_GATHER_VAL_DECL)
 
+EACH_TYPE(NIL, MK_MATERIALIZE_SEL_DECL)
+EACH_TYPE(NIL, MK_MATERIALIZE_ROWID_DECL)
+/// row ids of the current vector, offset points to Scan::currentOffset()
+extern F2 rowid_col;
+
 EACH_TYPE(NIL, MK_KEYS_EQUAL_DECL)
 EACH_TYPE(NIL, MK_KEYS_NOT_EQUAL_DECL)
 EACH_TYPE(NIL, MK_KEYS_NOT_EQUAL_SEL_DECL)
@@ -1292,6 +1753,39 @@ extern F4 selsel_greater_equal_int32_t_col_int32_t_val_avx512;
 extern F4 selsel_greater_equal_int64_t_col_int64_t_val_avx512;
 extern F4 selsel_less_int64_t_col_int64_t_val_avx512;
 extern F4 selsel_less_equal_int64_t_col_int64_t_val_avx512;
+/// small IN-lists compared in AVX-512 registers, other lists are looked up
+extern F3 sel_in_int32_t_col_int32_t_list_avx512;
+extern F4 selsel_in_int32_t_col_int32_t_list_avx512;
+extern F3 sel_in_int64_t_col_int64_t_list_avx512;
+extern F4 selsel_in_int64_t_col_int64_t_list_avx512;
+
+#define MK_AGGR_STATIC_COL_AVX512_DECL(type, op)                               \
+   extern F2 aggr_static_##op##_##type##_col_avx512;
+#define MK_AGGR_STATIC_SEL_COL_AVX512_DECL(type, op)                           \
+   extern F3 aggr_static_sel_##op##_##type##_col_avx512;
+#define MK_AGGR_FEW_COL_AVX512_DECL(type, op)                                  \
+   extern FAggr aggr_few_##op##_##type##_col_avx512;
+#define MK_AGGR_FEW_SEL_COL_AVX512_DECL(type, op)                              \
+   extern FAggrSel aggr_few_sel_##op##_##type##_col_avx512;
+/// apply the types with AVX-512 aggregation primitives as first argument to m
+#define EACH_TYPE_AVX512_AGGR(m, c) m(int32_t, c) m(int64_t, c)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_AGGR, MK_AGGR_STATIC_COL_AVX512_DECL)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_AGGR, MK_AGGR_STATIC_SEL_COL_AVX512_DECL)
+/// number of distinct groups per vector up to which aggr_few_* keep the
+/// aggregates in registers
+const size_t fewGroups = 8;
+/// like aggr_* and aggr_sel_*, for vectors with at most fewGroups distinct
+/// entries, e.g. of group bys with few groups. The aggregates of each group
+/// are accumulated in a vector register with masked operations and written
+/// back once per vector. Other vectors fall back to aggr_* and aggr_sel_*.
+/// Only for 64 bit values, so that values and entries share the lanes
+#define EACH_TYPE_AVX512_FEW(m, c) m(int64_t, c)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_FEW, MK_AGGR_FEW_COL_AVX512_DECL)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_FEW, MK_AGGR_FEW_SEL_COL_AVX512_DECL)
+extern FAggr aggr_few_count_star_avx512;
+/// aggr_static_wide_plus_int64_t_col where values are summed in 64 bit
+/// vector lanes if their magnitude rules out an overflow
+extern F2 aggr_static_wide_plus_int64_t_col_avx512;
 #endif
 } // namespace primitives
 } // namespace vectorwise
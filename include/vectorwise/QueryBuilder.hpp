@@ -18,6 +18,11 @@ class QueryBuilder {
    SharedStateManager& operatorState;
    VectorAllocator vecs;
    std::unordered_map<size_t, std::pair<size_t, void*>> buffers;
+   /// output buffers of partial aggregations, with the primitive which
+   /// merges their partial aggregates
+   std::unordered_map<void*, primitives::FAggrRow> partialAggregates;
+   /// hash joins by the buffer of their probe matches
+   std::unordered_map<void*, Hashjoin*> joins;
 
    struct DataStorage
    /// handle for data sources, e.g. base table columns or cache buffers
@@ -54,6 +59,21 @@ class QueryBuilder {
       ProjectionBuilder& addExpression(std::unique_ptr<Expression>&& exp);
    };
 
+   struct MaterializeBuilder
+   /// fetches late materialized columns into dense buffers
+   {
+      QueryBuilder& base;
+      Project& project;
+      using B = MaterializeBuilder;
+      /// copy the rows of a streamed column selected by sel, e.g. by a
+      /// selection or the probe matches of a join
+      B& addColumn(DS col, DS sel, primitives::F3 materialize, DS out);
+      /// fetch a column of scan by row ids, e.g. gathered from the build side
+      /// of a join
+      B& addColumn(ScanBuilder& scan, std::string attribute, DS rowIds,
+                   primitives::F3 materialize, DS out);
+   };
+
    struct HashJoinBuilder {
       QueryBuilder& base;
       bool probeHasSelection = false;
@@ -81,6 +101,19 @@ class QueryBuilder {
       setProbeSelVector(DS vec,
                         pos_t (Hashjoin::*join)() = &Hashjoin::joinSelParallel);
       B& pushProbeSelVector(DS sel, DS target);
+      /// write one byte per result tuple into target, set if the tuple has
+      /// a join partner. Only for mark and left outer joins
+      B& setMarker(DS target);
+      /// declare the build keys unique, e.g. for primary key - foreign key
+      /// joins. Probing stops at the first match of each probe
+      B& setUniqueBuildKeys(bool unique = true);
+      /// aggregate probe column col into a new field of the matching build
+      /// entry, only for group joins. aggrInit initializes the field on build,
+      /// aggr must update it atomically, e.g. aggr_sel_atomic_plus_*. gather
+      /// writes the aggregates of the resulting groups into target
+      B& addGroupAggregate(DS col, primitives::FAggrInit aggrInit,
+                           primitives::FAggrSel aggr, DS target,
+                           primitives::FGather gather);
    };
 
    struct HashGroupBuilder {
@@ -128,8 +161,20 @@ class QueryBuilder {
       B& addValue(DS col, DS sel, primitives::FAggrInit aggrInit,
                   primitives::FAggrSel aggr, primitives::FAggrRow aggrGlobal,
                   primitives::FGatherVal gather, DS out);
+      /// aggregate partial aggregates of a partial aggregation, e.g. after a
+      /// join. The aggregation is derived from the one producing col
+      B& mergeValue(DS col, DS out);
+      B& mergeValue(DS col, DS sel, DS out);
+      /// sum a 64 bit column, e.g. of Numerics, into 128 bit sums which do
+      /// not overflow. out receives types::Sum128 values
+      B& addWideSum(DS col, DS out);
+      B& addWideSum(DS col, DS sel, DS out);
       B& padToAlign(size_t align);
       ~HashGroupBuilder();
+
+    private:
+      /// make room for a 128 bit sum of col in the last added value
+      void widenLastValue(DS col);
    };
 
    struct ExpressionBuilder {
@@ -139,6 +184,8 @@ class QueryBuilder {
       ExpressionBuilder& addOp(primitives::F2 op, DS a, DS b);
       ExpressionBuilder& addOp(primitives::F3 op, DS a, DS b, DS c);
       ExpressionBuilder& addOp(primitives::F4 op, DS a, DS b, DS c, DS d);
+      ExpressionBuilder& addOp(primitives::F5 op, DS a, DS b, DS c, DS d,
+                               DS e);
       operator std::unique_ptr<vectorwise::Expression>();
       operator std::unique_ptr<vectorwise::Aggregates>();
    };
@@ -164,7 +211,34 @@ class QueryBuilder {
    HashJoinBuilder
    HashJoin(DS probeMatches,
             pos_t (Hashjoin::*join)() = &Hashjoin::joinAllParallel);
+   /// hash join with semantics mode. Semi, anti and mark joins produce probe
+   /// side positions only and must not have build values. Group joins produce
+   /// build values and group aggregates of the build entries with a match
+   HashJoinBuilder HashJoin(DS probeMatches, Hashjoin::Mode mode);
+   /// build the hash tables of the joins with the given probe matches
+   /// together, see Hashjoin::concurrentBuilds. The build side of each join
+   /// must not contain another one of them, e.g. the build sides of q9's
+   /// part and supplier joins
+   void BuildConcurrently(std::vector<DS> probeMatches);
    HashGroupBuilder HashGroup();
+   /// thread local partial aggregation without global aggregation, e.g. below
+   /// a join. Decomposable aggregates are merged later on with mergeValue
+   HashGroupBuilder PartialHashGroup();
+   /// materialize columns into dense buffers after a selection or a join
+   MaterializeBuilder Materialize();
+   /// fill out with the row ids of the current vector of scan. Needs to be
+   /// placed directly on top of the scan, below any selection
+   DS RowIds(ScanBuilder& scan, DS out);
+   /// bytes which can be copied in the time of a cache miss
+   size_t cacheMissCost = 256;
+   /// decides if attribute should be fetched by row id after selections,
+   /// joins and aggregations instead of being copied along. Early
+   /// materialization copies the value into copies operators, e.g. join hash
+   /// tables, late materialization copies a row id instead and fetches the
+   /// value for the selectivity, i.e. the estimated fraction, of these rows
+   /// which reach the materialization
+   bool materializeLate(ScanBuilder& scan, std::string attribute,
+                        size_t copies, double selectivity);
 
    ~QueryBuilder();
 
@@ -86,6 +86,40 @@ vectorwise::primitives::F4 ExperimentConfig::selsel_less_equal_int64_t_col_int64
 #endif
   return BF(vectorwise::primitives::selsel_less_equal_int64_t_col_int64_t_val);
 }
+vectorwise::primitives::F2 ExperimentConfig::aggr_static_plus_int64_t_col() {
+#ifdef __AVX512F__
+  if (useSimdAggr)
+    return vectorwise::primitives::aggr_static_plus_int64_t_col_avx512;
+#endif
+  return vectorwise::primitives::aggr_static_plus_int64_t_col;
+}
+vectorwise::primitives::F2 ExperimentConfig::aggr_static_wide_plus_int64_t_col() {
+#ifdef __AVX512F__
+  if (useSimdAggr)
+    return vectorwise::primitives::aggr_static_wide_plus_int64_t_col_avx512;
+#endif
+  return vectorwise::primitives::aggr_static_wide_plus_int64_t_col;
+}
+vectorwise::primitives::FAggr ExperimentConfig::aggr_plus_int64_t_col() {
+#ifdef __AVX512F__
+  if (useSimdAggr)
+    return vectorwise::primitives::aggr_few_plus_int64_t_col_avx512;
+#endif
+  return vectorwise::primitives::aggr_plus_int64_t_col;
+}
+vectorwise::primitives::FAggrSel ExperimentConfig::aggr_sel_plus_int64_t_col() {
+#ifdef __AVX512F__
+  if (useSimdAggr)
+    return vectorwise::primitives::aggr_few_sel_plus_int64_t_col_avx512;
+#endif
+  return vectorwise::primitives::aggr_sel_plus_int64_t_col;
+}
+vectorwise::primitives::FAggr ExperimentConfig::aggr_count_star() {
+#ifdef __AVX512F__
+  if (useSimdAggr) return vectorwise::primitives::aggr_few_count_star_avx512;
+#endif
+  return vectorwise::primitives::aggr_count_star;
+}
 
 ExperimentConfig::joinFun ExperimentConfig::joinAll() {
 #ifdef __AVX512F__
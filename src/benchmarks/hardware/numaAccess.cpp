@@ -0,0 +1,119 @@
+#include "common/runtime/MemoryPool.hpp"
+#include "common/runtime/Topology.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace runtime;
+using namespace std;
+
+static void escape(void* p) { asm volatile("" : : "g"(p) : "memory"); }
+
+/// node on which the page of p resides, -1 if unknown
+static int nodeOfPage(void* p) {
+#if defined(__linux__) && defined(SYS_move_pages)
+   int status = -1;
+   void* pages[] = {p};
+   if (syscall(SYS_move_pages, 0, 1, pages, nullptr, &status, 0) == 0)
+      return status;
+#else
+   escape(p);
+#endif
+   return -1;
+}
+
+/// first cpu of node in the cpuset
+static unsigned cpuOfNode(const Topology& t, unsigned node) {
+   for (auto& cpu : t.cpus)
+      if (cpu.node == node) return cpu.id;
+   return t.cpus.front().id;
+}
+
+/// GB/s of scanning size bytes at p, on the calling thread
+static double scan(const uint64_t* p, size_t size, unsigned repetitions) {
+   uint64_t sum = 0;
+   auto start = chrono::steady_clock::now();
+   for (unsigned r = 0; r < repetitions; ++r)
+      for (size_t i = 0; i < size / sizeof(uint64_t); ++i) sum += p[i];
+   escape(&sum);
+   chrono::duration<double> time = chrono::steady_clock::now() - start;
+   return size * repetitions / time.count() / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+   if (argc < 2) {
+      cerr << "Usage: " << argv[0]
+           << " <MB per thread> [repetitions = 3]\n"
+              " Compares local and remote memory accesses of pool memory.";
+      return 1;
+   }
+   size_t size = size_t(atoll(argv[1])) << 20;
+   unsigned repetitions = argc > 2 ? atoi(argv[2]) : 3;
+   auto& t = Topology::get();
+   cout << t.cpus.size() << " cpus on " << t.nrNodes << " nodes" << endl;
+
+   // a single thread scans the arena of each node
+   {
+      GlobalPool pool;
+      cout << "GB/s of a thread on node (row) scanning memory of node "
+              "(column)"
+           << endl;
+      for (unsigned cpuNode = 0; cpuNode < t.nrNodes; ++cpuNode) {
+         cout << setw(4) << cpuNode;
+         for (unsigned memNode = 0; memNode < pool.nodes(); ++memNode) {
+            double rate = 0;
+            thread([&]() {
+               pinThread(cpuOfNode(t, cpuNode));
+               auto p = static_cast<uint64_t*>(pool.allocate(size, memNode));
+               memset(p, 1, size);
+               rate = scan(p, size, repetitions);
+            }).join();
+            cout << setw(10) << fixed << setprecision(2) << rate;
+         }
+         cout << endl;
+      }
+   }
+
+   // workers on all cpus allocate from a shared pool and scan their memory
+   auto placement = t.place(t.cpus.size(), Placement::spread);
+   for (auto nodeLocal : {false, true}) {
+      GlobalPool::nodeLocal = nodeLocal;
+      GlobalPool pool;
+      vector<double> rates(placement.size());
+      vector<size_t> remote(placement.size());
+      vector<thread> workers;
+      for (size_t w = 0; w < placement.size(); ++w)
+         workers.emplace_back([&, w]() {
+            pinThread(placement[w]);
+            auto node = Topology::currentNode();
+            auto p = static_cast<uint64_t*>(pool.allocate(size));
+            memset(p, 1, size);
+            for (size_t offset = 0; offset < size; offset += 4096)
+               if (nodeOfPage(reinterpret_cast<int8_t*>(p) + offset) !=
+                   int(t.osNode(node)))
+                  remote[w]++;
+            rates[w] = scan(p, size, repetitions);
+         });
+      for (auto& w : workers) w.join();
+      double rate = 0;
+      size_t remotePages = 0;
+      for (size_t w = 0; w < rates.size(); ++w) {
+         rate += rates[w];
+         remotePages += remote[w];
+      }
+      auto pages = placement.size() * ((size + 4095) / 4096);
+      cout << (nodeLocal ? "node local pools: " : "single pool:      ")
+           << setprecision(2) << rate << " GB/s, "
+           << 100.0 * remotePages / pages << "% remote pages" << endl;
+   }
+   return 0;
+}
@@ -1,6 +1,7 @@
 #include <cstdint>
 #include <thread>
 #include <iostream>
+#include <x86intrin.h>
 #include "benchmarks/Primitives.hpp"
 #include "common/runtime/Barrier.hpp"
 
@@ -41,6 +42,36 @@ void run(Input& i, size_t nrPartitions){
   clobber();
 }
 
+/// same partitioning, but through a cache line sized software write combining
+/// buffer per partition, flushed with non-temporal stores
+void runWriteCombining(Input& i, size_t nrPartitions){
+  const size_t perLine = 64 / sizeof(uint64_t);
+  auto mask = nrPartitions -1;
+  for(auto&c : i.outCount) c = 0;
+  auto c = i.outCount.data();
+  auto buffers = static_cast<uint64_t*>(
+      aligned_alloc(64, nrPartitions * perLine * sizeof(uint64_t)));
+  for(auto& d : i.data){
+    auto part = d&mask;
+    auto& pos = c[part];
+    auto buffer = buffers + part * perLine;
+    buffer[pos % perLine] = d;
+    pos = pos+1;
+    if (pos % perLine == 0) {
+      auto out = reinterpret_cast<long long*>(i.out + part * nrParts + pos -
+                                              perLine);
+      for (size_t w = 0; w < perLine; ++w)
+        _mm_stream_si64(out + w, buffer[w]);
+    }
+  }
+  for (size_t part = 0; part < nrPartitions; ++part)
+    for (size_t w = c[part] - c[part] % perLine; w < c[part]; ++w)
+      i.out[part * nrParts + w] = buffers[part * perLine + w % perLine];
+  _mm_sfence();
+  free(buffers);
+  clobber();
+}
+
 int main(int argc, char** argv) {
   if(argc != 3){
     cout << "Usage: " << argv[0] << " <threadCount> <nrItems>";
@@ -63,4 +94,14 @@ int main(int argc, char** argv) {
       run(inputs[threadCount-1], nrPartitions);
       for(auto& t : threads) t.join();
     }, 1);
+  e.timeAndProfile("writePartitionsWriteCombining", n * threadCount,
+  [&](){
+      vector<thread> threads;
+      threads.reserve(threadCount - 1);
+      for(size_t i = 0; i < threadCount-1; i++)
+        threads.emplace_back(runWriteCombining, std::ref(inputs[i]),
+                             nrPartitions);
+      runWriteCombining(inputs[threadCount-1], nrPartitions);
+      for(auto& t : threads) t.join();
+    }, 1);
 }
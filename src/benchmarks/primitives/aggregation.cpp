@@ -0,0 +1,100 @@
+#include "profile.hpp"
+#include "vectorwise/Primitives.hpp"
+#include "vectorwise/defs.hpp"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using vectorwise::pos_t;
+using namespace vectorwise::primitives;
+
+template <typename T> void putRandom(vector<T>& v, T min = 0, T max = 99) {
+   mt19937 mersenne_engine(1337);
+   uniform_int_distribution<T> dist(min, max);
+   auto gen = std::bind(dist, mersenne_engine);
+   generate(begin(v), end(v), gen);
+}
+
+int main() {
+   size_t n = 1024;
+   size_t repetitions = 100000;
+   PerfEvents e;
+
+   vector<int64_t> input(n);
+   putRandom<int64_t>(input, -1000000, 1000000);
+   // every other tuple, as left by a selection with 50% selectivity
+   vector<pos_t> sel;
+   for (pos_t i = 0; i < n; i += 2) sel.push_back(i);
+   pos_t nSel = sel.size();
+
+   // static aggregation, scalar against AVX-512
+   int64_t sum = 0;
+   e.timeAndProfile("aggr_static_plus\t", n,
+                    [&]() {
+                       aggr_static_plus_int64_t_col(n, &sum, input.data());
+                    },
+                    repetitions);
+   e.timeAndProfile("aggr_static_sel_plus\t", nSel,
+                    [&]() {
+                       aggr_static_sel_plus_int64_t_col(nSel, sel.data(), &sum,
+                                                        input.data());
+                    },
+                    repetitions);
+#ifdef __AVX512F__
+   e.timeAndProfile("aggr_static_plus_avx512\t", n,
+                    [&]() {
+                       aggr_static_plus_int64_t_col_avx512(n, &sum,
+                                                           input.data());
+                    },
+                    repetitions);
+   e.timeAndProfile("aggr_static_sel_plus_avx512\t", nSel,
+                    [&]() {
+                       aggr_static_sel_plus_int64_t_col_avx512(
+                           nSel, sel.data(), &sum, input.data());
+                    },
+                    repetitions);
+#endif
+
+   // group by aggregation, per tuple updates against few group updates.
+   // The tuples of a vector are spread uniformly over the groups
+   for (size_t nrGroups : {1, 2, 4, 8, 16}) {
+      vector<int64_t> groups(nrGroups);
+      vector<size_t> groupOf(n);
+      putRandom<size_t>(groupOf, 0, nrGroups - 1);
+      vector<void*> entries(n);
+      for (size_t i = 0; i < n; ++i) entries[i] = &groups[groupOf[i]];
+      auto suffix = "\t" + to_string(nrGroups) + "\t";
+
+      e.timeAndProfile("aggr_plus" + suffix, n,
+                       [&]() {
+                          aggr_plus_int64_t_col(n, entries.data(),
+                                                input.data(), 0);
+                       },
+                       repetitions);
+      e.timeAndProfile("aggr_count_star" + suffix, n,
+                       [&]() {
+                          aggr_count_star(n, entries.data(), nullptr, 0);
+                       },
+                       repetitions);
+#ifdef __AVX512F__
+      e.timeAndProfile("aggr_few_plus_avx512" + suffix, n,
+                       [&]() {
+                          aggr_few_plus_int64_t_col_avx512(n, entries.data(),
+                                                           input.data(), 0);
+                       },
+                       repetitions);
+      e.timeAndProfile("aggr_few_count_star_avx512" + suffix, n,
+                       [&]() {
+                          aggr_few_count_star_avx512(n, entries.data(),
+                                                     nullptr, 0);
+                       },
+                       repetitions);
+#endif
+   }
+   return 0;
+}
@@ -35,8 +35,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q11_hyper(Database& db,
 
    // --- ht for join date-lineorder
    Hashset<types::Integer, hash> ht;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht)::Entry>> entries1;
    auto& d = db["date"];
    auto d_year = d["d_year"].data<types::Integer>();
    auto d_datekey = d["d_datekey"].data<types::Integer>();
@@ -59,10 +58,13 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q11_hyper(Database& db,
    auto lo_discount = lo["lo_discount"].data<types::Numeric<18, 2>>();
    auto lo_extendedprice = lo["lo_extendedprice"].data<types::Numeric<18, 2>>();
 
+   auto ahead = runtime::ReadAhead::create(
+       lo, {"lo_orderdate", "lo_quantity", "lo_discount", "lo_extendedprice"});
    auto result_revenue = tbb::parallel_reduce(
        tbb::blocked_range<size_t>(0, lo.nrTuples), types::Numeric<18, 4>(0),
        [&](const tbb::blocked_range<size_t>& r,
            const types::Numeric<18, 4>& s) {
+          runtime::ReadAhead::advance(ahead.get(), r.begin());
           auto revenue = s;
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
              auto& quantity = lo_quantity[i];
@@ -92,7 +94,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q11_hyper(Database& db,
    *revenue = result_revenue;
    block.addedElements(1);
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return std::move(resources.query);
 }
 
@@ -123,6 +125,7 @@ std::unique_ptr<Q11Builder::Q11> Q11Builder::getQuery() {
                   Column(lineorder, "lo_discount"), Value(&r->discount_max)));
 
    HashJoin(Buffer(join_result, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .setProbeSelVector(Buffer(sel_discount_high), conf.joinSel())
        .addBuildKey(Column(date, "d_datekey"), Buffer(sel_year),
                     conf.hash_sel_int32_t_col(),
@@ -177,6 +180,7 @@ std::unique_ptr<runtime::Query> q11_vectorwise(Database& db, size_t nrThreads,
             *revenue = aggr.load();
             block.addedElements(1);
          }
+         result->result->finalize();
       }
    });
 
@@ -57,8 +57,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q23_hyper(Database& db,
 
    // --- ht for join date-lineorder
    Hashmapx<types::Integer, types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto& d = db["date"];
    auto d_year = d["d_year"].data<types::Integer>();
    auto d_datekey = d["d_datekey"].data<types::Integer>();
@@ -72,8 +71,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q23_hyper(Database& db,
 
    // --- ht for join supplier-lineorder
    Hashset<types::Integer, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto& su = db["supplier"];
    auto s_suppkey = su["s_suppkey"].data<types::Integer>();
    auto s_region = su["s_region"].data<types::Char<12>>();
@@ -91,8 +89,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q23_hyper(Database& db,
 
    // --- ht for join part-lineorder
    Hashmapx<types::Integer, types::Char<9>, hash> ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
    auto& p = db["part"];
    auto p_partkey = p["p_partkey"].data<types::Integer>();
    auto p_brand1 = p["p_brand1"].data<types::Char<9>>();
@@ -120,9 +117,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q23_hyper(Database& db,
        [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto ahead = runtime::ReadAhead::create(
+       lo, {"lo_orderdate", "lo_partkey", "lo_suppkey", "lo_revenue"});
    tbb::parallel_for(
        tbb::blocked_range<size_t>(0, lo.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
+          runtime::ReadAhead::advance(ahead.get(), r.begin());
           auto groupLocals = groupOp.preAggLocals();
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
              auto& revenue = lo_revenue[i];
@@ -165,7 +165,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q23_hyper(Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -190,6 +190,7 @@ std::unique_ptr<Q23Builder::Q23> Q23Builder::getQuery() {
 
    auto lineorder = Scan("lineorder");
    HashJoin(Buffer(lineorder_part, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(part, "p_partkey"), Buffer(sel_part),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -202,6 +203,7 @@ std::unique_ptr<Q23Builder::Q23> Q23Builder::getQuery() {
 
    // filter for p_brand1 is lineorder_supplier
    HashJoin(Buffer(lineorder_supplier, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(supplier, "s_suppkey"), Buffer(sel_supplier),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -213,6 +215,7 @@ std::unique_ptr<Q23Builder::Q23> Q23Builder::getQuery() {
                     primitives::keys_equal_int32_t_col);
 
    HashJoin(Buffer(lineorder_date, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(date, "d_datekey"), conf.hash_int32_t_col(),
                     primitives::scatter_int32_t_col)
        .addBuildValue(Column(date, "d_year"), primitives::scatter_int32_t_col,
@@ -57,8 +57,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q31_hyper(Database& db,
 
    // --- ht for join date-lineorder
    Hashmapx<types::Integer, types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto& d = db["date"];
    auto d_year = d["d_year"].data<types::Integer>();
    auto d_datekey = d["d_datekey"].data<types::Integer>();
@@ -75,8 +74,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q31_hyper(Database& db,
 
    // --- ht for join supplier-lineorder
    Hashmapx<types::Integer, types::Char<15>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto& su = db["supplier"];
    auto s_suppkey = su["s_suppkey"].data<types::Integer>();
    auto s_region = su["s_region"].data<types::Char<12>>();
@@ -96,8 +94,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q31_hyper(Database& db,
 
    // --- ht for join part-lineorder
    Hashmapx<types::Integer, types::Char<15>, hash> ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
    auto& c = db["customer"];
    auto c_custkey = c["c_custkey"].data<types::Integer>();
    auto c_nation = c["c_nation"].data<types::Char<15>>();
@@ -128,9 +125,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q31_hyper(Database& db,
            [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto ahead = runtime::ReadAhead::create(
+       lo, {"lo_orderdate", "lo_custkey", "lo_suppkey", "lo_revenue"});
    tbb::parallel_for(
        tbb::blocked_range<size_t>(0, lo.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
+          runtime::ReadAhead::advance(ahead.get(), r.begin());
           auto groupLocals = groupOp.preAggLocals();
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
              auto& revenue = lo_revenue[i];
@@ -182,7 +182,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q31_hyper(Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -215,6 +215,7 @@ std::unique_ptr<Q31Builder::Q31> Q31Builder::getQuery() {
 
    auto lineorder = Scan("lineorder");
    HashJoin(Buffer(lineorder_customer, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(customer, "c_custkey"), Buffer(sel_customer),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -227,6 +228,7 @@ std::unique_ptr<Q31Builder::Q31> Q31Builder::getQuery() {
 
    // filter for c_nation is lineorder_supplier
    HashJoin(Buffer(lineorder_supplier, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(supplier, "s_suppkey"), Buffer(sel_supplier),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -243,6 +245,7 @@ std::unique_ptr<Q31Builder::Q31> Q31Builder::getQuery() {
 
    // filter for s_nation is lineorder_date
    HashJoin(Buffer(lineorder_date, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(date, "d_datekey"), Buffer(sel_year_min),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
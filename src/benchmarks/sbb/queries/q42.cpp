@@ -66,8 +66,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
 
    // --- ht for join date-lineorder
    Hashmapx<types::Integer, types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto& d = db["date"];
    auto d_year = d["d_year"].data<types::Integer>();
    auto d_datekey = d["d_datekey"].data<types::Integer>();
@@ -84,8 +83,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
 
    // --- ht for join part-lineorder
    Hashmapx<types::Integer, types::Char<7>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto& p = db["part"];
    auto p_partkey = p["p_partkey"].data<types::Integer>();
    auto p_mfgr = p["p_mfgr"].data<types::Char<6>>();
@@ -104,8 +102,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
 
    // --- ht for join customer-lineorder
    Hashset<types::Integer, hash> ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
    auto& c = db["customer"];
    auto c_custkey = c["c_custkey"].data<types::Integer>();
    auto c_region = c["c_region"].data<types::Char<12>>();
@@ -122,8 +119,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
 
    // --- ht for join supplier-lineorder
    Hashmapx<types::Integer, types::Char<15>, hash> ht4;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht4)::Entry>>
-       entries4;
+   runtime::thread_specific<runtime::Stack<decltype(ht4)::Entry>> entries4;
    auto& su = db["supplier"];
    auto s_suppkey = su["s_suppkey"].data<types::Integer>();
    auto s_nation = su["s_nation"].data<types::Char<15>>();
@@ -156,8 +152,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
            [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto ahead = runtime::ReadAhead::create(
+       lo, {"lo_orderdate", "lo_custkey", "lo_suppkey", "lo_partkey",
+            "lo_revenue", "lo_supplycost"});
    tbb::parallel_for(tbb::blocked_range<size_t>(0, lo.nrTuples, morselSize),
                      [&](const tbb::blocked_range<size_t>& r) {
+                        runtime::ReadAhead::advance(ahead.get(), r.begin());
                         auto groupLocals = groupOp.preAggLocals();
                         for (size_t i = r.begin(), end = r.end(); i != end;
                              ++i) {
@@ -215,7 +215,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q42_hyper(Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -253,6 +253,7 @@ std::unique_ptr<Q42Builder::Q42> Q42Builder::getQuery() {
 
    // filter for lineorder is lineorder_supplier
    HashJoin(Buffer(lineorder_supplier, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(supplier, "s_suppkey"), Buffer(sel_supplier),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -265,6 +266,7 @@ std::unique_ptr<Q42Builder::Q42> Q42Builder::getQuery() {
 
    // filter for s_nation is lineorder_customer
    HashJoin(Buffer(lineorder_customer, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(customer, "c_custkey"), Buffer(sel_customer),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -277,6 +279,7 @@ std::unique_ptr<Q42Builder::Q42> Q42Builder::getQuery() {
                     primitives::keys_equal_int32_t_col);
 
    HashJoin(Buffer(lineorder_part, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(part, "p_partkey"), Buffer(sel_part),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -297,6 +300,7 @@ std::unique_ptr<Q42Builder::Q42> Q42Builder::getQuery() {
 
    // filter for p_category is lineorder_date
    HashJoin(Buffer(lineorder_date, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(date, "d_datekey"), Buffer(sel_date),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
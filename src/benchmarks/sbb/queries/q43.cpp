@@ -64,8 +64,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
 
    // --- ht for join date-lineorder
    Hashmapx<types::Integer, types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto& d = db["date"];
    auto d_year = d["d_year"].data<types::Integer>();
    auto d_datekey = d["d_datekey"].data<types::Integer>();
@@ -82,8 +81,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
 
    // --- ht for join part-lineorder
    Hashmapx<types::Integer, types::Char<9>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto& p = db["part"];
    auto p_partkey = p["p_partkey"].data<types::Integer>();
    auto p_brand1 = p["p_brand1"].data<types::Char<9>>();
@@ -102,8 +100,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
 
    // --- ht for join customer-lineorder
    Hashset<types::Integer, hash> ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
    auto& c = db["customer"];
    auto c_custkey = c["c_custkey"].data<types::Integer>();
    auto c_region = c["c_region"].data<types::Char<12>>();
@@ -120,8 +117,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
 
    // --- ht for join supplier-lineorder
    Hashmapx<types::Integer, types::Char<10>, hash> ht4;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht4)::Entry>>
-       entries4;
+   runtime::thread_specific<runtime::Stack<decltype(ht4)::Entry>> entries4;
    auto& su = db["supplier"];
    auto s_suppkey = su["s_suppkey"].data<types::Integer>();
    auto s_nation = su["s_nation"].data<types::Char<15>>();
@@ -154,8 +150,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
            [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto ahead = runtime::ReadAhead::create(
+       lo, {"lo_orderdate", "lo_custkey", "lo_suppkey", "lo_partkey",
+            "lo_revenue", "lo_supplycost"});
    tbb::parallel_for(tbb::blocked_range<size_t>(0, lo.nrTuples, morselSize),
                      [&](const tbb::blocked_range<size_t>& r) {
+                        runtime::ReadAhead::advance(ahead.get(), r.begin());
                         auto groupLocals = groupOp.preAggLocals();
                         for (size_t i = r.begin(), end = r.end(); i != end;
                              ++i) {
@@ -213,7 +213,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q43_hyper(Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -250,6 +250,7 @@ std::unique_ptr<Q43Builder::Q43> Q43Builder::getQuery() {
 
    // filter for lineorder is lineorder_supplier
    HashJoin(Buffer(lineorder_supplier, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(supplier, "s_suppkey"), Buffer(sel_supplier),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -262,6 +263,7 @@ std::unique_ptr<Q43Builder::Q43> Q43Builder::getQuery() {
 
    // filter for s_city is lineorder_customer
    HashJoin(Buffer(lineorder_customer, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(customer, "c_custkey"), Buffer(sel_customer),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -274,6 +276,7 @@ std::unique_ptr<Q43Builder::Q43> Q43Builder::getQuery() {
                     primitives::keys_equal_int32_t_col);
 
    HashJoin(Buffer(lineorder_part, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(part, "p_partkey"), Buffer(sel_part),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -294,6 +297,7 @@ std::unique_ptr<Q43Builder::Q43> Q43Builder::getQuery() {
 
    // filter for p_brand1 is lineorder_date
    HashJoin(Buffer(lineorder_date, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(date, "d_datekey"), Buffer(sel_date),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
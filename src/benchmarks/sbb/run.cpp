@@ -7,7 +7,11 @@
 #include <unordered_set>
 
 #include "benchmarks/ssb/Queries.hpp"
+#include "common/runtime/ChunkCache.hpp"
 #include "common/runtime/Import.hpp"
+#include "common/runtime/ReadAhead.hpp"
+#include "common/runtime/Scheduler.hpp"
+#include "common/runtime/Topology.hpp"
 #include "profile.hpp"
 #include "tbb/tbb.h"
 
@@ -52,6 +56,7 @@ int main(int argc, char* argv[]) {
    size_t vectorSize = 1024;
    bool clearCaches = false;
    if (argc > 3) nrThreads = atoi(argv[3]);
+   Scheduler::globalThreads = nrThreads;
 
 
    std::unordered_set<std::string> q = {
@@ -65,7 +70,31 @@ int main(int argc, char* argv[]) {
    if (auto v = std::getenv("SIMDjoin")) conf.useSimdJoin = atoi(v);
    if (auto v = std::getenv("SIMDsel")) conf.useSimdSel = atoi(v);
    if (auto v = std::getenv("SIMDproj")) conf.useSimdProj = atoi(v);
+   if (auto v = std::getenv("SIMDaggr")) conf.useSimdAggr = atoi(v);
+   // joins on unique build keys stop at the first match, instead of the
+   // SIMDjoin loops
+   if (auto v = std::getenv("uniqueJoin")) conf.useUniqueJoin = atoi(v);
    if (auto v = std::getenv("clearCaches")) clearCaches = atoi(v);
+   // MB of faulted memory kept for reuse between repetitions
+   if (auto v = std::getenv("warmMemory"))
+      ChunkCache::global().warmLimit = size_t(atoll(v)) << 20;
+   // MB each query may reserve before it fails with MemoryLimitExceeded
+   if (auto v = std::getenv("memoryLimit"))
+      MemoryAccount::queryLimit = size_t(atoll(v)) << 20;
+   // pause rounds before threads waiting in a barrier sleep on a futex
+   if (auto v = std::getenv("barrierSpin"))
+      Barrier::defaultSpinBudget = uint32_t(atoll(v));
+   // physical, compact or spread placement of threads on the cpus
+   if (auto v = std::getenv("placement"))
+      Topology::placement = Topology::parsePlacement(v);
+   // pools of queries with an arena per NUMA node
+   if (auto v = std::getenv("nodeLocalPools")) GlobalPool::nodeLocal = atoi(v);
+   // scans read their columns ahead into the page cache with async I/O
+   if (auto v = std::getenv("readAhead")) ReadAhead::enabled = atoi(v);
+   // windows of 64K tuples read ahead of each scan
+   if (auto v = std::getenv("readAheadDepth")) ReadAhead::depth = atoi(v);
+   // 1MB buffers of the reader of each scan, 0 only advises the kernel
+   if (auto v = std::getenv("readAheadBuffers")) ReadAhead::buffers = atoi(v);
    if (auto v = std::getenv("q")) {
      using namespace std;
      istringstream iss((string(v)));
@@ -75,6 +104,7 @@ int main(int argc, char* argv[]) {
    }
 
    tbb::task_scheduler_init scheduler(nrThreads);
+   ArenaPlacement arenaPlacement(nrThreads);
    if (q.count("1.1h")) e.timeAndProfile("q1.1 hyper     ", nrTuples(ssb, {"date", "lineorder"}), [&]() { if(clearCaches) clearOsCaches(); auto result = q11_hyper(ssb, nrThreads); escape(&result);}, repetitions);
    if (q.count("1.1v")) e.timeAndProfile("q1.1 vectorwise", nrTuples(ssb, {"date", "lineorder"}), [&]() { if(clearCaches) clearOsCaches(); auto result = q11_vectorwise(ssb, nrThreads, vectorSize); escape(&result);}, repetitions);
    if (q.count("1.2h")) e.timeAndProfile("q1.2 hyper     ", nrTuples(ssb, {"date", "lineorder"}), [&]() { if(clearCaches) clearOsCaches(); auto result = q12_hyper(ssb, nrThreads); escape(&result);}, repetitions);
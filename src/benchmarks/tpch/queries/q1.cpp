@@ -57,7 +57,8 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q1_hyper(Database& db,
 
    auto groupOp = make_GroupBy<tuple<Char<1>, Char<1>>,
                                tuple<Numeric<12, 2>, Numeric<12, 2>,
-                                     Numeric<12, 4>, Numeric<12, 6>, int64_t>,
+                                     Numeric<12, 4>, NumericSum<12, 6>,
+                                     int64_t>,
                                hash>(
        [](auto& acc, auto&& value) {
           get<0>(acc) += get<0>(value);
@@ -67,15 +68,18 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q1_hyper(Database& db,
           get<4>(acc) += get<4>(value);
        },
        make_tuple(Numeric<12, 2>(), Numeric<12, 2>(), Numeric<12, 4>(),
-                  Numeric<12, 6>(), int64_t(0)),
+                  NumericSum<12, 6>(), int64_t(0)),
        nrThreads);
 
+   auto ahead = runtime::ReadAhead::create(
+       li, {"l_returnflag", "l_linestatus", "l_extendedprice", "l_discount",
+            "l_tax", "l_quantity", "l_shipdate"});
 
-   tbb::parallel_for(
-       tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
-       [&](const tbb::blocked_range<size_t>& r) {
+   runtime::Scheduler::global().parallelFor(
+       li.nrTuples, morselSize, [&](size_t begin, size_t end) {
+          runtime::ReadAhead::advance(ahead.get(), begin);
           auto locals = groupOp.preAggLocals();
-          for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
+          for (size_t i = begin; i != end; ++i) {
              if (l_shipdate[i] <= c1) {
                 auto& group = locals.getGroup(make_tuple(l_returnflag[i], l_linestatus[i]));
 
@@ -98,7 +102,8 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q1_hyper(Database& db,
        result->addAttribute("sum_base_price", sizeof(Numeric<12, 2>));
    auto disc_priceAttr =
        result->addAttribute("sum_disc_price", sizeof(Numeric<12, 2>));
-   auto chargeAttr = result->addAttribute("sum_charge", sizeof(Numeric<12, 2>));
+   auto chargeAttr =
+       result->addAttribute("sum_charge", sizeof(NumericSum<12, 6>));
    auto count_orderAttr = result->addAttribute("count_order", sizeof(int64_t));
 
    groupOp.forallGroups([&](runtime::Stack<decltype(groupOp)::group_t>& /*auto&*/ entries) {
@@ -111,7 +116,8 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q1_hyper(Database& db,
           reinterpret_cast<Numeric<12, 2>*>(block.data(base_priceAttr));
       auto disc_price =
           reinterpret_cast<Numeric<12, 4>*>(block.data(disc_priceAttr));
-      auto charge = reinterpret_cast<Numeric<12, 6>*>(block.data(chargeAttr));
+      auto charge =
+          reinterpret_cast<NumericSum<12, 6>*>(block.data(chargeAttr));
       auto count_order =
           reinterpret_cast<int64_t*>(block.data(count_orderAttr));
       for (auto block : entries)
@@ -127,7 +133,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q1_hyper(Database& db,
       block.addedElements(n);
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -188,30 +194,27 @@ std::unique_ptr<Q1Builder::Q1> Q1Builder::getQuery() {
                Buffer(linestatus, sizeof(Char_1)))
        .padToAlign(sizeof(types::Numeric<12, 4>))
        .addValue(Buffer(disc_price), primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_plus_int64_t_col,
+                 conf.aggr_plus_int64_t_col(),
                  primitives::aggr_row_plus_int64_t_col,
                  primitives::gather_val_int64_t_col,
                  Buffer(sum_disc_price, sizeof(types::Numeric<12, 4>)))
-       .addValue(Buffer(charge), primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_plus_int64_t_col,
-                 primitives::aggr_row_plus_int64_t_col,
-                 primitives::gather_val_int64_t_col,
-                 Buffer(sum_charge, sizeof(types::Numeric<12, 4>)))
+       .addWideSum(Buffer(charge),
+                   Buffer(sum_charge, sizeof(types::NumericSum<12, 6>)))
        .addValue(Column(lineitem, "l_quantity"), Buffer(sel_date),
                  primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_sel_plus_int64_t_col,
+                 conf.aggr_sel_plus_int64_t_col(),
                  primitives::aggr_row_plus_int64_t_col,
                  primitives::gather_val_int64_t_col,
                  Buffer(sum_qty, sizeof(types::Numeric<12, 2>)))
        .addValue(Column(lineitem, "l_extendedprice"), Buffer(sel_date),
                  primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_sel_plus_int64_t_col,
+                 conf.aggr_sel_plus_int64_t_col(),
                  primitives::aggr_row_plus_int64_t_col,
                  primitives::gather_val_int64_t_col,
                  Buffer(sum_base_price, sizeof(types::Numeric<12, 2>)))
        .addValue(Buffer(charge, sizeof(uint64_t)),
                  primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_count_star,
+                 conf.aggr_count_star(),
                  primitives::aggr_row_plus_int64_t_col,
                  primitives::gather_val_int64_t_col,
                  Buffer(count_order, sizeof(uint64_t)));
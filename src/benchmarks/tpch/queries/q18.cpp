@@ -5,6 +5,7 @@
 #include "common/runtime/Stack.hpp"
 #include "common/runtime/Types.hpp"
 #include "hyper/GroupBy.hpp"
+#include "hyper/GroupJoin.hpp"
 #include "hyper/ParallelHelper.hpp"
 #include "tbb/tbb.h"
 #include "vectorwise/Operations.hpp"
@@ -63,7 +64,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
    auto l_orderkey = li["l_orderkey"].data<types::Integer>();
    auto l_quantity = li["l_quantity"].data<types::Numeric<12, 2>>();
 
-   tbb::enumerable_thread_specific<
+   runtime::thread_specific<
        Hashmapx<types::Integer, types::Numeric<12, 2>, hash, false>>
        groups;
 
@@ -73,8 +74,10 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
        [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // scan lineitem and group by l_orderkey
+   auto liAhead = runtime::ReadAhead::create(li, {"l_orderkey", "l_quantity"});
    tbb::parallel_for(tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
                      [&](const tbb::blocked_range<size_t>& r) {
+                        runtime::ReadAhead::advance(liAhead.get(), r.begin());
                         auto locals = groupOp.preAggLocals();
 
                         for (size_t i = r.begin(), end = r.end(); i != end;
@@ -86,8 +89,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
                      });
 
    Hashset<types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    const auto threeHundret = types::Numeric<12, 2>::castString("300");
    std::atomic<size_t> nrGroups;
    nrGroups = 0;
@@ -112,8 +114,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
    auto c_custkey = cu["c_custkey"].data<types::Integer>();
    auto c_name = cu["c_name"].data<types::Char<25>>();
    Hashmapx<types::Integer, types::Char<25>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
 
    PARALLEL_SCAN(cu.nrTuples, entries2, {
       entries.emplace_back(ht2.hash(c_custkey[i]), c_custkey[i], c_name[i]);
@@ -121,13 +122,13 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
    ht2.setSize(cu.nrTuples);
    parallel_insert(entries2, ht2);
 
-   // build last hashtable
-   Hashmapx<types::Integer, std::tuple<types::Integer, types::Date,
-                                       types::Numeric<12, 2>, types::Char<25>>,
-            hash>
-       ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   // build groupjoin of orders with lineitem on o_orderkey = l_orderkey,
+   // lineitem is aggregated directly into the orders entries
+   GroupJoin<types::Integer,
+             std::tuple<types::Integer, types::Date, types::Numeric<12, 2>,
+                        types::Char<25>>,
+             types::Numeric<12, 2>, hash>
+       groupJoin(zero);
 
    auto& ord = db["orders"];
    auto o_orderkey = ord["o_orderkey"].data<types::Integer>();
@@ -135,41 +136,37 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
    auto o_orderdate = ord["o_orderdate"].data<types::Date>();
    auto o_totalprice = ord["o_totalprice"].data<types::Numeric<12, 2>>();
    // scan orders
-   auto found = PARALLEL_SELECT(ord.nrTuples, entries3, {
-      types::Char<25>* name;
-      // check if it matches the order criteria and look up the customer name
-      if (ht1.contains(o_orderkey[i]) && (name = ht2.findOne(o_custkey[i]))) {
-         entries.emplace_back(
-             ht3.hash(o_orderkey[i]), o_orderkey[i],
-             make_tuple(o_custkey[i], o_orderdate[i], o_totalprice[i], *name));
-         found++;
-      }
-   });
-   ht3.setSize(found);
-   parallel_insert(entries3, ht3);
-
-   auto finalGroupOp = make_GroupBy<
-       std::tuple<types::Integer, types::Date, types::Numeric<12, 2>,
-                  types::Char<25>, types::Integer>,
-       types::Numeric<12, 2>, hash>(
-       [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
-
-   // scan lineitem and group by l_orderkey
+   auto ordAhead = runtime::ReadAhead::create(
+       ord, {"o_orderkey", "o_custkey", "o_orderdate", "o_totalprice"});
    tbb::parallel_for(
-       tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
+       tbb::blocked_range<size_t>(0, ord.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
-          auto locals = finalGroupOp.preAggLocals();
-
+          runtime::ReadAhead::advance(ordAhead.get(), r.begin());
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
-             std::tuple<types::Integer, types::Date, types::Numeric<12, 2>,
-                        types::Char<25>>* v;
-             if ((v = ht3.findOne(l_orderkey[i]))) {
-                auto& group =
-                    locals.getGroup(tuple_cat(*v, make_tuple(l_orderkey[i])));
-                group += l_quantity[i];
-             }
+             types::Char<25>* name;
+             // check if it matches the order criteria and look up the
+             // customer name
+             if (ht1.contains(o_orderkey[i]) &&
+                 (name = ht2.findOne(o_custkey[i])))
+                groupJoin.build(o_orderkey[i],
+                                make_tuple(o_custkey[i], o_orderdate[i],
+                                           o_totalprice[i], *name));
           }
        });
+   groupJoin.finishBuild();
+
+   // scan lineitem and aggregate into the matching orders, the first scan
+   // may have been evicted again
+   liAhead = runtime::ReadAhead::create(li, {"l_orderkey", "l_quantity"});
+   tbb::parallel_for(tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
+                     [&](const tbb::blocked_range<size_t>& r) {
+                        runtime::ReadAhead::advance(liAhead.get(), r.begin());
+                        for (size_t i = r.begin(), end = r.end(); i != end;
+                             ++i)
+                           groupJoin.probe(l_orderkey[i], [&](auto& acc) {
+                              acc += l_quantity[i];
+                           });
+                     });
 
    auto& result = resources.query->result;
    auto namAttr = result->addAttribute("c_name", sizeof(types::Char<25>));
@@ -180,9 +177,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
        result->addAttribute("o_totalprice", sizeof(types::Numeric<12, 2>));
    auto sumAttr = result->addAttribute("sum", sizeof(types::Numeric<12, 2>));
 
-   finalGroupOp.forallGroups([&](auto& groups) {
-      // write aggregates to result
-      auto n = groups.size();
+   groupJoin.forallGroups([&](auto& groups) {
+      // write aggregates of groups with join partners to result
+      size_t n = 0;
+      for (auto block : groups)
+         for (auto& group : block) n += group.v.matched;
+      if (!n) return;
       auto block = result->createBlock(n);
       auto name = reinterpret_cast<types::Char<25>*>(block.data(namAttr));
       auto cky = reinterpret_cast<types::Integer*>(block.data(ckyAttr));
@@ -192,18 +192,19 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q18_hyper(Database& db,
       auto sum = reinterpret_cast<types::Numeric<12, 2>*>(block.data(sumAttr));
       for (auto block : groups)
          for (auto& group : block) {
-            auto& k = group.k;
-            *name++ = std::get<3>(k);
-            *cky++ = get<0>(k);
-            *oky++ = get<4>(k);
-            *dat++ = get<1>(k);
-            *tot++ = get<2>(k);
-            *sum++ = group.v;
+            if (!group.v.matched) continue;
+            auto& v = group.v.v;
+            *name++ = get<3>(v);
+            *cky++ = get<0>(v);
+            *oky++ = group.k;
+            *dat++ = get<1>(v);
+            *tot++ = get<2>(v);
+            *sum++ = group.v.a;
          }
       block.addedElements(n);
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -215,6 +216,15 @@ std::unique_ptr<Q18Builder::Q18> Q18Builder::getQuery() {
 
    auto r = make_unique<Q18>();
    auto customer = Scan("customer");
+   // c_name is copied into the hash tables of the customer join and the
+   // group join, the customer row id can be carried instead
+   auto late = materializeLate(customer, "c_name", 2, r->customerSelectivity);
+   auto nameSize = late ? sizeof(uint64_t) : sizeof(types::Char<25>);
+   auto scatterName = late ? primitives::scatter_int64_t_col
+                           : primitives::scatter_Char_25_col;
+   auto gatherName = late ? primitives::gather_col_int64_t_col
+                          : primitives::gather_col_Char_25_col;
+   if (late) RowIds(customer, Buffer(c_name, nameSize));
    auto lineitem = Scan("lineitem");
    HashGroup()
        .addKey(Column(lineitem, "l_orderkey"), primitives::hash_int32_t_col,
@@ -253,91 +263,47 @@ std::unique_ptr<Q18Builder::Q18> Q18Builder::getQuery() {
        .addProbeKey(Column(orders, "o_custkey"), Buffer(orders_matches),
                     primitives::hash_sel_int32_t_col,
                     primitives::keys_equal_int32_t_col)
-       .addBuildValue(Column(customer, "c_name"),
-                      primitives::scatter_Char_25_col,
-                      Buffer(c_name, sizeof(types::Char<25>)),
-                      primitives::gather_col_Char_25_col);
+       .addBuildValue(late ? Buffer(c_name) : Column(customer, "c_name"),
+                      scatterName, Buffer(c_name, nameSize), gatherName);
    auto lineitem2 = Scan("lineitem");
-   HashJoin(Buffer(lineitem_matches, sizeof(pos_t)))
+   // groupjoin: o_orderkey is unique, lineitem is aggregated directly into the
+   // orders entries of the join
+   HashJoin(Buffer(lineitem_matches, sizeof(pos_t)), Hashjoin::Mode::Group)
        .addBuildKey(Column(orders, "o_orderkey"), Buffer(customer_matches),
                     primitives::hash_sel_int32_t_col,
                     primitives::scatter_sel_int32_t_col)
        .addProbeKey(Column(lineitem2, "l_orderkey"),
                     primitives::hash_int32_t_col,
                     primitives::keys_equal_int32_t_col)
+       .addBuildValue(Column(orders, "o_orderkey"), Buffer(customer_matches),
+                      primitives::scatter_sel_int32_t_col,
+                      Buffer(group_l_orderkey, sizeof(int32_t)),
+                      primitives::gather_col_int32_t_col)
        .addBuildValue(Column(orders, "o_custkey"), Buffer(customer_matches),
                       primitives::scatter_sel_int32_t_col,
-                      Buffer(o_custkey, sizeof(int32_t)),
+                      Buffer(group_o_custkey, sizeof(int32_t)),
                       primitives::gather_col_int32_t_col)
        .addBuildValue(Column(orders, "o_orderdate"), Buffer(customer_matches),
                       primitives::scatter_sel_Date_col,
-                      Buffer(o_orderdate, sizeof(types::Date)),
+                      Buffer(group_o_orderdate, sizeof(types::Date)),
                       primitives::gather_col_Date_col)
        .addBuildValue(Column(orders, "o_totalprice"), Buffer(customer_matches),
                       primitives::scatter_sel_int64_t_col,
-                      Buffer(o_totalprice, sizeof(types::Numeric<12, 2>)),
+                      Buffer(group_o_totalprice, sizeof(types::Numeric<12, 2>)),
                       primitives::gather_col_int64_t_col)
-       .addBuildValue(Buffer(c_name), primitives::scatter_Char_25_col,
-                      Buffer(c_name2, sizeof(types::Char<25>)),
-                      primitives::gather_col_Char_25_col);
-   HashGroup() //
-       .pushKeySelVec(Buffer(lineitem_matches),
-                      Buffer(lineitem_matches_grouped, sizeof(pos_t)))
-       .addKey(Buffer(c_name2), primitives::hash_Char_25_col,
-               primitives::keys_not_equal_Char_25_col,
-               primitives::partition_by_key_Char_25_col,
-               primitives::scatter_sel_Char_25_col,
-               primitives::keys_not_equal_row_Char_25_col,
-               primitives::partition_by_key_row_Char_25_col,
-               primitives::scatter_sel_row_Char_25_col,
-               primitives::gather_val_Char_25_col,
-               Buffer(group_c_name, sizeof(types::Char<25>)))
-       .addKey(Buffer(o_custkey), primitives::rehash_int32_t_col,
-               primitives::keys_not_equal_int32_t_col,
-               primitives::partition_by_key_int32_t_col,
-               primitives::scatter_sel_int32_t_col,
-               primitives::keys_not_equal_row_int32_t_col,
-               primitives::partition_by_key_row_int32_t_col,
-               primitives::scatter_sel_row_int32_t_col,
-               primitives::gather_val_int32_t_col,
-               Buffer(group_o_custkey, sizeof(int32_t)))
-       .addKey(Buffer(o_orderdate), primitives::rehash_Date_col,
-               primitives::keys_not_equal_Date_col,
-               primitives::partition_by_key_Date_col,
-               primitives::scatter_sel_Date_col,
-               primitives::keys_not_equal_row_Date_col,
-               primitives::partition_by_key_row_Date_col,
-               primitives::scatter_sel_row_Date_col,
-               primitives::gather_val_Date_col,
-               Buffer(group_o_orderdate, sizeof(types::Date)))
-       .addKey(Buffer(o_totalprice), primitives::rehash_int64_t_col,
-               primitives::keys_not_equal_int64_t_col,
-               primitives::partition_by_key_int64_t_col,
-               primitives::scatter_sel_int64_t_col,
-               primitives::keys_not_equal_row_int64_t_col,
-               primitives::partition_by_key_row_int64_t_col,
-               primitives::scatter_sel_row_int64_t_col,
-               primitives::gather_val_int64_t_col,
-               Buffer(group_o_totalprice, sizeof(int64_t)))
-       .addKey(Column(lineitem2, "l_orderkey"), Buffer(lineitem_matches),
-               primitives::rehash_sel_int32_t_col,
-               primitives::keys_not_equal_sel_int32_t_col,
-               primitives::partition_by_key_sel_int32_t_col,
-               Buffer(lineitem_matches_grouped, sizeof(pos_t)),
-               primitives::scatter_sel_int32_t_col,
-               primitives::keys_not_equal_row_int32_t_col,
-               primitives::partition_by_key_row_int32_t_col,
-               primitives::scatter_sel_row_int32_t_col,
-               primitives::gather_val_int32_t_col,
-               Buffer(group_l_orderkey, sizeof(int32_t)))
-       .addValue(Column(lineitem2, "l_quantity"), Buffer(lineitem_matches),
-                 primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_sel_plus_int64_t_col,
-                 primitives::aggr_row_plus_int64_t_col,
-                 primitives::gather_val_int64_t_col,
-                 Buffer(group_sum, sizeof(types::Numeric<12, 2>)));
-
-   result.addValue("c_name", Buffer(group_c_name))
+       .addBuildValue(Buffer(c_name), scatterName,
+                      Buffer(group_c_name, nameSize), gatherName)
+       .addGroupAggregate(Column(lineitem2, "l_quantity"),
+                          primitives::aggr_init_plus_int64_t_col,
+                          primitives::aggr_sel_atomic_plus_int64_t_col,
+                          Buffer(group_sum, sizeof(types::Numeric<12, 2>)),
+                          primitives::gather_col_int64_t_col);
+   if (late)
+      Materialize().addColumn(customer, "c_name", Buffer(group_c_name),
+                              primitives::materialize_rowid_Char_25_col,
+                              Buffer(late_c_name, sizeof(types::Char<25>)));
+
+   result.addValue("c_name", Buffer(late ? late_c_name : group_c_name))
        .addValue("c_custkey", Buffer(group_o_custkey))
        .addValue("o_orderkey", Buffer(group_l_orderkey))
        .addValue("o_orderdate", Buffer(group_o_orderdate))
@@ -73,8 +73,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q3_hyper(Database& db,
 
    // build ht for first join
    Hashset<types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto found1 = tbb::parallel_reduce(
        range(0, cu.nrTuples, morselSize), 0,
        [&](const tbb::blocked_range<size_t>& r, const size_t& f) {
@@ -94,11 +93,13 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q3_hyper(Database& db,
 
    // join and build second ht
    Hashmapx<types::Integer, std::tuple<types::Date, types::Integer>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
+   auto ordAhead = runtime::ReadAhead::create(
+       ord, {"o_orderdate", "o_custkey", "o_orderkey", "o_shippriority"});
    auto found2 = tbb::parallel_reduce(
        range(0, ord.nrTuples, morselSize), 0,
        [&](const tbb::blocked_range<size_t>& r, const size_t& f) {
+          runtime::ReadAhead::advance(ordAhead.get(), r.begin());
           auto& entries = entries2.local();
           auto found = f;
           for (size_t i = r.begin(), end = r.end(); i != end; ++i)
@@ -117,7 +118,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q3_hyper(Database& db,
    const auto one = types::Numeric<12, 2>::castString("1.00");
    const auto zero = types::Numeric<12, 4>::castString("0.00");
 
-   tbb::enumerable_thread_specific<
+   runtime::thread_specific<
        Hashmapx<std::tuple<types::Integer, types::Date, types::Integer>,
                 types::Numeric<12, 4>, hash, false>>
        groups;
@@ -128,9 +129,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q3_hyper(Database& db,
            [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto liAhead = runtime::ReadAhead::create(
+       li, {"l_shipdate", "l_orderkey", "l_extendedprice", "l_discount"});
    tbb::parallel_for(
        tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
+          runtime::ReadAhead::advance(liAhead.get(), r.begin());
           auto locals = groupOp.preAggLocals();
 
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
@@ -170,7 +174,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q3_hyper(Database& db,
       block.addedElements(n);
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -191,6 +195,7 @@ std::unique_ptr<Q3Builder::Q3> Q3Builder::getQuery() {
                              Column(order, "o_orderdate"),               //
                              Value(&r->c2)));
    HashJoin(Buffer(cust_ord, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .setProbeSelVector(Buffer(sel_order), conf.joinSel())
        .addBuildKey(Column(customer, "c_custkey"),       //
                     Buffer(sel_cust),                    //
@@ -206,6 +211,7 @@ std::unique_ptr<Q3Builder::Q3> Q3Builder::getQuery() {
                              Column(lineitem, "l_shipdate"),                //
                              Value(&r->c3)));
    HashJoin(Buffer(j1_lineitem, sizeof(pos_t)), conf.joinAll()) //
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .setProbeSelVector(Buffer(sel_lineitem), conf.joinSel())
        .addBuildKey(Column(order, "o_orderkey"), //
                     Buffer(cust_ord),            //
@@ -69,8 +69,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
    auto r_regionkey = re["r_regionkey"].data<types::Integer>();
    // --- select region and build ht
    Hashset<types::Integer, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    auto found1 = PARALLEL_SELECT(re.nrTuples, entries1, {
       if (r_name[i] == c3) {
          entries.emplace_back(ht1.hash(r_regionkey[i]), r_regionkey[i]);
@@ -85,8 +84,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
    auto n_nationkey = na["n_nationkey"].data<types::Integer>();
    auto n_name = na["n_name"].data<types::Char<25>>();
    Hashmapx<types::Integer, types::Char<25>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-       entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto found2 = PARALLEL_SELECT(na.nrTuples, entries2, {
       if (ht1.contains(n_regionkey[i])) {
          entries.emplace_back(ht2.hash(n_nationkey[i]), n_nationkey[i],
@@ -102,8 +100,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
    auto c_custkey = cu["c_custkey"].data<types::Integer>();
    Hashmapx<types::Integer, std::tuple<types::Integer, types::Char<25>>, hash>
        ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-       entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
 
    auto found3 = PARALLEL_SELECT(cu.nrTuples, entries3, {
       decltype(ht2)::value_type* v;
@@ -122,8 +119,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
    auto o_custkey = ord["o_custkey"].data<types::Integer>();
    Hashmapx<types::Integer, std::tuple<types::Integer, types::Char<25>>, hash>
        ht4;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht4)::Entry>>
-       entries4;
+   runtime::thread_specific<runtime::Stack<decltype(ht4)::Entry>> entries4;
 
    auto found4 = PARALLEL_SELECT(ord.nrTuples, entries4, {
       decltype(ht3)::value_type* v;
@@ -140,8 +136,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
    auto s_suppkey = su["s_suppkey"].data<types::Integer>();
    auto s_nationkey = su["s_nationkey"].data<types::Integer>();
    Hashset<std::tuple<types::Integer, types::Integer>, hash> ht5;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht5)::Entry>>
-       entries5;
+   runtime::thread_specific<runtime::Stack<decltype(ht5)::Entry>> entries5;
 
    PARALLEL_SCAN(su.nrTuples, entries5, {
       auto key = make_tuple(s_suppkey[i], s_nationkey[i]);
@@ -164,9 +159,12 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
        [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
 
    // preaggregation
+   auto liAhead = runtime::ReadAhead::create(
+       li, {"l_orderkey", "l_suppkey", "l_extendedprice", "l_discount"});
    tbb::parallel_for(
        tbb::blocked_range<size_t>(0, li.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
+          runtime::ReadAhead::advance(liAhead.get(), r.begin());
           auto groupLocals = groupOp.preAggLocals();
 
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
@@ -200,7 +198,7 @@ NOVECTORIZE std::unique_ptr<runtime::Query> q5_hyper(Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -218,6 +216,7 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                           Value(&r->c3)));
    auto nation = Scan("nation");
    HashJoin(Buffer(join_reg_nat, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(region, "r_regionkey"), Buffer(sel_region),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -225,6 +224,7 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                     primitives::keys_equal_int32_t_col);
    auto customer = Scan("customer");
    HashJoin(Buffer(join_cust, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(nation, "n_nationkey"), Buffer(join_reg_nat),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -245,6 +245,7 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                      Buffer(sel_ord2, sizeof(pos_t)),
                      Column(orders, "o_orderdate"), Value(&r->c1)));
    HashJoin(Buffer(join_ord, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .setProbeSelVector(Buffer(sel_ord2), conf.joinSel())
        .addBuildKey(Column(customer, "c_custkey"), Buffer(join_cust),
                     conf.hash_sel_int32_t_col(),
@@ -261,6 +262,7 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                       primitives::gather_col_Char_25_col);
    auto lineitem = Scan("lineitem");
    HashJoin(Buffer(join_line, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(orders, "o_orderkey"), Buffer(join_ord),
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
@@ -275,6 +277,7 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                       Buffer(n_name, sizeof(Char_25)),
                       primitives::gather_col_Char_25_col);
    HashJoin(Buffer(join_supp, sizeof(pos_t)), conf.joinAll())
+       .setUniqueBuildKeys(conf.useUniqueJoin)
        .addBuildKey(Column(supplier, "s_nationkey"),
                      conf.hash_int32_t_col(),
                     primitives::scatter_int32_t_col)
@@ -289,6 +292,8 @@ unique_ptr<Q5Builder::Q5> Q5Builder::getQuery() {
                     conf.rehash_sel_int32_t_col(),
                     Buffer(join_supp_line, sizeof(pos_t)),
                     primitives::keys_equal_int32_t_col);
+   // suppliers do not depend on the region, customer and orders chain
+   BuildConcurrently({Buffer(join_supp), Buffer(join_line)});
    Project().addExpression(
        Expression()
            .addOp(primitives::proj_sel_minus_int64_t_val_int64_t_col,
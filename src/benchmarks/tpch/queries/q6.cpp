@@ -1,4 +1,5 @@
 #include "benchmarks/tpch/Queries.hpp"
+#include "common/runtime/ReadAhead.hpp"
 #include "common/runtime/Types.hpp"
 #include "tbb/tbb.h"
 #include "vectorwise/Operations.hpp"
@@ -7,6 +8,7 @@
 #include "vectorwise/QueryBuilder.hpp"
 #include "vectorwise/VectorAllocator.hpp"
 #include <iostream>
+#include <mutex>
 
 using namespace runtime;
 using namespace std;
@@ -32,10 +34,13 @@ NOVECTORIZE Relation q6_hyper(Database& db, size_t /*nrThreads*/) {
        rel["l_extendedprice"].data<types::Numeric<12, 2>>();
    auto l_discount_col = rel["l_discount"].data<types::Numeric<12, 2>>();
 
+   auto ahead = runtime::ReadAhead::create(
+       rel, {"l_shipdate", "l_quantity", "l_extendedprice", "l_discount"});
    revenue = tbb::parallel_reduce(
        tbb::blocked_range<size_t>(0, rel.nrTuples), types::Numeric<12, 4>(0),
        [&](const tbb::blocked_range<size_t>& r,
            const types::Numeric<12, 4>& s) {
+          runtime::ReadAhead::advance(ahead.get(), r.begin());
           auto revenue = s;
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
              auto& l_shipdate = l_shipdate_col[i];
@@ -76,33 +81,54 @@ unique_ptr<Q6Builder::Q6> Q6Builder::getQuery() {
    assert(db["lineitem"]["l_extendedprice"].type->rt_size() == sizeof(int64_t));
 
    auto lineitem = Scan("lineitem");
-   Select((Expression()                                       //
-              .addOp(conf.sel_less_int32_t_col_int32_t_val(), //
-                     Buffer(sel_a, sizeof(pos_t)),            //
-                     Column(lineitem, "l_shipdate"),          //
-                     Value(&consts.c2)))
-              .addOp(conf.selsel_greater_equal_int32_t_col_int32_t_val(), //
-                     Buffer(sel_a, sizeof(pos_t)),                        //
-                     Buffer(sel_b, sizeof(pos_t)),                        //
-                     Column(lineitem, "l_shipdate"),                      //
-                     Value(&consts.c1))
-             .addOp(conf.selsel_less_int64_t_col_int64_t_val(), //
-             // .addOp(primitives::selsel_less_int64_t_col_int64_t_val_bf, //
-                     Buffer(sel_b, sizeof(pos_t)),               //
-                     Buffer(sel_a, sizeof(pos_t)),               //
-                     Column(lineitem, "l_quantity"),             //
-                     Value(&consts.c5))
-              .addOp(conf.selsel_greater_equal_int64_t_col_int64_t_val(), //
-              //.addOp(primitives::selsel_greater_equal_int64_t_col_int64_t_val_bf, //
-                     Buffer(sel_a, sizeof(pos_t)),                        //
-                     Buffer(sel_b, sizeof(pos_t)),                        //
-                     Column(lineitem, "l_discount"),                      //
-                     Value(&consts.c3))
-              .addOp(conf.selsel_less_equal_int64_t_col_int64_t_val(), //
-                     Buffer(sel_b, sizeof(pos_t)),                     //
-                     Buffer(sel_a, sizeof(pos_t)),                     //
-                     Column(lineitem, "l_discount"),                   //
-                     Value(&consts.c4)));
+   if (conf.useSimdSel)
+      // the range primitives have no AVX-512 variants, chain comparisons
+      Select((Expression()                                       //
+                 .addOp(conf.sel_less_int32_t_col_int32_t_val(), //
+                        Buffer(sel_a, sizeof(pos_t)),            //
+                        Column(lineitem, "l_shipdate"),          //
+                        Value(&consts.c2)))
+                 .addOp(conf.selsel_greater_equal_int32_t_col_int32_t_val(), //
+                        Buffer(sel_a, sizeof(pos_t)),                        //
+                        Buffer(sel_b, sizeof(pos_t)),                        //
+                        Column(lineitem, "l_shipdate"),                      //
+                        Value(&consts.c1))
+                 .addOp(conf.selsel_less_int64_t_col_int64_t_val(), //
+                        Buffer(sel_b, sizeof(pos_t)),               //
+                        Buffer(sel_a, sizeof(pos_t)),               //
+                        Column(lineitem, "l_quantity"),             //
+                        Value(&consts.c5))
+                 .addOp(conf.selsel_greater_equal_int64_t_col_int64_t_val(), //
+                        Buffer(sel_a, sizeof(pos_t)),                        //
+                        Buffer(sel_b, sizeof(pos_t)),                        //
+                        Column(lineitem, "l_discount"),                      //
+                        Value(&consts.c3))
+                 .addOp(conf.selsel_less_equal_int64_t_col_int64_t_val(), //
+                        Buffer(sel_b, sizeof(pos_t)),                     //
+                        Buffer(sel_a, sizeof(pos_t)),                     //
+                        Column(lineitem, "l_discount"),                   //
+                        Value(&consts.c4)));
+   else
+      // each range is selected in a single pass
+      Select((Expression() //
+                 .addOp(BF(primitives::
+                       sel_between_halfopen_Date_col_Date_val_Date_val),
+                        Buffer(sel_a, sizeof(pos_t)),   //
+                        Column(lineitem, "l_shipdate"), //
+                        Value(&consts.c1),              //
+                        Value(&consts.c2)))
+                 .addOp(BF(primitives::selsel_less_int64_t_col_int64_t_val), //
+                        Buffer(sel_a, sizeof(pos_t)),                        //
+                        Buffer(sel_b, sizeof(pos_t)),                        //
+                        Column(lineitem, "l_quantity"),                      //
+                        Value(&consts.c5))
+                 .addOp(BF(primitives::
+                       selsel_between_int64_t_col_int64_t_val_int64_t_val),
+                        Buffer(sel_b, sizeof(pos_t)),   //
+                        Buffer(sel_a, sizeof(pos_t)),   //
+                        Column(lineitem, "l_discount"), //
+                        Value(&consts.c3),              //
+                        Value(&consts.c4)));
    Project().addExpression(
        Expression() //
            .addOp(primitives::proj_sel_both_multiplies_int64_t_col_int64_t_col,
@@ -110,8 +136,9 @@ unique_ptr<Q6Builder::Q6> Q6Builder::getQuery() {
                   Buffer(result_project, sizeof(int64_t)), //
                   Column(lineitem, "l_discount"),
                   Column(lineitem, "l_extendedprice")));
+   // summed in 128 bits, as the revenue of a worker may exceed 64 bits
    FixedAggregation(Expression() //
-                        .addOp(primitives::aggr_static_plus_int64_t_col,
+                        .addOp(conf.aggr_static_wide_plus_int64_t_col(),
                                Value(&consts.aggregator), //
                                Buffer(result_project)));
    res->rootOp = popOperator();
@@ -127,8 +154,8 @@ Relation q6_vectorwise(Database& db, size_t nrThreads, size_t vectorSize) {
    vectorwise::SharedStateManager shared;
    WorkerGroup workers(nrThreads);
    GlobalPool pool;
-   std::atomic<int64_t> aggr;
-   aggr = 0;
+   std::mutex aggrMutex;
+   types::NumericSum<12, 4> aggr;
    n = 0;
    workers.run([&]() {
       Q6Builder b(db, shared, vectorSize);
@@ -136,7 +163,8 @@ Relation q6_vectorwise(Database& db, size_t nrThreads, size_t vectorSize) {
       auto query = b.getQuery();
       auto n_ = query->rootOp->next();
       if (n_) {
-         aggr.fetch_add(query->aggregator);
+         std::lock_guard<std::mutex> lock(aggrMutex);
+         aggr += query->aggregator;
          n.fetch_add(n_);
       }
 
@@ -147,7 +175,7 @@ Relation q6_vectorwise(Database& db, size_t nrThreads, size_t vectorSize) {
             auto& sum =
                 result["revenue"].template typedAccessForChange<int64_t>();
             sum.reset(1);
-            auto a = aggr.load();
+            auto a = aggr.castN().value;
             sum.push_back(a);
             result.nrTuples = 1;
          }
@@ -59,7 +59,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    using hash = runtime::CRC32Hash;
 
    // --- constants
-   auto contains = types::Varchar<55>::castString("green");
+   runtime::StringPattern contains("green");
 
    auto& na = db["nation"];
    auto& supp = db["supplier"];
@@ -68,8 +68,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    auto n_nationkey = na["n_nationkey"].data<types::Integer>();
    auto n_name = na["n_name"].data<types::Char<25>>();
    Hashmapx<types::Integer, types::Char<25>, hash> ht1;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht1)::Entry>>
-       entries1;
+   runtime::thread_specific<runtime::Stack<decltype(ht1)::Entry>> entries1;
    PARALLEL_SCAN(na.nrTuples, entries1, {
       auto& key = n_nationkey[i];
       entries.emplace_back(ht1.hash(key), key, n_name[i]);
@@ -80,8 +79,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
 
    // --- ht for bushy join
    Hashmapx<types::Integer, types::Char<25>, hash> ht2;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht2)::Entry>>
-     entries2;
+   runtime::thread_specific<runtime::Stack<decltype(ht2)::Entry>> entries2;
    auto s_suppkey = supp["s_suppkey"].data<types::Integer>();
    auto s_nationkey = supp["s_nationkey"].data<types::Integer>();
    // do join nation-supplier and put result into bushy ht
@@ -99,8 +97,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
 
    // --- ht for join part-partsupp
    Hashset<types::Integer, hash> ht3;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht3)::Entry>>
-     entries3;
+   runtime::thread_specific<runtime::Stack<decltype(ht3)::Entry>> entries3;
    auto& part = db["part"];
    auto p_partkey = part["p_partkey"].data<types::Integer>();
    auto p_name = part["p_name"].data<types::Varchar<55>>();
@@ -108,7 +105,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    auto found3 = PARALLEL_SELECT(part.nrTuples, entries3, {
        auto& pk = p_partkey[i];
        auto& pn = p_name[i];
-       if (memmem(pn.value, pn.len, contains.value, contains.len) != nullptr){
+       if (contains.containedIn(pn.value, pn.len)) {
           entries.emplace_back(ht3.hash(pk), pk);
           found++;
        }
@@ -119,8 +116,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    Hashmapx<tuple<types::Integer, types::Integer>,
             tuple<types::Char<25>, types::Numeric<12, 2>>, hash>
        ht4;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht4)::Entry>>
-       entries4;
+   runtime::thread_specific<runtime::Stack<decltype(ht4)::Entry>> entries4;
    auto& partsupp = db["partsupp"];
    auto ps_partkey = partsupp["ps_partkey"].data<types::Integer>();
    auto ps_suppkey = partsupp["ps_suppkey"].data<types::Integer>();
@@ -145,8 +141,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
              types::Numeric<12, 2>, types::Numeric<12, 2>, types::Char<25>>,
        hash>
        ht5;
-   tbb::enumerable_thread_specific<runtime::Stack<decltype(ht5)::Entry>>
-       entries5;
+   runtime::thread_specific<runtime::Stack<decltype(ht5)::Entry>> entries5;
    auto& li = db["lineitem"];
    auto l_orderkey = li["l_orderkey"].data<types::Integer>();
    auto l_partkey = li["l_partkey"].data<types::Integer>();
@@ -154,8 +149,11 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    auto l_extendedprice = li["l_extendedprice"].data<types::Numeric<12, 2>>();
    auto l_discount = li["l_discount"].data<types::Numeric<12, 2>>();
    auto l_quantity = li["l_quantity"].data<types::Numeric<12, 2>>();
+   auto liAhead = runtime::ReadAhead::create(
+       li, {"l_orderkey", "l_partkey", "l_suppkey", "l_extendedprice",
+            "l_discount", "l_quantity"});
    auto found5 =
-       PARALLEL_SELECT(li.nrTuples, entries5, {
+       PARALLEL_SELECT_AHEAD(li.nrTuples, liAhead.get(), entries5, {
           auto part = ht4.findOne(make_tuple(l_partkey[i], l_suppkey[i]));
           if (part) {
              auto& key = l_orderkey[i];
@@ -177,9 +175,12 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
    auto groupOp = make_GroupBy<tuple<types::Char<25>, types::Integer>, types::Numeric<12, 4>, hash>(
        [](auto& acc, auto&& value) { acc += value; }, zero, nrThreads);
    // preaggregation
+   auto ordAhead =
+       runtime::ReadAhead::create(ord, {"o_orderkey", "o_orderdate"});
    tbb::parallel_for(
        tbb::blocked_range<size_t>(0, ord.nrTuples, morselSize),
        [&](const tbb::blocked_range<size_t>& r) {
+          runtime::ReadAhead::advance(ordAhead.get(), r.begin());
           auto groupLocals = groupOp.preAggLocals();
 
           for (size_t i = r.begin(), end = r.end(); i != end; ++i) {
@@ -223,7 +224,7 @@ std::unique_ptr<runtime::Query> q9_hyper(runtime::Database& db,
       block.addedElements(groups.size());
    });
 
-   leaveQuery(nrThreads);
+   leaveQuery(resources);
    return move(resources.query);
 }
 
@@ -235,22 +236,29 @@ std::unique_ptr<Q9Builder::Q9> Q9Builder::getQuery(){
 
    auto r = make_unique<Q9>();
    auto nation = Scan("nation");
+   // n_name is copied into four join hash tables and the group keys, the
+   // nation row id can be carried instead and the names fetched per group
+   auto late = materializeLate(nation, "n_name", 5, r->groupSelectivity);
+   auto nameSize = late ? sizeof(uint64_t) : sizeof(Char_25);
+   auto scatterName = late ? primitives::scatter_int64_t_col
+                           : primitives::scatter_Char_25_col;
+   auto gatherName = late ? primitives::gather_col_int64_t_col
+                          : primitives::gather_col_Char_25_col;
+   if (late) RowIds(nation, Buffer(n_name, nameSize));
    auto supplier = Scan("supplier");
    //join nation supplier
    HashJoin(Buffer(nation_supplier, sizeof(pos_t)), conf.joinAll())
        .addBuildKey(Column(nation, "n_nationkey"), //
                     conf.hash_int32_t_col(),       //
                     primitives::scatter_int32_t_col)
-       .addBuildValue(Column(nation, "n_name"), //
-                      primitives::scatter_Char_25_col,
-                      Buffer(n_name, sizeof(Char_25)),
-                      primitives::gather_col_Char_25_col)
+       .addBuildValue(late ? Buffer(n_name) : Column(nation, "n_name"), //
+                      scatterName, Buffer(n_name, nameSize), gatherName)
        .addProbeKey(Column(supplier, "s_nationkey"), //
                     conf.hash_int32_t_col(),       //
                     primitives::keys_equal_int32_t_col);
 
    auto part = Scan("part");
-   Select(Expression().addOp(primitives::sel_contains_Varchar_55_col_Varchar_55_val,
+   Select(Expression().addOp(primitives::sel_like_contains_Varchar_55_col_pattern,
                              Buffer(sel_part, sizeof(pos_t)),
                              Column(part, "p_name"), //
                              Value(&r->contains)));
@@ -270,13 +278,14 @@ std::unique_ptr<Q9Builder::Q9> Q9Builder::getQuery(){
                     conf.hash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
        .addBuildValue(Buffer(n_name), //
-                      primitives::scatter_Char_25_col, Buffer(n_name),
-                      primitives::gather_col_Char_25_col)
+                      scatterName, Buffer(n_name), gatherName)
        .setProbeSelVector(Buffer(part_partsupp), conf.joinSel())
        .addProbeKey(Column(partsupp, "ps_suppkey"), //
                     Buffer(part_partsupp),          //
                     conf.hash_sel_int32_t_col(),
                     primitives::keys_equal_int32_t_col);
+   // selected parts and suppliers are independent of each other
+   BuildConcurrently({Buffer(pspp), Buffer(part_partsupp)});
 
    auto lineitem = Scan("lineitem");
    HashJoin(Buffer(xlineitem, sizeof(pos_t)), conf.joinAll())
@@ -288,10 +297,8 @@ std::unique_ptr<Q9Builder::Q9> Q9Builder::getQuery(){
                     Buffer(pspp),                       //
                     conf.rehash_sel_int32_t_col(),
                     primitives::scatter_sel_int32_t_col)
-       .addBuildValue(Buffer(n_name),                  //
-                      primitives::scatter_Char_25_col, //
-                      Buffer(n_name),                  //
-                      primitives::gather_col_Char_25_col)
+       .addBuildValue(Buffer(n_name), //
+                      scatterName, Buffer(n_name), gatherName)
        .addBuildValue(Column(partsupp, "ps_supplycost"), //
                       Buffer(pspp),                      //
                       primitives::scatter_sel_int64_t_col,
@@ -332,10 +339,8 @@ std::unique_ptr<Q9Builder::Q9> Q9Builder::getQuery(){
                       primitives::scatter_int64_t_col, //
                       Buffer(ps_supplycost),           //
                       primitives::gather_col_int64_t_col)
-       .addBuildValue(Buffer(n_name),                  //
-                      primitives::scatter_Char_25_col, //
-                      Buffer(n_name),                  //
-                      primitives::gather_col_Char_25_col);
+       .addBuildValue(Buffer(n_name), //
+                      scatterName, Buffer(n_name), gatherName);
 
    Project()
        // l_extendedprice * (1 - l_discount) - ps_supplycost * l_quantity as
@@ -363,33 +368,51 @@ std::unique_ptr<Q9Builder::Q9> Q9Builder::getQuery(){
                               Buffer(ordersx),                        //
                               Column(orders, "o_orderdate")));        //
 
-   HashGroup()
-       .addKey(Buffer(n_name), //
-               primitives::hash_Char_25_col,
-               primitives::keys_not_equal_Char_25_col,
-               primitives::partition_by_key_Char_25_col,
-               primitives::scatter_sel_Char_25_col,
-               primitives::keys_not_equal_row_Char_25_col,
-               primitives::partition_by_key_row_Char_25_col,
-               primitives::scatter_sel_row_Char_25_col,
-               primitives::gather_val_Char_25_col, Buffer(n_name))
-       .addKey(Buffer(o_year),            //
-               conf.rehash_int32_t_col(), //
-               primitives::keys_not_equal_int32_t_col,
-               primitives::partition_by_key_int32_t_col,
-               primitives::scatter_sel_int32_t_col,
-               primitives::keys_not_equal_row_int32_t_col,
-               primitives::partition_by_key_row_int32_t_col,
-               primitives::scatter_sel_row_int32_t_col,
-               primitives::gather_val_int32_t_col, Buffer(o_year))
-       .addValue(Buffer(amount), //
-                 primitives::aggr_init_plus_int64_t_col,
-                 primitives::aggr_plus_int64_t_col,
-                 primitives::aggr_row_plus_int64_t_col,
-                 primitives::gather_val_int64_t_col,
-                 Buffer(sum_profit, sizeof(int64_t)));
-
-   result.addValue("nation", Buffer(n_name))
+   {
+      auto group = HashGroup();
+      if (late)
+         group.addKey(Buffer(n_name), //
+                      primitives::hash_int64_t_col,
+                      primitives::keys_not_equal_int64_t_col,
+                      primitives::partition_by_key_int64_t_col,
+                      primitives::scatter_sel_int64_t_col,
+                      primitives::keys_not_equal_row_int64_t_col,
+                      primitives::partition_by_key_row_int64_t_col,
+                      primitives::scatter_sel_row_int64_t_col,
+                      primitives::gather_val_int64_t_col, Buffer(n_name));
+      else
+         group.addKey(Buffer(n_name), //
+                      primitives::hash_Char_25_col,
+                      primitives::keys_not_equal_Char_25_col,
+                      primitives::partition_by_key_Char_25_col,
+                      primitives::scatter_sel_Char_25_col,
+                      primitives::keys_not_equal_row_Char_25_col,
+                      primitives::partition_by_key_row_Char_25_col,
+                      primitives::scatter_sel_row_Char_25_col,
+                      primitives::gather_val_Char_25_col, Buffer(n_name));
+      group
+          .addKey(Buffer(o_year),            //
+                  conf.rehash_int32_t_col(), //
+                  primitives::keys_not_equal_int32_t_col,
+                  primitives::partition_by_key_int32_t_col,
+                  primitives::scatter_sel_int32_t_col,
+                  primitives::keys_not_equal_row_int32_t_col,
+                  primitives::partition_by_key_row_int32_t_col,
+                  primitives::scatter_sel_row_int32_t_col,
+                  primitives::gather_val_int32_t_col, Buffer(o_year))
+          .addValue(Buffer(amount), //
+                    primitives::aggr_init_plus_int64_t_col,
+                    primitives::aggr_plus_int64_t_col,
+                    primitives::aggr_row_plus_int64_t_col,
+                    primitives::gather_val_int64_t_col,
+                    Buffer(sum_profit, sizeof(int64_t)));
+   }
+   if (late)
+      Materialize().addColumn(nation, "n_name", Buffer(n_name),
+                              primitives::materialize_rowid_Char_25_col,
+                              Buffer(n_name_late, sizeof(Char_25)));
+
+   result.addValue("nation", Buffer(late ? n_name_late : n_name))
        .addValue("o_year", Buffer(o_year))
        .addValue("sum_profit", Buffer(sum_profit))
        .finalize();
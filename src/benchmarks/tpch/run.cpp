@@ -1,16 +1,24 @@
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <chrono>
 #include <cstdlib>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "benchmarks/tpch/Queries.hpp"
+#include "common/runtime/ChunkCache.hpp"
 #include "common/runtime/Import.hpp"
+#include "common/runtime/QueryManager.hpp"
+#include "common/runtime/ReadAhead.hpp"
+#include "common/runtime/Scheduler.hpp"
+#include "common/runtime/Topology.hpp"
 #include "profile.hpp"
 #include "tbb/tbb.h"
 
@@ -39,7 +47,7 @@ int main(int argc, char* argv[]) {
           << "Usage: ./" << argv[0]
           << "<number of repetitions> <path to tpch dir> [nrThreads = all] \n "
              " EnvVars: [vectorSize = 1024] [SIMDhash = 0] [SIMDjoin = 0] "
-             "[SIMDsel = 0]";
+             "[SIMDsel = 0] [streams] [memoryBudget]";
       exit(1);
    }
 
@@ -54,6 +62,7 @@ int main(int argc, char* argv[]) {
    size_t vectorSize = 1024;
    bool clearCaches = false;
    if (argc > 3) nrThreads = atoi(argv[3]);
+   Scheduler::globalThreads = nrThreads;
 
    std::unordered_set<std::string> q = {"1h", "1v", "3h", "3v", "5h",  "5v",
                                         "6h", "6v", "9h", "9v", "18h", "18v"};
@@ -63,7 +72,31 @@ int main(int argc, char* argv[]) {
    if (auto v = std::getenv("SIMDjoin")) conf.useSimdJoin = atoi(v);
    if (auto v = std::getenv("SIMDsel")) conf.useSimdSel = atoi(v);
    if (auto v = std::getenv("SIMDproj")) conf.useSimdProj = atoi(v);
+   if (auto v = std::getenv("SIMDaggr")) conf.useSimdAggr = atoi(v);
+   // joins on unique build keys stop at the first match, instead of the
+   // SIMDjoin loops
+   if (auto v = std::getenv("uniqueJoin")) conf.useUniqueJoin = atoi(v);
    if (auto v = std::getenv("clearCaches")) clearCaches = atoi(v);
+   // MB of faulted memory kept for reuse between repetitions
+   if (auto v = std::getenv("warmMemory"))
+      ChunkCache::global().warmLimit = size_t(atoll(v)) << 20;
+   // MB each query may reserve before it fails with MemoryLimitExceeded
+   if (auto v = std::getenv("memoryLimit"))
+      MemoryAccount::queryLimit = size_t(atoll(v)) << 20;
+   // pause rounds before threads waiting in a barrier sleep on a futex
+   if (auto v = std::getenv("barrierSpin"))
+      Barrier::defaultSpinBudget = uint32_t(atoll(v));
+   // physical, compact or spread placement of threads on the cpus
+   if (auto v = std::getenv("placement"))
+      Topology::placement = Topology::parsePlacement(v);
+   // pools of queries with an arena per NUMA node
+   if (auto v = std::getenv("nodeLocalPools")) GlobalPool::nodeLocal = atoi(v);
+   // scans read their columns ahead into the page cache with async I/O
+   if (auto v = std::getenv("readAhead")) ReadAhead::enabled = atoi(v);
+   // windows of 64K tuples read ahead of each scan
+   if (auto v = std::getenv("readAheadDepth")) ReadAhead::depth = atoi(v);
+   // 1MB buffers of the reader of each scan, 0 only advises the kernel
+   if (auto v = std::getenv("readAheadBuffers")) ReadAhead::buffers = atoi(v);
    if (auto v = std::getenv("q")) {
       using namespace std;
       istringstream iss((string(v)));
@@ -73,6 +106,109 @@ int main(int argc, char* argv[]) {
    }
 
    tbb::task_scheduler_init scheduler(nrThreads);
+   ArenaPlacement arenaPlacement(nrThreads);
+
+   // throughput mode: streams concurrent query streams share the threads
+   if (auto v = std::getenv("streams")) {
+      size_t streams = std::max(atoi(v), 1);
+      size_t budget = 0;
+      if (auto b = std::getenv("memoryBudget")) budget = size_t(atoll(b)) << 20;
+      using Run = std::function<void(size_t nrThreads)>;
+      std::vector<std::pair<std::string, Run>> runs;
+      runs.emplace_back("1h", [&](size_t t) {
+         auto result = q1_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("1v", [&](size_t t) {
+         auto result = q1_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      runs.emplace_back("3h", [&](size_t t) {
+         auto result = q3_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("3v", [&](size_t t) {
+         auto result = q3_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      runs.emplace_back("5h", [&](size_t t) {
+         auto result = q5_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("5v", [&](size_t t) {
+         auto result = q5_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      runs.emplace_back("6h", [&](size_t t) {
+         auto result = q6_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("6v", [&](size_t t) {
+         auto result = q6_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      runs.emplace_back("9h", [&](size_t t) {
+         auto result = q9_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("9v", [&](size_t t) {
+         auto result = q9_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      runs.emplace_back("18h", [&](size_t t) {
+         auto result = q18_hyper(tpch, t);
+         escape(&result);
+      });
+      runs.emplace_back("18v", [&](size_t t) {
+         auto result = q18_vectorwise(tpch, t, vectorSize);
+         escape(&result);
+      });
+      auto threads = std::max(nrThreads / streams, size_t(1));
+      // with a budget, each query is admitted with the peak memory of a
+      // calibration run as its estimate
+      std::unordered_map<std::string, size_t> memory;
+      if (budget)
+         for (auto& run : runs) {
+            if (!q.count(run.first)) continue;
+            auto& account = MemoryAccount::process();
+            auto before = account.used();
+            account.resetPeak();
+            run.second(threads);
+            memory[run.first] = account.peak() - before;
+         }
+      QueryManager manager(nrThreads, budget);
+      std::atomic<size_t> latency(0), nrQueries(0);
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < repetitions; ++r)
+         for (size_t s = 0; s < streams; ++s)
+            for (auto& run : runs) {
+               if (!q.count(run.first)) continue;
+               auto& fn = run.second;
+               manager.submit(
+                   [&](size_t t) {
+                      auto begin = std::chrono::steady_clock::now();
+                      fn(t);
+                      latency += std::chrono::duration_cast<
+                                     std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - begin)
+                                     .count();
+                      nrQueries++;
+                      return std::unique_ptr<runtime::Query>();
+                   },
+                   threads, memory[run.first]);
+            }
+      manager.wait();
+      auto seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      std::cout << streams << " streams, " << nrQueries << " queries, "
+                << nrQueries / seconds << " queries/s, "
+                << (nrQueries ? latency / nrQueries / 1000.0 : 0)
+                << " ms average latency" << std::endl;
+      scheduler.terminate();
+      return 0;
+   }
+
    if (q.count("1h"))
       e.timeAndProfile("q1 hyper     ", nrTuples(tpch, {"lineitem"}),
                        [&]() {
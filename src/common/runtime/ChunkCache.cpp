@@ -0,0 +1,81 @@
+#include "common/runtime/ChunkCache.hpp"
+#include "common/runtime/Memory.hpp"
+#include "common/runtime/Topology.hpp"
+#include <cstring>
+
+namespace runtime {
+
+ChunkCache::~ChunkCache() { clear(); }
+
+void* ChunkCache::allocate(size_t size, unsigned node) {
+   Mapping m{nullptr, 0};
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = cached.find({size, node});
+      if (it != cached.end()) {
+         m = it->second.back();
+         it->second.pop_back();
+         if (it->second.empty()) cached.erase(it);
+         warmBytes -= m.dirty;
+         cachedBytes -= size;
+      }
+   }
+   if (!m.p) {
+      auto p = mem::malloc_huge(size);
+      if (node != anyNode)
+         mem::bind_node(p, size, Topology::get().osNode(node));
+      return p;
+   }
+   // zero outside of the lock, the pages stay faulted
+   memset(m.p, 0, m.dirty);
+   return m.p;
+}
+
+void ChunkCache::release(void* p, size_t size, size_t dirty,
+                         unsigned node) {
+   std::lock_guard<std::mutex> lock(mutex);
+   if (warmBytes + dirty > warmLimit) {
+      madvise(p, dirty, MADV_DONTNEED);
+      dirty = 0;
+   }
+   cached[{size, node}].push_back({p, dirty});
+   warmBytes += dirty;
+   cachedBytes += size;
+}
+
+void ChunkCache::trim(size_t limit) {
+   std::lock_guard<std::mutex> lock(mutex);
+   for (auto& sized : cached)
+      for (auto& m : sized.second) {
+         if (warmBytes <= limit) return;
+         if (!m.dirty) continue;
+         madvise(m.p, m.dirty, MADV_DONTNEED);
+         warmBytes -= m.dirty;
+         m.dirty = 0;
+      }
+}
+
+void ChunkCache::clear() {
+   std::lock_guard<std::mutex> lock(mutex);
+   for (auto& sized : cached)
+      for (auto& m : sized.second) mem::free_huge(m.p, sized.first.first);
+   cached.clear();
+   warmBytes = 0;
+   cachedBytes = 0;
+}
+
+size_t ChunkCache::warm() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return warmBytes;
+}
+
+size_t ChunkCache::size() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return cachedBytes;
+}
+
+ChunkCache& ChunkCache::global() {
+   static ChunkCache cache;
+   return cache;
+}
+} // namespace runtime
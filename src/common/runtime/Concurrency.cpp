@@ -1,9 +1,56 @@
 #include "common/runtime/Concurrency.hpp"
+#include <algorithm>
 
 namespace runtime {
 
 thread_local Worker* this_worker;
 thread_local bool currentBarrier = false;
+thread_local std::vector<unsigned> workerCpus;
+thread_local size_t currentThreadIndex = ~size_t(0);
+thread_local size_t currentThreadGeneration = 0;
+thread_local std::shared_ptr<Cancellation> Cancellation::current;
+
+namespace {
+std::mutex threadIndexMutex;
+size_t nextThreadIndex = 0;
+size_t lastThreadGeneration = 0;
+std::vector<size_t> freeThreadIndexes;
+
+/// returns the index of its thread when the thread exits
+struct ThreadIndex {
+   size_t index;
+   size_t generation;
+   ThreadIndex() {
+      std::lock_guard<std::mutex> lock(threadIndexMutex);
+      generation = ++lastThreadGeneration;
+      if (freeThreadIndexes.empty())
+         index = nextThreadIndex++;
+      else {
+         // lowest free index, to keep indexes dense
+         auto lowest = std::min_element(freeThreadIndexes.begin(),
+                                        freeThreadIndexes.end());
+         index = *lowest;
+         freeThreadIndexes.erase(lowest);
+      }
+   }
+   ~ThreadIndex() {
+      std::lock_guard<std::mutex> lock(threadIndexMutex);
+      freeThreadIndexes.push_back(index);
+      currentThreadIndex = ~size_t(0);
+      currentThreadGeneration = 0;
+   }
+};
+} // namespace
+
+size_t newThreadIndex() {
+   static thread_local ThreadIndex index;
+   currentThreadGeneration = index.generation;
+   currentThreadIndex = index.index;
+   return index.index;
+}
+
+// tens to hundreds of microseconds, depending on the latency of pause
+std::atomic<uint32_t> Barrier::defaultSpinBudget(1 << 12);
 
 WorkerGroup mainGroup(1);
 HierarchicBarrier mainBarrier(1, nullptr);
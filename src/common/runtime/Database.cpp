@@ -34,13 +34,17 @@ BlockRelation::Block BlockRelation::createBlock(size_t minNrElements) {
    auto a = this_worker->allocator.allocate(sizeof(BlockHeader) +
                                             elements * currentAttributeSize);
    auto header = new (a) BlockHeader(elements);
-   {
-      std::lock_guard<std::mutex> lock(insertMutex);
-      blocks.push_back(header);
-   }
+   threadBlocks.local().push_back(header);
    return Block(this, header);
 }
 
+void BlockRelation::finalize() {
+   for (auto& created : threadBlocks) {
+      blocks.insert(blocks.end(), created.begin(), created.end());
+      created.clear();
+   }
+}
+
 BlockRelation::Attribute BlockRelation::addAttribute(std::string name,
                                                      size_t elementSize) {
    Attribute attr = attributes.size();
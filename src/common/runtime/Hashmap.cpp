@@ -1,8 +1,23 @@
 #include "common/runtime/Hashmap.hpp"
+#include "common/runtime/Concurrency.hpp"
 #include <assert.h>
 #include <iostream>
 
 namespace runtime {
 
 Hashmap::EntryHeader notFound(&notFound, 0);
+
+void Hashmap::chargeDirectory(size_t bytes) {
+   if (!this_worker) return;
+   auto& allocator = this_worker->allocator;
+   if (allocator.account) allocator.account->allocate(bytes);
+   if (allocator.operatorAccount) allocator.operatorAccount->allocate(bytes);
+}
+
+void Hashmap::creditDirectory(size_t bytes) {
+   if (!this_worker) return;
+   auto& allocator = this_worker->allocator;
+   if (allocator.account) allocator.account->free(bytes);
+   if (allocator.operatorAccount) allocator.operatorAccount->free(bytes);
+}
 }
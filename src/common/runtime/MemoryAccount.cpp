@@ -0,0 +1,43 @@
+#include "common/runtime/MemoryAccount.hpp"
+#include <algorithm>
+#include <string>
+
+namespace runtime {
+
+std::atomic<size_t> MemoryAccount::queryLimit{0};
+
+void MemoryAccount::allocate(size_t bytes) {
+   auto now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+   auto max = limit.load(std::memory_order_relaxed);
+   if (max && now > max) {
+      current.fetch_sub(bytes, std::memory_order_relaxed);
+      throw MemoryLimitExceeded("Memory limit of " + std::to_string(max) +
+                                " bytes exceeded.");
+   }
+   if (parent) {
+      try {
+         parent->allocate(bytes);
+      } catch (...) {
+         current.fetch_sub(bytes, std::memory_order_relaxed);
+         throw;
+      }
+   }
+   auto p = peakBytes.load(std::memory_order_relaxed);
+   while (now > p && !peakBytes.compare_exchange_weak(p, now))
+      ;
+}
+
+void MemoryAccount::free(size_t bytes) {
+   // bytes may have been charged while another account was active, e.g. for
+   // a resized hash directory. Never drop below zero
+   auto c = current.load(std::memory_order_relaxed);
+   while (!current.compare_exchange_weak(c, c - std::min(c, bytes)))
+      ;
+   if (parent) parent->free(bytes);
+}
+
+MemoryAccount& MemoryAccount::process() {
+   static MemoryAccount account;
+   return account;
+}
+} // namespace runtime
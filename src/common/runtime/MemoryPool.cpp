@@ -1,29 +1,58 @@
 #include "common/runtime/MemoryPool.hpp"
-#include "common/runtime/Memory.hpp"
+#include "common/runtime/ChunkCache.hpp"
+#include "common/runtime/Topology.hpp"
 #include <new>
 
 namespace runtime {
 
-GlobalPool::GlobalPool() {
-   current = newChunk(allocSize);
-   start = (int8_t*)current + sizeof(Chunk);
-   end = start + allocSize;
+bool GlobalPool::nodeLocal = true;
+
+GlobalPool::GlobalPool() : memory(&MemoryAccount::process()) {
+   memory.limit = MemoryAccount::queryLimit.load();
+   nrArenas = nodeLocal ? Topology::get().nrNodes : 1;
+   arenas = std::make_unique<Arena[]>(nrArenas);
+   // chunks of other nodes are created on their first use
+   auto& arena = arenas[0];
+   arena.current = newChunk(arena.allocSize, 0);
+   arena.start = (int8_t*)arena.current + sizeof(Chunk);
+   arena.end = arena.start + arena.allocSize;
 }
 
 GlobalPool::~GlobalPool() {
-   for (auto chunk = current; chunk;) {
-      auto c = chunk;
-      chunk = chunk->next; // read first, then free
-      mem::free_huge(c, c->size + sizeof(Chunk));
+   auto& cache = ChunkCache::global();
+   for (unsigned node = 0; node < nrArenas; ++node) {
+      auto& arena = arenas[node];
+      for (auto chunk = arena.current; chunk;) {
+         auto c = chunk;
+         chunk = chunk->next; // read first, then free
+         auto size = c->size + sizeof(Chunk);
+         // only the current chunk is partially used
+         auto used = c == arena.current
+                         ? size_t(arena.start.load() - (int8_t*)c)
+                         : size;
+         cache.release(c, size, std::min(used, size),
+                       nrArenas > 1 ? node : ChunkCache::anyNode);
+      }
+      arena.current = nullptr;
    }
-   current = nullptr;
+   memory.parent->free(memory.used());
 }
 
-GlobalPool::Chunk* GlobalPool::newChunk(size_t size) {
-   return new (mem::malloc_huge(size + sizeof(Chunk))) Chunk(size);
+GlobalPool::Chunk* GlobalPool::newChunk(size_t size, unsigned node) {
+   auto p = ChunkCache::global().allocate(
+       size + sizeof(Chunk), nrArenas > 1 ? node : ChunkCache::anyNode);
+   return new (p) Chunk(size);
 }
 
 void* GlobalPool::allocate(size_t size) {
+   return allocate(size, nrArenas > 1 ? Topology::currentNode() : 0);
+}
+
+void* GlobalPool::allocate(size_t size, unsigned node) {
+   if (node >= nrArenas) node = 0;
+   auto& arena = arenas[node];
+   auto& start = arena.start;
+   auto& end = arena.end;
    int8_t* start_;
    int8_t* end_;
    int8_t* alloc;
@@ -33,7 +62,7 @@ restart:
       end_ = end.load();
       if (start_ + size >= end_) {
          {
-            std::lock_guard<std::mutex> lock(refill);
+            std::lock_guard<std::mutex> lock(arena.refill);
             // recheck condition
             start_ = start.load();
             end_ = end.load();
@@ -44,21 +73,21 @@ restart:
                   end_ = end.load();
                } while (!start.compare_exchange_weak(start_, end_));
                // Add a new chunk if space isn't sufficient
-               allocSize = std::max(allocSize * 2, size);
-               auto chunk = newChunk(allocSize);
-               chunk->next = current;
+               arena.allocSize = std::max(arena.allocSize * 2, size);
+               auto chunk = newChunk(arena.allocSize, node);
+               chunk->next = arena.current;
 
                start_ = (int8_t*)chunk + sizeof(Chunk);
-               end_ = start_ + allocSize;
+               end_ = start_ + arena.allocSize;
                // order is important due to above conditions in if
-               if (chunk < current) {
+               if (chunk < arena.current) {
                   end = end_;
                   start = start_;
                } else {
                   start = start_;
                   end = end_;
                }
-               current = chunk;
+               arena.current = chunk;
             } else
                goto restart;
          }
@@ -69,10 +98,14 @@ restart:
    return alloc;
 }
 
+const size_t Allocator::maxAllocSize;
+
 GlobalPool* Allocator::setSource(GlobalPool* source) {
    auto previousSource = memorySource;
    memorySource = source;
+   account = source ? &source->memory : nullptr;
    if (source) {
+      account->allocate(allocSize);
       start = (uint8_t*)memorySource->allocate(allocSize);
       free = allocSize;
    }
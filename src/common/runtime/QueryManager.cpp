@@ -0,0 +1,104 @@
+#include "common/runtime/QueryManager.hpp"
+#include "common/runtime/MemoryAccount.hpp"
+#include "common/runtime/Query.hpp"
+#include "common/runtime/Scheduler.hpp"
+#include "common/runtime/Topology.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace runtime {
+
+QueryManager::QueryManager(size_t cores, size_t memoryBudget_)
+    : memoryBudget(memoryBudget_), baseMemory(MemoryAccount::process().used()),
+      cpus(Topology::get().place(std::max(cores, size_t(1)))),
+      coreUsed(cpus.size()), freeCores(cpus.size()) {}
+
+QueryManager::~QueryManager() { wait(); }
+
+std::future<std::unique_ptr<Query>>
+QueryManager::submit(QueryFn fn, size_t threads, size_t memory, int priority,
+                     std::shared_ptr<Cancellation> cancellation) {
+   // a query never gets more than all cores
+   threads = std::min(std::max(threads, size_t(1)), coreUsed.size());
+   std::lock_guard<std::mutex> lock(mutex);
+   // behind all queries of at least the same priority
+   auto pos = std::find_if(waiting.begin(), waiting.end(),
+                           [&](auto& p) { return p.priority < priority; });
+   if (!cancellation) cancellation = std::make_shared<Cancellation>();
+   auto query =
+       waiting.insert(pos, Pending{std::move(fn), threads, memory, priority,
+                                   std::move(cancellation), {}});
+   auto result = query->result.get_future();
+   admit();
+   return result;
+}
+
+size_t QueryManager::usedMemory() const {
+   auto booked = MemoryAccount::process().used();
+   booked = booked > baseMemory ? booked - baseMemory : 0;
+   return std::max(reservedMemory, booked);
+}
+
+void QueryManager::admit() {
+   while (!waiting.empty()) {
+      auto& next = waiting.front();
+      if (next.threads > freeCores) return;
+      // the first query is always admitted, even if it exceeds the budget
+      if (memoryBudget && running &&
+          usedMemory() + next.memory > memoryBudget)
+         return;
+      std::vector<unsigned> cores;
+      for (unsigned c = 0; cores.size() < next.threads; ++c)
+         if (!coreUsed[c]) {
+            coreUsed[c] = true;
+            cores.push_back(c);
+         }
+      freeCores -= next.threads;
+      reservedMemory += next.memory;
+      running++;
+      std::thread(&QueryManager::run, this, std::move(next), std::move(cores))
+          .detach();
+      waiting.pop_front();
+   }
+}
+
+void QueryManager::run(Pending query, std::vector<unsigned> cores) {
+   // resources of this thread, like those of the main thread
+   WorkerGroup group(1);
+   HierarchicBarrier barrier(1, nullptr);
+   Worker worker(&group, &barrier, defaultPool);
+   workerCpus.clear();
+   for (auto c : cores) workerCpus.push_back(cpus[c]);
+   Scheduler::threadPriority = query.priority;
+   Cancellation::current = query.cancellation;
+   try {
+      // cancelled while waiting
+      query.cancellation->checkpoint();
+      query.result.set_value(query.fn(query.threads));
+   } catch (...) {
+      query.result.set_exception(std::current_exception());
+   }
+   std::lock_guard<std::mutex> lock(mutex);
+   for (auto c : cores) coreUsed[c] = false;
+   freeCores += query.threads;
+   reservedMemory -= query.memory;
+   running--;
+   admit();
+   finished.notify_all();
+}
+
+void QueryManager::wait() {
+   std::unique_lock<std::mutex> lock(mutex);
+   finished.wait(lock, [&]() { return waiting.empty() && !running; });
+}
+
+size_t QueryManager::nrRunning() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return running;
+}
+
+size_t QueryManager::nrWaiting() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return waiting.size();
+}
+} // namespace runtime
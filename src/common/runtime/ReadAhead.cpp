@@ -0,0 +1,359 @@
+#include "common/runtime/ReadAhead.hpp"
+#include "common/Compat.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(SYS_io_uring_setup) && defined(SYS_io_uring_enter)
+#define HAVE_IO_URING
+#endif
+#endif
+
+namespace runtime {
+
+#ifdef HAVE_IO_URING
+struct AsyncReader::Uring
+/// submission and completion rings of an io_uring instance, used through the
+/// raw system calls
+{
+   int fd = -1;
+   void* sqRing = MAP_FAILED;
+   size_t sqRingSize = 0;
+   void* cqRing = MAP_FAILED;
+   size_t cqRingSize = 0;
+   io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+   size_t sqesSize = 0;
+   std::atomic<unsigned>* sqTail;
+   unsigned sqMask;
+   unsigned* sqArray;
+   std::atomic<unsigned>* cqHead;
+   std::atomic<unsigned>* cqTail;
+   unsigned cqMask;
+   io_uring_cqe* cqes;
+   /// one iovec per buffer, readv is supported by all io_uring kernels
+   std::vector<iovec> iovecs;
+
+   template <typename T> static T* at(void* ring, unsigned offset) {
+      return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+   }
+
+   /// false if io_uring is unavailable, e.g. forbidden in a container
+   bool setup(unsigned entries) {
+      io_uring_params p;
+      std::memset(&p, 0, sizeof(p));
+      fd = int(syscall(SYS_io_uring_setup, entries, &p));
+      if (fd < 0) return false;
+      sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+      if (p.features & IORING_FEAT_SINGLE_MMAP)
+         sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+      sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+      if (sqRing == MAP_FAILED) return false;
+      if (p.features & IORING_FEAT_SINGLE_MMAP) {
+         cqRing = sqRing;
+      } else {
+         cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+         if (cqRing == MAP_FAILED) return false;
+      }
+      sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+      sqes = static_cast<io_uring_sqe*>(
+          mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+      if (sqes == MAP_FAILED) return false;
+      sqTail = at<std::atomic<unsigned>>(sqRing, p.sq_off.tail);
+      sqMask = *at<unsigned>(sqRing, p.sq_off.ring_mask);
+      sqArray = at<unsigned>(sqRing, p.sq_off.array);
+      cqHead = at<std::atomic<unsigned>>(cqRing, p.cq_off.head);
+      cqTail = at<std::atomic<unsigned>>(cqRing, p.cq_off.tail);
+      cqMask = *at<unsigned>(cqRing, p.cq_off.ring_mask);
+      cqes = at<io_uring_cqe>(cqRing, p.cq_off.cqes);
+      return true;
+   }
+
+   ~Uring() {
+      if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+      if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+      if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+      if (fd >= 0) close(fd);
+   }
+
+   /// submits a read of buffer i, at most as many reads are in flight as
+   /// there are ring entries
+   void submit(size_t i, Buffer& b) {
+      auto& iov = iovecs[i];
+      iov.iov_base = b.data;
+      iov.iov_len = b.size;
+      auto tail = sqTail->load(std::memory_order_relaxed);
+      auto index = tail & sqMask;
+      auto& sqe = sqes[index];
+      std::memset(&sqe, 0, sizeof(sqe));
+      sqe.opcode = IORING_OP_READV;
+      sqe.fd = b.fd;
+      sqe.off = b.offset;
+      sqe.addr = reinterpret_cast<uint64_t>(&iov);
+      sqe.len = 1;
+      sqe.user_data = i;
+      sqArray[index] = index;
+      sqTail->store(tail + 1, std::memory_order_release);
+      while (syscall(SYS_io_uring_enter, fd, 1, 0, 0, nullptr, 0) < 0)
+         if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            throw std::runtime_error("io_uring_enter failed");
+   }
+
+   /// marks the buffers of completed reads as done, waits for at least one
+   /// if wait is set
+   void reap(std::vector<Buffer>& buffers, bool wait = true) {
+      auto head = cqHead->load(std::memory_order_relaxed);
+      while (wait && head == cqTail->load(std::memory_order_acquire)) {
+         if (syscall(SYS_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS,
+                     nullptr, 0) < 0 &&
+             errno != EINTR)
+            throw std::runtime_error("io_uring_enter failed");
+      }
+      for (; head != cqTail->load(std::memory_order_acquire); ++head) {
+         auto& cqe = cqes[head & cqMask];
+         auto& b = buffers[cqe.user_data];
+         b.result = cqe.res;
+         b.done = true;
+      }
+      cqHead->store(head, std::memory_order_release);
+   }
+};
+#else
+struct AsyncReader::Uring {
+   bool setup(unsigned) { return false; }
+   void submit(size_t, Buffer&) {}
+   void reap(std::vector<Buffer>&, bool = true) {}
+   std::vector<int> iovecs;
+};
+#endif
+
+AsyncReader::AsyncReader(size_t nrBuffers, size_t bufferSize_,
+                         Backend preferred)
+    : bufferSize(bufferSize_), buffers(std::max(nrBuffers, size_t(1))),
+      backend_(Backend::threads) {
+   for (auto& b : buffers) {
+      // page aligned, e.g. for direct I/O
+      b.data = compat::aligned_alloc(4096, (bufferSize + 4095) & ~4095ul);
+      if (!b.data) throw std::runtime_error("malloc failed");
+   }
+   if (preferred == Backend::uring) {
+      auto ring = std::make_unique<Uring>();
+      if (ring->setup(unsigned(buffers.size()))) {
+         ring->iovecs.resize(buffers.size());
+         uring = std::move(ring);
+         backend_ = Backend::uring;
+         return;
+      }
+   }
+   // as many readers as reads in flight, but not too many threads
+   auto nrThreads = std::min(buffers.size(), size_t(8));
+   for (size_t i = 0; i < nrThreads; ++i)
+      threads.emplace_back([this]() { readerMain(); });
+}
+
+AsyncReader::~AsyncReader() {
+   drain();
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   requested.notify_all();
+   for (auto& t : threads) t.join();
+   for (auto& b : buffers) free(b.data);
+}
+
+void AsyncReader::readerMain() {
+   while (true) {
+      size_t i;
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         requested.wait(lock, [&]() { return stopping || !queue.empty(); });
+         if (queue.empty()) return;
+         i = queue.front();
+         queue.pop_front();
+      }
+      auto& b = buffers[i];
+      long result = 0;
+      while (size_t(result) < b.size) {
+         auto n = pread(b.fd, static_cast<char*>(b.data) + result,
+                        b.size - result, b.offset + result);
+         if (n < 0 && errno == EINTR) continue;
+         if (n < 0) {
+            result = -errno;
+            break;
+         }
+         if (n == 0) break; // end of file
+         result += n;
+      }
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         b.result = result;
+         b.done = true;
+      }
+      completed.notify_all();
+   }
+}
+
+size_t AsyncReader::read(int fd, size_t offset, size_t size) {
+   if (size > bufferSize)
+      throw std::runtime_error("Read exceeds buffer size.");
+   auto i = nextBuffer;
+   nextBuffer = (nextBuffer + 1) % buffers.size();
+   // the read before into this buffer is no longer needed
+   if (buffers[i].busy) release(i);
+   auto& b = buffers[i];
+   b.fd = fd;
+   b.offset = offset;
+   b.size = size;
+   b.busy = true;
+   b.done = false;
+   if (uring) {
+      uring->submit(i, b);
+      return i;
+   }
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back(i);
+   }
+   requested.notify_one();
+   return i;
+}
+
+bool AsyncReader::available() {
+   auto& b = buffers[nextBuffer];
+   if (!b.busy) return true;
+   if (uring) {
+      if (!b.done) uring->reap(buffers, false);
+      return b.done;
+   }
+   std::lock_guard<std::mutex> lock(mutex);
+   return b.done;
+}
+
+void AsyncReader::complete(size_t i) {
+   if (uring) {
+      while (!buffers[i].done) uring->reap(buffers);
+      return;
+   }
+   std::unique_lock<std::mutex> lock(mutex);
+   completed.wait(lock, [&]() { return buffers[i].done; });
+}
+
+size_t AsyncReader::wait(size_t i) {
+   auto& b = buffers[i];
+   if (!b.busy) return b.result < 0 ? 0 : size_t(b.result);
+   complete(i);
+   b.busy = false;
+   if (b.result < 0)
+      throw std::runtime_error(std::string("Asynchronous read failed: ") +
+                               std::strerror(int(-b.result)));
+   bytes += size_t(b.result);
+   return size_t(b.result);
+}
+
+void AsyncReader::release(size_t i) {
+   complete(i);
+   buffers[i].busy = false;
+   if (buffers[i].result > 0) bytes += size_t(buffers[i].result);
+}
+
+void AsyncReader::drain() {
+   for (size_t i = 0; i < buffers.size(); ++i)
+      if (buffers[i].busy) release(i);
+}
+
+size_t ReadAhead::depth = 8;
+size_t ReadAhead::buffers = 32;
+bool ReadAhead::enabled = false;
+
+/// size of the buffers of a read ahead
+static const size_t readAheadBufferSize = 1 << 20;
+
+ReadAhead::ReadAhead(const std::vector<Attribute*>& attributes,
+                     size_t nrTuples_)
+    : nrTuples(nrTuples_),
+      issued((nrTuples_ + windowSize - 1) / windowSize) {
+   for (auto attr : attributes) {
+      auto fd = attr->data_.file();
+      if (fd >= 0) columns.push_back({fd, attr->type->rt_size()});
+   }
+   if (columns.empty() || !buffers) return;
+   try {
+      reader = std::make_unique<AsyncReader>(buffers, readAheadBufferSize);
+   } catch (const std::exception&) {
+      // e.g. out of memory or threads, the kernel still reads ahead
+   }
+}
+
+std::unique_ptr<ReadAhead>
+ReadAhead::create(const std::vector<Attribute*>& attributes,
+                  size_t nrTuples) {
+   if (!enabled || nrTuples == 0) return nullptr;
+   auto r = std::make_unique<ReadAhead>(attributes, nrTuples);
+   if (r->columns.empty()) return nullptr;
+   return r;
+}
+
+std::unique_ptr<ReadAhead>
+ReadAhead::create(Relation& rel, const std::vector<std::string>& attributes) {
+   std::vector<Attribute*> attrs;
+   for (auto& name : attributes) attrs.push_back(&rel[name]);
+   return create(attrs, rel.nrTuples);
+}
+
+void ReadAhead::advance(size_t pos) {
+   auto first = pos / windowSize;
+   auto last = std::min(first + depth, issued.size());
+   std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+   if (!lock) return;
+   for (auto w = first; w < last; ++w) {
+      if (issued[w]) continue;
+      issued[w] = true;
+      auto end = std::min((w + 1) * windowSize, nrTuples);
+      for (auto& c : columns)
+         for (auto offset = w * windowSize * c.elementSize,
+                   limit = end * c.elementSize;
+              offset < limit; offset += readAheadBufferSize) {
+            auto size = std::min(readAheadBufferSize, limit - offset);
+            bytes += size;
+            if (reader && reader->available()) {
+               reader->read(c.fd, offset, size);
+               continue;
+            }
+            // starts the reads into the page cache without waiting for them
+            posix_fadvise(c.fd, off_t(offset), off_t(size),
+                          POSIX_FADV_WILLNEED);
+            advisedBytes += size;
+         }
+   }
+}
+
+size_t ReadAhead::requested() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return bytes;
+}
+
+size_t ReadAhead::advised() {
+   std::lock_guard<std::mutex> lock(mutex);
+   return advisedBytes;
+}
+
+size_t ReadAhead::finish() {
+   std::lock_guard<std::mutex> lock(mutex);
+   if (!reader) return 0;
+   reader->drain();
+   return reader->bytesRead();
+}
+} // namespace runtime
@@ -0,0 +1,168 @@
+#include "common/runtime/Scheduler.hpp"
+#include "common/runtime/Query.hpp"
+#include "common/runtime/Topology.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace runtime {
+
+static thread_local size_t schedulerThreadId = 0;
+thread_local int Scheduler::threadPriority = 0;
+
+size_t Scheduler::globalThreads = std::thread::hardware_concurrency();
+
+Scheduler::Job::Job(size_t n_, size_t morselSize_, const Morsel& fn_,
+                    int priority_, Query* query_, size_t nrSlices_)
+    : fn(fn_), morselSize(std::max(morselSize_, size_t(1))),
+      priority(priority_), query(query_),
+      nrSlices(std::min(std::max(nrSlices_, size_t(1)), n_ / morselSize + 1)),
+      n(n_) {
+   slices = std::make_unique<Slice[]>(nrSlices);
+   auto sliceSize = n / nrSlices;
+   for (size_t i = 0; i < nrSlices; ++i) {
+      slices[i].next = i * sliceSize;
+      slices[i].end = i + 1 == nrSlices ? n : (i + 1) * sliceSize;
+   }
+}
+
+bool Scheduler::Job::claim(size_t first, size_t& begin, size_t& end) {
+   for (size_t i = 0; i < nrSlices; ++i) {
+      auto& slice = slices[(first + i) % nrSlices];
+      if (slice.next.load(std::memory_order_relaxed) >= slice.end) continue;
+      begin = slice.next.fetch_add(morselSize);
+      if (begin < slice.end) {
+         end = std::min(begin + morselSize, slice.end);
+         return true;
+      }
+   }
+   return false;
+}
+
+template <typename S> void Scheduler::Job::work(size_t first, S stop) {
+   size_t begin, end;
+   while (!stop() && claim(first, begin, end)) {
+      try {
+         if (query) query->cancellation->checkpoint();
+         fn(begin, end);
+      } catch (...) {
+         {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) failure = std::current_exception();
+         }
+         // skip all unclaimed morsels
+         for (size_t i = 0; i < nrSlices; ++i) {
+            auto next = slices[i].next.exchange(slices[i].end);
+            if (next < slices[i].end) done.fetch_add(slices[i].end - next);
+         }
+      }
+      done.fetch_add(end - begin);
+   }
+}
+
+void Scheduler::Job::leave() {
+   // the submitting thread may destroy the job as soon as the mutex is free
+   std::lock_guard<std::mutex> lock(usersMutex);
+   if (--users == 0) released.notify_one();
+}
+
+Scheduler::Scheduler(size_t nrThreads) : topPriority(0) {
+   // the submitting thread takes the first cpu of the placement
+   auto cpus = Topology::get().place(nrThreads + 1);
+   for (size_t i = 0; i < nrThreads; ++i)
+      threads.emplace_back([this, i, cpu = cpus[i + 1]]() {
+         pinThread(cpu);
+         threadMain(i + 1);
+      });
+}
+
+Scheduler::~Scheduler() {
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   wakeup.notify_all();
+   for (auto& t : threads) t.join();
+}
+
+Scheduler::Job* Scheduler::pick(size_t id) {
+   Job* best = nullptr;
+   for (size_t i = 0; i < jobs.size(); ++i) {
+      // threads start at different jobs to spread over equal priorities
+      auto job = jobs[(i + id) % jobs.size()];
+      if (best && job->priority <= best->priority) continue;
+      for (size_t s = 0; s < job->nrSlices; ++s)
+         if (job->slices[s].next.load() < job->slices[s].end) {
+            best = job;
+            break;
+         }
+   }
+   if (best) best->users++;
+   return best;
+}
+
+void Scheduler::updatePriority() {
+   auto top = std::numeric_limits<int>::min();
+   for (auto job : jobs) top = std::max(top, job->priority);
+   topPriority = top;
+}
+
+void Scheduler::threadMain(size_t id) {
+   schedulerThreadId = id;
+   Worker worker;
+   worker.group = nullptr;
+   worker.barrier = nullptr;
+   worker.allocator.setSource(&defaultPool);
+   this_worker = &worker;
+   while (true) {
+      Job* job = nullptr;
+      int seen;
+      {
+         std::unique_lock<std::mutex> lock(mutex);
+         wakeup.wait(lock, [&]() { return stopping || (job = pick(id)); });
+         if (!job) return;
+         seen = std::max(topPriority.load(), job->priority);
+      }
+      // join the query of the job
+      if (job->query) this_worker = &job->query->worker(id);
+      // leave it when a job of higher priority is submitted
+      job->work(id % job->nrSlices,
+                [&]() { return topPriority.load() > seen; });
+      this_worker = &worker;
+      job->leave();
+   }
+}
+
+void Scheduler::parallelFor(size_t n, size_t morselSize, const Morsel& fn,
+                            int priority, Query* query) {
+   if (n == 0) return;
+   if (!query && this_worker) query = this_worker->query;
+   Job job(n, morselSize, fn, priority, query, size());
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.push_back(&job);
+      updatePriority();
+   }
+   wakeup.notify_all();
+   // the submitting thread only works on its own job
+   job.work(schedulerThreadId, []() { return false; });
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.erase(std::find(jobs.begin(), jobs.end(), &job));
+      updatePriority();
+   }
+   // all morsels are claimed and no thread picks the job anymore, sleep
+   // until the threads still processing morsels leave it
+   {
+      std::unique_lock<std::mutex> lock(job.usersMutex);
+      job.released.wait(lock, [&]() { return job.users.load() == 0; });
+   }
+   if (job.failure) std::rethrow_exception(job.failure);
+}
+
+size_t Scheduler::threadId() { return schedulerThreadId; }
+
+Scheduler& Scheduler::global() {
+   static Scheduler scheduler(std::max(globalThreads, size_t(1)) - 1);
+   return scheduler;
+}
+} // namespace runtime
@@ -0,0 +1,39 @@
+#include "common/runtime/StringSearch.hpp"
+#include <immintrin.h>
+
+namespace runtime {
+
+const char* StringPattern::findIn(const char* str, size_t len) const {
+   const auto n = size();
+   const auto p = data();
+   if (len < n) return nullptr;
+   if (n == 0) return str;
+   if (n == 1) return static_cast<const char*>(memchr(str, p[0], len));
+
+   size_t i = 0;
+#ifdef __AVX2__
+   const auto first = _mm256_set1_epi8(p[0]);
+   const auto last = _mm256_set1_epi8(p[n - 1]);
+   for (; i + n - 1 + 32 <= len; i += 32) {
+      auto blockFirst =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i));
+      auto blockLast =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i + n - 1));
+      uint32_t mask = _mm256_movemask_epi8(
+          _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                           _mm256_cmpeq_epi8(last, blockLast)));
+      while (mask) {
+         const auto pos = i + __builtin_ctz(mask);
+         if (memcmp(str + pos + 1, p + 1, n - 2) == 0) return str + pos;
+         mask &= mask - 1;
+      }
+   }
+#endif
+   // remaining positions, with the same first/last character filter
+   for (; i + n <= len; ++i)
+      if ((str[i] == p[0]) & (str[i + n - 1] == p[n - 1]) &&
+          memcmp(str + i + 1, p + 1, n - 2) == 0)
+         return str + i;
+   return nullptr;
+}
+} // namespace runtime
@@ -0,0 +1,174 @@
+#include "common/runtime/Topology.hpp"
+#include "common/Compat.hpp"
+#include <algorithm>
+#include <cctype>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+namespace runtime {
+
+Placement Topology::placement = Placement::physical;
+
+/// first number in file, or fallback if it cannot be read
+static unsigned readNumber(const std::string& file, unsigned fallback) {
+   std::ifstream in(file);
+   unsigned value;
+   if (in >> value) return value;
+   return fallback;
+}
+
+/// NUMA node of a cpu, from the nodeN link in its sysfs directory
+static unsigned readNode(const std::string& cpuDir) {
+   unsigned node = 0;
+   if (auto dir = opendir(cpuDir.c_str())) {
+      while (auto entry = readdir(dir)) {
+         std::string name = entry->d_name;
+         if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+             std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            node = std::stoul(name.substr(4));
+            break;
+         }
+      }
+      closedir(dir);
+   }
+   return node;
+}
+
+Topology Topology::read(const std::string& root,
+                        const std::vector<unsigned>& allowed) {
+   Topology t;
+   for (auto id : allowed) {
+      auto dir = root + "/cpu" + std::to_string(id);
+      Cpu cpu;
+      cpu.id = id;
+      // without sysfs, every cpu is a core of its own
+      cpu.package = readNumber(dir + "/topology/physical_package_id", 0);
+      cpu.core = readNumber(dir + "/topology/core_id", id);
+      cpu.node = readNode(dir);
+      cpu.sibling = 0;
+      t.cpus.push_back(cpu);
+   }
+   // number the SMT siblings of each core by cpu id
+   std::map<std::pair<unsigned, unsigned>, unsigned> siblings;
+   std::sort(t.cpus.begin(), t.cpus.end(),
+             [](const Cpu& a, const Cpu& b) { return a.id < b.id; });
+   for (auto& cpu : t.cpus) cpu.sibling = siblings[{cpu.package, cpu.core}]++;
+   // nodes are numbered densely, the cpuset may exclude some of them
+   std::map<unsigned, unsigned> nodes;
+   for (auto& cpu : t.cpus) nodes[cpu.node];
+   unsigned n = 0;
+   for (auto& node : nodes) {
+      node.second = n++;
+      t.osNodes.push_back(node.first);
+   }
+   if (t.osNodes.empty()) t.osNodes.push_back(0);
+   for (auto& cpu : t.cpus) {
+      cpu.node = nodes[cpu.node];
+      if (t.nodeOf.size() <= cpu.id) t.nodeOf.resize(cpu.id + 1, 0);
+      t.nodeOf[cpu.id] = cpu.node;
+   }
+   t.nrNodes = std::max(nodes.size(), size_t(1));
+   return t;
+}
+
+Topology Topology::detect() {
+   std::vector<unsigned> allowed;
+#ifdef __linux__
+   // the affinity mask reflects the cpuset of the container
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if (sched_getaffinity(0, sizeof(set), &set) == 0)
+      for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+         if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+#endif
+   if (allowed.empty())
+      for (unsigned cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu)
+         allowed.push_back(cpu);
+   return read("/sys/devices/system/cpu", allowed);
+}
+
+const Topology& Topology::get() {
+   static Topology topology = detect();
+   return topology;
+}
+
+unsigned Topology::osNode(unsigned node) const {
+   return node < osNodes.size() ? osNodes[node] : node;
+}
+
+unsigned Topology::currentNode() {
+   auto& t = get();
+   if (t.nrNodes == 1) return 0;
+#ifdef __linux__
+   auto cpu = sched_getcpu();
+   if (cpu >= 0 && size_t(cpu) < t.nodeOf.size()) return t.nodeOf[cpu];
+#endif
+   return 0;
+}
+
+std::vector<unsigned> Topology::place(size_t n, Placement p) const {
+   auto order = cpus;
+   if (p == Placement::compact)
+      std::sort(order.begin(), order.end(), [](const Cpu& a, const Cpu& b) {
+         return std::tie(a.node, a.package, a.core, a.sibling) <
+                std::tie(b.node, b.package, b.core, b.sibling);
+      });
+   else
+      std::sort(order.begin(), order.end(), [](const Cpu& a, const Cpu& b) {
+         return std::tie(a.sibling, a.node, a.package, a.core) <
+                std::tie(b.sibling, b.node, b.package, b.core);
+      });
+   std::vector<unsigned> ids;
+   if (p == Placement::spread) {
+      // the i-th cpu of each node before the i+1-th cpu of any node
+      std::vector<std::vector<unsigned>> perNode(nrNodes);
+      for (auto& c : order) perNode[c.node].push_back(c.id);
+      for (size_t i = 0; ids.size() < order.size(); ++i)
+         for (auto& node : perNode)
+            if (i < node.size()) ids.push_back(node[i]);
+   } else
+      for (auto& c : order) ids.push_back(c.id);
+   std::vector<unsigned> result;
+   for (size_t i = 0; i < n && !ids.empty(); ++i)
+      result.push_back(ids[i % ids.size()]);
+   return result;
+}
+
+Placement Topology::parsePlacement(const std::string& name) {
+   if (name == "physical") return Placement::physical;
+   if (name == "compact") return Placement::compact;
+   if (name == "spread") return Placement::spread;
+   throw std::runtime_error("Unknown placement " + name +
+                            ", expected physical, compact or spread.");
+}
+
+bool pinThread(unsigned cpu) {
+#ifdef __linux__
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+   compat::unused(cpu);
+   return false;
+#endif
+}
+
+ArenaPlacement::ArenaPlacement(size_t nrThreads)
+    : cpus(Topology::get().place(nrThreads)) {
+   observe(true);
+}
+
+ArenaPlacement::~ArenaPlacement() { observe(false); }
+
+void ArenaPlacement::on_scheduler_entry(bool) {
+   if (cpus.empty()) return;
+   pinThread(cpus[next++ % cpus.size()]);
+}
+} // namespace runtime
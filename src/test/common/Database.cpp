@@ -1,5 +1,8 @@
 #include "common/runtime/Database.hpp"
+#include "common/runtime/Concurrency.hpp"
+#include <atomic>
 #include <gtest/gtest.h>
+#include <vector>
 
 using namespace runtime;
 
@@ -37,3 +40,44 @@ TEST(BlockRelation, insertAndRead) {
       }
    }
 }
+
+TEST(BlockRelation, concurrentBlocks) {
+   BlockRelation rel;
+   auto attr = rel.addAttribute("a", sizeof(int64_t));
+   const size_t nrWorkers = 4, nrBlocks = 50, n = 10;
+   std::atomic<size_t> workerIds(0);
+   GlobalPool pool;
+   WorkerGroup workers(nrWorkers);
+   workers.run([&]() {
+      auto previous = this_worker->allocator.setSource(&pool);
+      auto id = workerIds++;
+      for (size_t b = 0; b < nrBlocks; ++b) {
+         auto block = rel.createBlock(n);
+         auto a = reinterpret_cast<int64_t*>(block.data(attr));
+         for (size_t i = 0; i < n; ++i) a[i] = (id * nrBlocks + b) * n + i;
+         block.addedElements(n);
+      }
+      this_worker->allocator.setSource(previous);
+   });
+   // blocks are read after the writers are done
+   size_t blocks = 0;
+   for (auto it = rel.begin(); it != rel.end(); ++it) blocks++;
+   ASSERT_EQ(size_t(0), blocks);
+   rel.finalize();
+   // every value written by the workers is read exactly once
+   std::vector<bool> seen(nrWorkers * nrBlocks * n);
+   size_t found = 0;
+   for (auto& block : rel) {
+      auto a = reinterpret_cast<int64_t*>(block.data(attr));
+      for (size_t i = 0; i < block.size(); ++i) {
+         ASSERT_FALSE(seen[a[i]]);
+         seen[a[i]] = true;
+      }
+      found += block.size();
+   }
+   ASSERT_EQ(seen.size(), found);
+   // reading again yields the same blocks
+   blocks = 0;
+   for (auto it = rel.begin(); it != rel.end(); ++it) blocks++;
+   ASSERT_EQ(nrWorkers * nrBlocks, blocks);
+}
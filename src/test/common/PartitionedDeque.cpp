@@ -24,9 +24,95 @@ TEST(PartitionedDeque, insertAndFind) {
       deque.push_back(&entry.value, entry.hash);
       reference.insert(entry.value);
    }
+   deque.flush();
    for (auto& partition : deque.getPartitions())
       for (auto chunk = partition.first; chunk; chunk = chunk->next)
          for (auto value = chunk->data<uint64_t>(), end = value + chunk_t::size;
               value < end && value != partition.end; value++)
             ASSERT_EQ(reference.erase(*value), size_t(1));
 }
+
+TEST(PartitionedDeque, writeCombining) {
+   struct Entry {
+      uint64_t hash;
+      uint64_t value;
+   };
+   const size_t n = 10003;
+   // chunks do not hold a multiple of the entries of a write combining buffer
+   using deque_t = PartitionedDeque<7>;
+   deque_t deque;
+   deque.postConstruct(16, sizeof(Entry));
+   unordered_set<uint64_t> reference;
+   for (uint64_t i = 0; i < n; i++) {
+      Entry entry{i * 0x9e3779b97f4a7c15ull, i};
+      deque.push_back(&entry, entry.hash);
+      reference.insert(i);
+   }
+   deque.flush();
+   auto& partitions = deque.getPartitions();
+   for (size_t nr = 0; nr < partitions.size(); ++nr) {
+      auto& partition = partitions[nr];
+      for (auto chunk = partition.first; chunk; chunk = chunk->next)
+         for (auto entry = chunk->data<Entry>(),
+                   end = entry + partition.size(chunk, sizeof(Entry));
+              entry < end; entry++) {
+            ASSERT_EQ(entry->value * 0x9e3779b97f4a7c15ull, entry->hash);
+            ASSERT_EQ(nr, entry->hash >> 59);
+            ASSERT_EQ(reference.erase(entry->value), size_t(1));
+         }
+   }
+   ASSERT_EQ(size_t(0), reference.size());
+}
+
+TEST(PartitionedDeque, oddEntrySizes) {
+   // entry sizes do not divide cache lines, so streamed lines and chunks
+   // start at any multiple of 8 within a line
+   const size_t n = 5003;
+   using deque_t = PartitionedDeque<7>;
+   for (size_t entrySize : {24, 40, 56}) {
+      deque_t deque;
+      deque.postConstruct(4, entrySize);
+      vector<uint64_t> entry(entrySize / sizeof(uint64_t));
+      for (uint64_t i = 0; i < n; i++) {
+         entry[0] = i * 0x9e3779b97f4a7c15ull;
+         for (size_t w = 1; w < entry.size(); ++w) entry[w] = i + w;
+         deque.push_back(entry.data(), entry[0]);
+      }
+      deque.flush();
+      vector<bool> seen(n);
+      size_t found = 0;
+      auto& partitions = deque.getPartitions();
+      for (size_t nr = 0; nr < partitions.size(); ++nr) {
+         auto& partition = partitions[nr];
+         for (auto chunk = partition.first; chunk; chunk = chunk->next) {
+            auto data = chunk->data<uint8_t>();
+            ASSERT_EQ(uintptr_t(0), reinterpret_cast<uintptr_t>(data) % 64);
+            for (size_t e = 0; e < partition.size(chunk, entrySize); ++e) {
+               auto words = reinterpret_cast<uint64_t*>(data + e * entrySize);
+               auto i = words[1] - 1;
+               ASSERT_LT(i, n);
+               ASSERT_FALSE(seen[i]);
+               seen[i] = true;
+               ASSERT_EQ(i * 0x9e3779b97f4a7c15ull, words[0]);
+               ASSERT_EQ(nr, words[0] >> 61);
+               for (size_t w = 1; w < entrySize / 8; ++w)
+                  ASSERT_EQ(i + w, words[w]);
+               found++;
+            }
+         }
+      }
+      ASSERT_EQ(n, found);
+   }
+}
+
+TEST(PartitionedDeque, fanOut) {
+   ASSERT_GT(dtlbEntries(), size_t(0));
+   // entries written directly touch a page per partition
+   for (size_t threads : {1, 8, 64, 1024}) {
+      auto fanOut = spillFanOut(threads, 72);
+      ASSERT_GE(fanOut, threads);
+      if (fanOut > threads) {
+         ASSERT_LE(fanOut, dtlbEntries());
+      }
+   }
+}
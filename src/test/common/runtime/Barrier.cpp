@@ -0,0 +1,76 @@
+#include "common/runtime/Barrier.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace runtime;
+
+TEST(Barrier, parkAndRelease) {
+   const size_t nrThreads = 4, rounds = 200;
+   // without spinning, all waiting threads sleep
+   Barrier barrier(nrThreads, 0);
+   std::atomic<size_t> arrived(0);
+   std::atomic<size_t> errors(0);
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < nrThreads; ++t)
+      threads.emplace_back([&]() {
+         for (size_t r = 0; r < rounds; ++r) {
+            arrived++;
+            barrier.wait();
+            // all threads of this round arrived
+            if (arrived < (r + 1) * nrThreads) errors++;
+            barrier.wait();
+         }
+      });
+   for (auto& t : threads) t.join();
+   ASSERT_EQ(errors, size_t(0));
+   auto stats = barrier.stats();
+   ASSERT_EQ(stats.waits, 2 * rounds * (nrThreads - 1));
+}
+
+TEST(Barrier, statsOfSleepers) {
+   Barrier barrier(2, 0);
+   std::thread waiter([&]() { barrier.wait(); });
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   barrier.wait();
+   waiter.join();
+   auto stats = barrier.stats();
+   ASSERT_EQ(stats.waits, uint64_t(1));
+   ASSERT_GE(stats.parks, uint64_t(1));
+   ASSERT_GE(stats.waitNanos, uint64_t(10000000));
+}
+
+TEST(Barrier, abortWakesSleepers) {
+   Barrier barrier(3, 0);
+   std::atomic<size_t> aborted(0);
+   std::vector<std::thread> threads;
+   for (int t = 0; t < 2; ++t)
+      threads.emplace_back([&]() {
+         try {
+            barrier.wait();
+         } catch (BarrierAborted&) { aborted++; }
+      });
+   std::this_thread::sleep_for(std::chrono::milliseconds(10));
+   barrier.abort();
+   for (auto& t : threads) t.join();
+   ASSERT_EQ(aborted, size_t(2));
+}
+
+TEST(Barrier, hierarchicStats) {
+   const size_t nrThreads = 20;
+   auto barriers = HierarchicBarrier::create(nrThreads);
+   std::atomic<size_t> finalized(0);
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < nrThreads; ++t)
+      threads.emplace_back([&, t]() {
+         barriers[t / HierarchicBarrier::threadsPerBarrier]->wait(
+             [&]() { finalized++; });
+      });
+   for (auto& t : threads) t.join();
+   ASSERT_EQ(finalized, size_t(1));
+   // all but the last thread of each barrier waited
+   ASSERT_EQ(HierarchicBarrier::stats(barriers).waits, nrThreads - 1);
+   HierarchicBarrier::destroy(barriers);
+}
@@ -0,0 +1,86 @@
+#include "common/runtime/ChunkCache.hpp"
+#include "common/runtime/MemoryPool.hpp"
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+
+using namespace runtime;
+
+TEST(ChunkCache, reuseZeroed) {
+   ChunkCache cache;
+   const size_t size = 4 * 1024 * 1024;
+   auto p = static_cast<uint8_t*>(cache.allocate(size));
+   for (size_t i = 0; i < size; ++i) p[i] = i;
+   cache.release(p, size, size);
+   ASSERT_EQ(cache.warm(), size);
+   ASSERT_EQ(cache.size(), size);
+
+   // other sizes get fresh mappings
+   auto other = cache.allocate(size / 2);
+   ASSERT_NE(other, p);
+   cache.release(other, size / 2, 0);
+
+   auto q = static_cast<uint8_t*>(cache.allocate(size));
+   ASSERT_EQ(q, p);
+   ASSERT_EQ(cache.warm(), size_t(0));
+   for (size_t i = 0; i < size; ++i) ASSERT_EQ(q[i], 0);
+   cache.release(q, size, size);
+}
+
+TEST(ChunkCache, warmLimit) {
+   ChunkCache cache;
+   const size_t size = 4 * 1024 * 1024;
+   cache.warmLimit = size;
+   auto a = static_cast<uint8_t*>(cache.allocate(size));
+   auto b = static_cast<uint8_t*>(cache.allocate(size));
+   for (size_t i = 0; i < size; ++i) a[i] = b[i] = 1;
+   cache.release(a, size);
+   cache.release(b, size);
+   // the second release exceeds the limit and drops its pages
+   ASSERT_EQ(cache.warm(), size);
+   ASSERT_EQ(cache.size(), 2 * size);
+
+   auto c = static_cast<uint8_t*>(cache.allocate(size));
+   ASSERT_EQ(c, b);
+   for (size_t i = 0; i < size; ++i) ASSERT_EQ(c[i], 0);
+   cache.release(c, size);
+
+   cache.trim(0);
+   ASSERT_EQ(cache.warm(), size_t(0));
+   cache.clear();
+   ASSERT_EQ(cache.size(), size_t(0));
+}
+
+TEST(ChunkCache, poolReuse) {
+   // chunks of a finished pool are reused by the next one
+   void* first;
+   {
+      GlobalPool pool;
+      first = pool.allocate(64);
+      memset(first, 1, 64);
+   }
+   GlobalPool pool;
+   auto second = pool.allocate(64);
+   ASSERT_EQ(second, first);
+   ASSERT_EQ(static_cast<uint8_t*>(second)[0], 0);
+}
+
+TEST(ChunkCache, nodeMappings) {
+   ChunkCache cache;
+   const size_t size = 4 * 1024 * 1024;
+   auto p = cache.allocate(size, 0);
+   cache.release(p, size, 0, 0);
+   // mappings of a node are not handed out for other nodes
+   auto other = cache.allocate(size);
+   ASSERT_NE(other, p);
+   ASSERT_EQ(cache.allocate(size, 0), p);
+   cache.release(other, size, 0);
+   cache.release(p, size, 0, 0);
+   cache.clear();
+
+   // nodes without an arena fall back to the first one
+   GlobalPool pool;
+   auto q = static_cast<uint8_t*>(pool.allocate(64, pool.nodes() + 1));
+   q[63] = 1;
+   ASSERT_GE(pool.nodes(), size_t(1));
+}
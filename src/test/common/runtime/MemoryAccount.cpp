@@ -0,0 +1,64 @@
+#include "common/runtime/Concurrency.hpp"
+#include "common/runtime/Hashmap.hpp"
+#include "common/runtime/MemoryAccount.hpp"
+#include <gtest/gtest.h>
+
+using namespace runtime;
+
+TEST(MemoryAccount, limitAndPeak) {
+   MemoryAccount parent;
+   MemoryAccount account(&parent);
+   account.limit = 100;
+   account.allocate(60);
+   account.allocate(40);
+   ASSERT_EQ(account.used(), size_t(100));
+   ASSERT_EQ(parent.used(), size_t(100));
+   // failing charges are not booked
+   ASSERT_THROW(account.allocate(1), MemoryLimitExceeded);
+   ASSERT_EQ(account.used(), size_t(100));
+   ASSERT_EQ(parent.used(), size_t(100));
+   account.free(50);
+   ASSERT_EQ(account.used(), size_t(50));
+   ASSERT_EQ(account.peak(), size_t(100));
+   ASSERT_EQ(parent.used(), size_t(50));
+
+   parent.limit = 60;
+   ASSERT_THROW(account.allocate(20), MemoryLimitExceeded);
+   ASSERT_EQ(account.used(), size_t(50));
+   account.resetPeak();
+   ASSERT_EQ(account.peak(), size_t(50));
+}
+
+TEST(MemoryAccount, poolAndOperator) {
+   GlobalPool pool;
+   Worker worker;
+   worker.allocator.setSource(&pool);
+   auto reserved = pool.memory.used();
+   ASSERT_GT(reserved, size_t(0));
+   MemoryAccount op;
+   auto previous = this_worker;
+   this_worker = &worker;
+   {
+      MemoryScope scope(op);
+      this_worker->allocator.allocate(32 * 1024 * 1024);
+      Hashmap ht;
+      ht.setSize(1000);
+   }
+   this_worker = previous;
+   ASSERT_GE(op.used(), size_t(32 * 1024 * 1024 + 1000 * 8));
+   ASSERT_EQ(pool.memory.used(), reserved + op.used());
+   ASSERT_EQ(worker.allocator.operatorAccount, nullptr);
+}
+
+TEST(MemoryAccount, limitFailsWorkerGroup) {
+   MemoryAccount account;
+   account.limit = 1;
+   std::atomic<size_t> started(0);
+   WorkerGroup workers(2);
+   // one worker fails, the other one must not wait for it in the barrier
+   auto query = [&]() {
+      if (started++ == 0) account.allocate(2);
+      barrier();
+   };
+   ASSERT_THROW(workers.run(query), MemoryLimitExceeded);
+}
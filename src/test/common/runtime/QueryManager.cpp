@@ -0,0 +1,140 @@
+#include "common/runtime/QueryManager.hpp"
+#include "common/runtime/MemoryAccount.hpp"
+#include "common/runtime/Query.hpp"
+#include "common/runtime/Scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace runtime;
+
+TEST(QueryManager, admitsByCores) {
+   QueryManager manager(4);
+   std::atomic<size_t> active(0), maxActive(0);
+   std::vector<std::future<std::unique_ptr<Query>>> results;
+   for (int q = 0; q < 8; ++q)
+      results.push_back(manager.submit(
+          [&](size_t threads) {
+             EXPECT_EQ(threads, size_t(2));
+             EXPECT_EQ(workerCpus.size(), size_t(2));
+             auto now = ++active;
+             auto seen = maxActive.load();
+             while (now > seen && !maxActive.compare_exchange_weak(seen, now))
+                ;
+             std::this_thread::sleep_for(std::chrono::milliseconds(5));
+             active--;
+             return std::make_unique<Query>();
+          },
+          2));
+   for (auto& r : results) ASSERT_TRUE(r.get() != nullptr);
+   ASSERT_LE(maxActive, size_t(2));
+   manager.wait();
+   ASSERT_EQ(manager.nrRunning(), size_t(0));
+   ASSERT_EQ(manager.nrWaiting(), size_t(0));
+}
+
+TEST(QueryManager, priorityAndBudget) {
+   // the budget fits one query at a time
+   QueryManager manager(8, 100);
+   std::mutex mutex;
+   std::vector<int> order;
+   auto query = [&](int id) {
+      return [&, id](size_t) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(5));
+         std::lock_guard<std::mutex> lock(mutex);
+         order.push_back(id);
+         return std::unique_ptr<Query>();
+      };
+   };
+   manager.submit(query(0), 1, 100);
+   manager.submit(query(1), 1, 100, 0);
+   manager.submit(query(2), 1, 100, 1);
+   manager.submit(query(3), 1, 100, 1);
+   manager.wait();
+   ASSERT_EQ(order, std::vector<int>({0, 2, 3, 1}));
+}
+
+TEST(QueryManager, budgetCountsBookedMemory) {
+   QueryManager manager(8, 1000);
+   std::atomic<bool> booked(false), release(false), ran(false);
+   // declares no memory, but books most of the budget
+   auto large = manager.submit(
+       [&](size_t) {
+          MemoryAccount::process().allocate(800);
+          booked = true;
+          while (!release)
+             std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          MemoryAccount::process().free(800);
+          return std::unique_ptr<Query>();
+       },
+       1, 0);
+   while (!booked) std::this_thread::yield();
+   auto small = manager.submit(
+       [&](size_t) {
+          ran = true;
+          return std::unique_ptr<Query>();
+       },
+       1, 300);
+   std::this_thread::sleep_for(std::chrono::milliseconds(20));
+   ASSERT_FALSE(ran);
+   ASSERT_EQ(manager.nrWaiting(), size_t(1));
+   release = true;
+   large.get();
+   small.get();
+   ASSERT_TRUE(ran);
+}
+
+TEST(QueryManager, failureAndPriority) {
+   QueryManager manager(1);
+   auto failing = manager.submit(
+       [](size_t) -> std::unique_ptr<Query> {
+          throw std::runtime_error("fail");
+       },
+       1);
+   ASSERT_THROW(failing.get(), std::runtime_error);
+   // jobs of a query are submitted with its priority
+   auto priority = manager.submit(
+       [](size_t) {
+          EXPECT_EQ(Scheduler::threadPriority, 3);
+          return std::unique_ptr<Query>();
+       },
+       1, 0, 3);
+   priority.get();
+   ASSERT_EQ(Scheduler::threadPriority, 0);
+}
+
+TEST(QueryManager, cancellation) {
+   QueryManager manager(2);
+   // runs until its deadline passes
+   auto deadline = std::make_shared<Cancellation>();
+   deadline->setTimeout(std::chrono::milliseconds(20));
+   auto running = manager.submit(
+       [&](size_t threads) {
+          auto query = std::make_unique<Query>();
+          WorkerGroup workers(threads);
+          workers.run([&]() {
+             // queries created by the workers are cancelled with this one
+             EXPECT_EQ(Query().cancellation, deadline);
+             while (true) query->cancellation->checkpoint();
+          });
+          return query;
+       },
+       2, 0, 0, deadline);
+   // cancelled while waiting for the cores of the running query
+   auto cancelled = std::make_shared<Cancellation>();
+   std::atomic<bool> ran(false);
+   auto waiting = manager.submit(
+       [&](size_t) {
+          ran = true;
+          return std::make_unique<Query>();
+       },
+       1, 0, 0, cancelled);
+   cancelled->cancel();
+   ASSERT_THROW(running.get(), QueryCancelled);
+   ASSERT_THROW(waiting.get(), QueryCancelled);
+   ASSERT_FALSE(ran);
+   manager.wait();
+}
@@ -0,0 +1,146 @@
+#include "common/runtime/ReadAhead.hpp"
+#include "common/runtime/Mmap.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace runtime;
+
+/// temporary file of a test, removed when the test is done
+struct TempFile {
+   std::string path;
+   TempFile() {
+      char name[] = "/tmp/readaheadXXXXXX";
+      auto fd = mkstemp(name);
+      if (fd < 0) throw std::runtime_error("mkstemp failed");
+      close(fd);
+      path = name;
+   }
+   ~TempFile() { unlink(path.c_str()); }
+};
+
+static void readAll(AsyncReader::Backend backend) {
+   std::vector<uint32_t> v(3 * 1024 * 1024 / 4 + 123);
+   for (size_t i = 0; i < v.size(); ++i) v[i] = uint32_t(i * 7);
+   TempFile file;
+   Vector<uint32_t>::writeBinary(file.path.c_str(), v);
+   int fd = open(file.path.c_str(), O_RDONLY);
+   ASSERT_NE(fd, -1);
+
+   size_t bufferSize = 256 * 1024;
+   AsyncReader reader(4, bufferSize, backend);
+   if (backend == AsyncReader::Backend::threads) {
+      ASSERT_EQ(reader.backend(), AsyncReader::Backend::threads);
+   }
+   auto fileSize = v.size() * sizeof(uint32_t);
+   // keep all buffers in flight and check them in the order of their reads
+   std::vector<std::pair<size_t, size_t>> inFlight;
+   auto checkOldest = [&]() {
+      auto read = inFlight.front();
+      inFlight.erase(inFlight.begin());
+      auto n = reader.wait(read.first);
+      ASSERT_EQ(n, std::min(bufferSize, fileSize - read.second));
+      ASSERT_EQ(std::memcmp(reader.data(read.first),
+                            reinterpret_cast<char*>(v.data()) + read.second,
+                            n),
+                0);
+   };
+   for (size_t offset = 0; offset < fileSize; offset += bufferSize) {
+      if (inFlight.size() == reader.nrBuffers()) checkOldest();
+      inFlight.emplace_back(reader.read(fd, offset, bufferSize), offset);
+   }
+   while (!inFlight.empty()) checkOldest();
+   ASSERT_EQ(reader.bytesRead(), fileSize);
+   ASSERT_TRUE(reader.available());
+   ASSERT_THROW(reader.read(fd, 0, bufferSize + 1), std::runtime_error);
+   close(fd);
+}
+
+TEST(AsyncReader, uring) { readAll(AsyncReader::Backend::uring); }
+
+TEST(AsyncReader, threads) { readAll(AsyncReader::Backend::threads); }
+
+TEST(AsyncReader, failedRead) {
+   for (auto backend :
+        {AsyncReader::Backend::uring, AsyncReader::Backend::threads}) {
+      AsyncReader reader(2, 4096, backend);
+      auto i = reader.read(-1, 0, 4096);
+      ASSERT_THROW(reader.wait(i), std::runtime_error);
+   }
+}
+
+TEST(ReadAhead, requestsColumnsOnce) {
+   size_t n = 300000;
+   std::vector<int32_t> a(n);
+   std::vector<int64_t> b(n);
+   for (size_t i = 0; i < n; ++i) a[i] = int32_t(i), b[i] = int64_t(i);
+   TempFile fileA, fileB;
+   Vector<int32_t>::writeBinary(fileA.path.c_str(), a);
+   Vector<int64_t>::writeBinary(fileB.path.c_str(), b);
+   Relation r;
+   r.nrTuples = n;
+   r.insert("a", std::make_unique<algebra::Integer>())
+       .typedAccessForChange<int32_t>()
+       .readBinary(fileA.path.c_str());
+   r.insert("b", std::make_unique<algebra::BigInt>())
+       .typedAccessForChange<int64_t>()
+       .readBinary(fileB.path.c_str());
+   r.insert("c", std::make_unique<algebra::Integer>()) = std::move(a);
+
+   ASSERT_EQ(ReadAhead::create(r, {"a", "b"}), nullptr);
+   ReadAhead::enabled = true;
+   // columns in memory are not read ahead
+   ASSERT_EQ(ReadAhead::create(r, {"c"}), nullptr);
+   auto ahead = ReadAhead::create(r, {"a", "b", "c"});
+   ReadAhead::enabled = false;
+   ASSERT_NE(ahead, nullptr);
+   // only the windows ahead of the first position are requested
+   auto depth = ReadAhead::depth;
+   ReadAhead::depth = 2;
+   ahead->advance(0);
+   ReadAhead::depth = depth;
+   ASSERT_EQ(ahead->requested(), 2 * ReadAhead::windowSize *
+                                     (sizeof(int32_t) + sizeof(int64_t)));
+   // positions are reported repeatedly and out of order by the scans
+   for (size_t pos = 0; pos < n; pos += 1000) ahead->advance(pos);
+   for (size_t pos = 0; pos < n; pos += 5000) ahead->advance(n - 1 - pos);
+   ReadAhead::advance(nullptr, 0);
+   auto bytes = n * (sizeof(int32_t) + sizeof(int64_t));
+   ASSERT_EQ(ahead->requested(), bytes);
+   // the ring holds more reads than the windows need, all are read by it
+   ASSERT_EQ(ahead->finish(), bytes);
+   ASSERT_EQ(ahead->advised(), size_t(0));
+   // the mapped columns are unchanged
+   auto& column = r["b"].typedAccess<int64_t>();
+   for (size_t i = 0; i < n; ++i) ASSERT_EQ(column[i], int64_t(i));
+}
+
+TEST(ReadAhead, adviseWithoutBuffers) {
+   size_t n = 100000;
+   std::vector<int64_t> a(n, 7);
+   TempFile file;
+   Vector<int64_t>::writeBinary(file.path.c_str(), a);
+   Relation r;
+   r.nrTuples = n;
+   r.insert("a", std::make_unique<algebra::BigInt>())
+       .typedAccessForChange<int64_t>()
+       .readBinary(file.path.c_str());
+
+   ReadAhead::enabled = true;
+   auto buffers = ReadAhead::buffers;
+   ReadAhead::buffers = 0;
+   auto ahead = ReadAhead::create(r, {"a"});
+   ReadAhead::buffers = buffers;
+   ReadAhead::enabled = false;
+   ASSERT_NE(ahead, nullptr);
+   for (size_t pos = 0; pos < n; pos += 1000) ahead->advance(pos);
+   ASSERT_EQ(ahead->requested(), n * sizeof(int64_t));
+   ASSERT_EQ(ahead->advised(), n * sizeof(int64_t));
+   ASSERT_EQ(ahead->finish(), size_t(0));
+}
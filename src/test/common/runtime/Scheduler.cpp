@@ -0,0 +1,135 @@
+#include "common/runtime/Query.hpp"
+#include "common/runtime/Scheduler.hpp"
+#include "hyper/ParallelHelper.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace runtime;
+
+TEST(Scheduler, allMorselsOnce) {
+   Scheduler scheduler(3);
+   const size_t n = 100003;
+   std::vector<std::atomic<uint8_t>> seen(n);
+   for (auto& s : seen) s = 0;
+   scheduler.parallelFor(n, 1000, [&](size_t begin, size_t end) {
+      ASSERT_LE(end - begin, size_t(1000));
+      for (auto i = begin; i < end; ++i) seen[i]++;
+   });
+   for (size_t i = 0; i < n; ++i) ASSERT_EQ(seen[i], 1);
+}
+
+TEST(Scheduler, concurrentJobs) {
+   Scheduler scheduler(2);
+   std::atomic<size_t> sums[4];
+   std::vector<std::thread> submitters;
+   for (int q = 0; q < 4; ++q) {
+      sums[q] = 0;
+      submitters.emplace_back([&, q]() {
+         scheduler.parallelFor(
+             10000, 10,
+             [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; ++i) sums[q] += i;
+             },
+             q);
+      });
+   }
+   for (auto& t : submitters) t.join();
+   for (int q = 0; q < 4; ++q) ASSERT_EQ(sums[q], size_t(10000 * 9999 / 2));
+}
+
+TEST(Scheduler, submitterSleeps) {
+   using namespace std::chrono;
+   Scheduler scheduler(1);
+   std::atomic<bool> started(false), finished(false);
+   auto cpuNanos = []() {
+      timespec t;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+      return t.tv_sec * 1000000000l + t.tv_nsec;
+   };
+   auto before = cpuNanos();
+   scheduler.parallelFor(2, 1, [&](size_t, size_t) {
+      if (Scheduler::threadId()) {
+         started = true;
+         std::this_thread::sleep_for(milliseconds(200));
+         finished = true;
+      } else {
+         // keep the second morsel for the scheduler thread
+         while (!started) std::this_thread::sleep_for(milliseconds(1));
+      }
+   });
+   ASSERT_TRUE(finished);
+   // the submitter did not spin while the other morsel was processed
+   ASSERT_LT(cpuNanos() - before, 100000000l);
+}
+
+TEST(Scheduler, queryResources) {
+   Scheduler scheduler(2);
+   Query query;
+   std::atomic<size_t> wrongPool(0);
+   scheduler.parallelFor(
+       1000, 1,
+       [&](size_t, size_t) {
+          if (Scheduler::threadId() &&
+              this_worker->allocator.memorySource != &query.pool)
+             wrongPool++;
+          this_worker->allocator.allocate(64);
+       },
+       0, &query);
+   ASSERT_EQ(wrongPool, size_t(0));
+}
+
+TEST(Scheduler, failure) {
+   Scheduler scheduler(2);
+   ASSERT_THROW(scheduler.parallelFor(100000, 1,
+                                      [&](size_t begin, size_t) {
+                                         if (begin == 10)
+                                            throw std::runtime_error("fail");
+                                      }),
+                std::runtime_error);
+   // the scheduler is usable afterwards
+   std::atomic<size_t> count(0);
+   scheduler.parallelFor(100, 1, [&](size_t, size_t) { count++; });
+   ASSERT_EQ(count, size_t(100));
+}
+
+TEST(Scheduler, cancellation) {
+   Scheduler scheduler(2);
+   Query query;
+   std::atomic<size_t> morsels(0);
+   ASSERT_THROW(scheduler.parallelFor(
+                    100000, 1,
+                    [&](size_t, size_t) {
+                       if (++morsels == 10) query.cancellation->cancel();
+                    },
+                    0, &query),
+                QueryCancelled);
+   // morsels already claimed by other threads may still run
+   ASSERT_LT(morsels, size_t(100));
+}
+
+/// a hyper query counting n tuples
+static size_t countQuery(size_t n) {
+   auto resources = initQuery(1);
+   std::atomic<size_t> count(0);
+   Scheduler::global().parallelFor(
+       n, morselSize, [&](size_t begin, size_t end) { count += end - begin; });
+   leaveQuery(resources);
+   return count;
+}
+
+TEST(Scheduler, cancelledHyperQueryLeaves) {
+   auto before = this_worker;
+   auto cancellation = std::make_shared<Cancellation>();
+   cancellation->cancel();
+   Cancellation::current = cancellation;
+   ASSERT_THROW(countQuery(100000), QueryCancelled);
+   Cancellation::current = nullptr;
+   // the thread no longer uses the workers of the cancelled query
+   ASSERT_EQ(this_worker, before);
+   ASSERT_EQ(countQuery(100000), size_t(100000));
+   ASSERT_EQ(this_worker, before);
+}
@@ -0,0 +1,81 @@
+#include "common/runtime/Concurrency.hpp"
+#include <atomic>
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace runtime;
+
+TEST(ThreadSpecific, elementPerThread) {
+   const size_t nrThreads = 8;
+   thread_specific<std::vector<size_t>> locals;
+   // threads finish together, the index of a finished thread is reused
+   Barrier done(nrThreads);
+   std::vector<std::thread> threads;
+   for (size_t t = 0; t < nrThreads; ++t)
+      threads.emplace_back([&, t]() {
+         for (size_t i = 0; i < 1000; ++i) locals.local().push_back(t);
+         bool exists;
+         locals.local(exists);
+         EXPECT_TRUE(exists);
+         done.wait();
+      });
+   for (auto& t : threads) t.join();
+   ASSERT_EQ(locals.size(), nrThreads);
+   std::set<size_t> owners;
+   for (auto& local : locals) {
+      ASSERT_EQ(local.size(), size_t(1000));
+      for (auto t : local) ASSERT_EQ(t, local.front());
+      owners.insert(local.front());
+   }
+   ASSERT_EQ(owners.size(), nrThreads);
+   ASSERT_EQ(locals.elements().size(), nrThreads);
+}
+
+TEST(ThreadSpecific, createOnce) {
+   thread_specific<std::vector<int>> locals;
+   auto& v = locals.create(3, 7);
+   ASSERT_EQ(v.size(), size_t(3));
+   // an existing element is returned unchanged
+   ASSERT_EQ(&locals.create(5, 1), &v);
+   ASSERT_EQ(&locals.local(), &v);
+}
+
+TEST(ThreadSpecific, denseThreadIndexes) {
+   // indexes of finished threads are reused
+   std::atomic<size_t> maxIndex(0);
+   for (int round = 0; round < 50; ++round) {
+      std::thread t([&]() {
+         auto index = threadIndex();
+         ASSERT_EQ(threadIndex(), index);
+         if (index > maxIndex) maxIndex = index;
+      });
+      t.join();
+   }
+   ASSERT_LT(maxIndex, size_t(8));
+}
+
+TEST(ThreadSpecific, freshElementForReusedIndex) {
+   thread_specific<std::vector<int>> locals;
+   size_t firstIndex;
+   std::thread first([&]() {
+      firstIndex = threadIndex();
+      locals.local().push_back(1);
+   });
+   first.join();
+   // the element of the finished thread is still there
+   ASSERT_EQ(locals.size(), size_t(1));
+   std::thread second([&]() {
+      // the index of the finished thread is the lowest free one
+      EXPECT_EQ(threadIndex(), firstIndex);
+      bool exists;
+      auto& local = locals.local(exists);
+      EXPECT_FALSE(exists);
+      EXPECT_TRUE(local.empty());
+      local.push_back(2);
+   });
+   second.join();
+   ASSERT_EQ(locals.size(), size_t(1));
+   ASSERT_EQ(locals.begin()->front(), 2);
+}
@@ -0,0 +1,79 @@
+#include "common/runtime/Topology.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+using namespace runtime;
+
+/// sysfs cpu directory of 2 sockets with 2 cores and 2 SMT threads each.
+/// Cpus 0-3 are the first threads of the cores, 4-7 their siblings
+static std::string fakeSysfs() {
+   char dir[] = "/tmp/topologyXXXXXX";
+   std::string root = mkdtemp(dir);
+   for (unsigned id = 0; id < 8; ++id) {
+      auto cpu = root + "/cpu" + std::to_string(id);
+      auto package = (id % 4) / 2;
+      mkdir(cpu.c_str(), 0755);
+      mkdir((cpu + "/topology").c_str(), 0755);
+      mkdir((cpu + "/node" + std::to_string(package)).c_str(), 0755);
+      std::ofstream(cpu + "/topology/physical_package_id") << package << "\n";
+      std::ofstream(cpu + "/topology/core_id") << id % 2 << "\n";
+   }
+   return root;
+}
+
+TEST(Topology, placements) {
+   auto root = fakeSysfs();
+   auto t = Topology::read(root, {0, 1, 2, 3, 4, 5, 6, 7});
+   ASSERT_EQ(t.nrNodes, size_t(2));
+   ASSERT_EQ(t.place(8, Placement::physical),
+             std::vector<unsigned>({0, 1, 2, 3, 4, 5, 6, 7}));
+   ASSERT_EQ(t.place(8, Placement::compact),
+             std::vector<unsigned>({0, 4, 1, 5, 2, 6, 3, 7}));
+   ASSERT_EQ(t.place(8, Placement::spread),
+             std::vector<unsigned>({0, 2, 1, 3, 4, 6, 5, 7}));
+   // more workers than cpus share them
+   ASSERT_EQ(t.place(10, Placement::physical).back(), 1u);
+   system(("rm -rf " + root).c_str());
+}
+
+TEST(Topology, cpuset) {
+   auto root = fakeSysfs();
+   // a container restricted to some cpus
+   auto t = Topology::read(root, {1, 3, 5});
+   ASSERT_EQ(t.cpus.size(), size_t(3));
+   ASSERT_EQ(t.place(4, Placement::physical),
+             std::vector<unsigned>({1, 3, 5, 1}));
+   ASSERT_EQ(t.place(3, Placement::compact),
+             std::vector<unsigned>({1, 5, 3}));
+   system(("rm -rf " + root).c_str());
+}
+
+TEST(Topology, cpusetOfLastNode) {
+   auto root = fakeSysfs();
+   // cpus 2, 3, 6 and 7 are on the second node of the kernel
+   auto t = Topology::read(root, {2, 3, 6, 7});
+   ASSERT_EQ(t.nrNodes, size_t(1));
+   for (auto& cpu : t.cpus) ASSERT_EQ(cpu.node, 0u);
+   // memory is bound to the node id of the kernel
+   ASSERT_EQ(t.osNode(0), 1u);
+   auto all = Topology::read(root, {0, 1, 2, 3, 4, 5, 6, 7});
+   ASSERT_EQ(all.osNode(1), 1u);
+   system(("rm -rf " + root).c_str());
+}
+
+TEST(Topology, detect) {
+   auto& t = Topology::get();
+   ASSERT_GT(t.cpus.size(), size_t(0));
+   // pin another thread, the test thread keeps its affinity
+   std::thread([&]() {
+      EXPECT_TRUE(pinThread(t.cpus.front().id));
+      // cpus outside of the cpuset are refused instead of failing
+      EXPECT_FALSE(pinThread(CPU_SETSIZE - 1));
+   }).join();
+   ASSERT_THROW(Topology::parsePlacement("random"), std::runtime_error);
+}
@@ -0,0 +1,53 @@
+#include "common/runtime/Types.hpp"
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+
+using namespace types;
+
+TEST(NumericSum, carry) {
+   // adding across the 64 bit boundary in both directions keeps the value
+   const int64_t max = std::numeric_limits<int64_t>::max();
+   NumericSum<12, 2> sum;
+   __int128 expected = 0;
+   for (int i = 0; i < 5; ++i) {
+      sum += Numeric<12, 2>(max);
+      expected += max;
+      ASSERT_TRUE(sum.getRaw() == expected);
+   }
+   ASSERT_FALSE(sum.fits64());
+   for (int i = 0; i < 9; ++i) {
+      sum += Numeric<12, 2>(-max);
+      expected -= max;
+      ASSERT_TRUE(sum.getRaw() == expected);
+   }
+   NumericSum<12, 2> other;
+   other += Numeric<12, 2>(max);
+   other += Numeric<12, 2>(max);
+   sum += other;
+   ASSERT_FALSE(sum.fits64());
+   sum += other;
+   sum += Numeric<12, 2>(-max);
+   ASSERT_TRUE(sum.fits64());
+   ASSERT_EQ(sum, (Numeric<12, 2>(-max)));
+   ASSERT_EQ(sum.castN(), (Numeric<12, 2>(-max)));
+}
+
+TEST(NumericSum, output) {
+   auto print = [](const NumericSum<12, 2>& sum) {
+      std::stringstream out;
+      out << sum;
+      return out.str();
+   };
+   NumericSum<12, 2> sum(Numeric<12, 2>::castString("-0.05"));
+   ASSERT_EQ(print(sum), "-0.05");
+   sum = NumericSum<12, 2>(Numeric<12, 2>::castString("1234.5"));
+   ASSERT_EQ(print(sum), "1234.50");
+   // 2 * (2^63 - 1) = 18446744073709551614
+   sum = NumericSum<12, 2>();
+   sum += Numeric<12, 2>(std::numeric_limits<int64_t>::max());
+   sum += Numeric<12, 2>(std::numeric_limits<int64_t>::max());
+   ASSERT_EQ(print(sum), "184467440737095516.14");
+   ASSERT_EQ(sum.avg(4).getRaw(), std::numeric_limits<int64_t>::max() / 2);
+}
@@ -0,0 +1,117 @@
+#include "hyper/GroupBy.hpp"
+#include "common/runtime/Concurrency.hpp"
+#include "common/runtime/Hash.hpp"
+#include "common/runtime/Types.hpp"
+#include <atomic>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <map>
+#include <mutex>
+#include <tbb/task_arena.h>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+template <typename K, typename G>
+static map<K, int64_t> collect(G& groupOp) {
+   map<K, int64_t> result;
+   mutex m;
+   // only the calling thread has a worker to allocate merged groups
+   tbb::task_arena arena(1);
+   arena.execute([&]() {
+      groupOp.forallGroups([&](auto& entries) {
+         lock_guard<mutex> lock(m);
+         for (auto block : entries)
+            for (auto& entry : block) {
+               EXPECT_EQ(result.count(entry.k), size_t(0));
+               result[entry.k] = entry.v;
+            }
+      });
+   });
+   return result;
+}
+
+template <typename K, typename KEYOF>
+static void checkGroups(size_t nrTuples, size_t nrThreads, KEYOF keyOf) {
+   // each thread pre-aggregates a slice of the tuples, value of tuple i is i
+   auto groupOp = make_GroupBy<K, int64_t, runtime::CRC32Hash>(
+       aggregates::Sum(), int64_t(0), nrThreads);
+   map<K, int64_t> expected;
+   for (size_t i = 0; i < nrTuples; ++i) expected[keyOf(i)] += i;
+   atomic<size_t> workerIds(0);
+   runtime::GlobalPool pool;
+   runtime::WorkerGroup workers(nrThreads);
+   workers.run([&]() {
+      auto previous = runtime::this_worker->allocator.setSource(&pool);
+      {
+         auto locals = groupOp.preAggLocals();
+         for (size_t i = workerIds++; i < nrTuples; i += nrThreads)
+            locals.consume(keyOf(i), int64_t(i));
+      }
+      runtime::this_worker->allocator.setSource(previous);
+   });
+   ASSERT_EQ(expected, collect<K>(groupOp));
+}
+
+TEST(GroupBy, packedKeys) {
+   // keys of up to 16 bits are aggregated in arrays
+   using types::Char;
+   auto char1 = [](size_t i) {
+      Char<1> c;
+      c.value = char('A' + i % 26);
+      return c;
+   };
+   checkGroups<Char<1>>(10000, 4, char1);
+   checkGroups<int8_t>(10000, 4, [](size_t i) { return int8_t(i % 256); });
+   checkGroups<tuple<Char<1>, Char<1>>>(10000, 4, [&](size_t i) {
+      return make_tuple(char1(i), char1(i / 26));
+   });
+   checkGroups<tuple<int8_t, Char<1>>>(10000, 4, [&](size_t i) {
+      return make_tuple(int8_t(i % 7 - 3), char1(i / 7));
+   });
+}
+
+TEST(GroupBy, mergeFewGroups) {
+   // at most singlePhaseGroupLimit local groups of all threads are merged
+   // in parts, without spilling
+   checkGroups<int64_t>(30000, 4, [](size_t i) { return int64_t(i % 1000); });
+   checkGroups<int64_t>(30000, 3, [](size_t i) { return int64_t(i % 200); });
+}
+
+TEST(GroupBy, spillManyGroups) {
+   // more groups than singlePhaseGroupLimit are aggregated from spill
+   // partitions
+   ASSERT_GT(size_t(10000), runtime::singlePhaseGroupLimit);
+   checkGroups<int64_t>(100000, 4,
+                        [](size_t i) { return int64_t(i * 7 % 10000); });
+}
+
+TEST(GroupBy, bypassWithoutLocality) {
+   // unique keys do not reduce the input, pre-aggregation is bypassed
+   auto groupOp = make_GroupBy<int64_t, int64_t, runtime::CRC32Hash>(
+       aggregates::Sum(), int64_t(0), 1);
+   {
+      auto locals = groupOp.preAggLocals();
+      for (int64_t i = 0; i < 20000; ++i) locals.consume(i, int64_t(1));
+   }
+   ASSERT_GT(groupOp.bypassedWindows(), size_t(0));
+   auto result = collect<int64_t>(groupOp);
+   ASSERT_EQ(size_t(20000), result.size());
+   for (auto& group : result) ASSERT_EQ(int64_t(1), group.second);
+}
+
+TEST(GroupBy, aggregateWithLocality) {
+   // few distinct keys, pre-aggregation stays on
+   auto groupOp = make_GroupBy<int64_t, int64_t, runtime::CRC32Hash>(
+       aggregates::Sum(), int64_t(0), 1);
+   {
+      auto locals = groupOp.preAggLocals();
+      for (int64_t i = 0; i < 20000; ++i) locals.consume(i % 100, i);
+   }
+   ASSERT_EQ(size_t(0), groupOp.bypassedWindows());
+   auto result = collect<int64_t>(groupOp);
+   ASSERT_EQ(size_t(100), result.size());
+   for (auto& group : result)
+      ASSERT_EQ(group.first * 200 + 100 * 199 * 100, group.second);
+}
@@ -33,6 +33,7 @@ static void configFromEnv() {
    if (auto v = std::getenv("SIMDjoin")) conf.useSimdJoin = atoi(v);
    if (auto v = std::getenv("SIMDsel")) conf.useSimdSel = atoi(v);
    if (auto v = std::getenv("SIMDproj")) conf.useSimdProj = atoi(v);
+   if (auto v = std::getenv("SIMDaggr")) conf.useSimdAggr = atoi(v);
 }
 
 TEST(SSB, q11) {
@@ -31,6 +31,7 @@ static void configFromEnv(){
   if (auto v = std::getenv("SIMDjoin")) conf.useSimdJoin = atoi(v);
   if (auto v = std::getenv("SIMDsel")) conf.useSimdSel = atoi(v);
   if (auto v = std::getenv("SIMDproj")) conf.useSimdProj = atoi(v);
+  if (auto v = std::getenv("SIMDaggr")) conf.useSimdAggr = atoi(v);
 }
 
 TEST(TPCH, q1) {
@@ -87,7 +88,7 @@ TEST(TPCH, q1) {
          auto disc_price =
              reinterpret_cast<Numeric<12, 4>*>(block.data(disc_priceAttr));
          auto charge =
-             reinterpret_cast<Numeric<12, 6>*>(block.data(chargeAttr));
+             reinterpret_cast<NumericSum<12, 6>*>(block.data(chargeAttr));
          auto count_order =
              reinterpret_cast<int64_t*>(block.data(count_orderAttr));
          for (size_t i = 0; i < elementsInBlock; ++i) {
@@ -7,6 +7,7 @@
 #include "vectorwise/Primitives.hpp"
 #include "vectorwise/Query.hpp"
 #include "vectorwise/QueryBuilder.hpp"
+#include <algorithm>
 #include <gtest/gtest.h>
 #include <map>
 #include <unordered_set>
@@ -237,6 +238,84 @@ TEST(Join, simpleJoinWithResultOverflow) {
    ASSERT_EQ(expectedKeys.size(), found);
 }
 
+struct LateMaterializationBuilder : public Query,
+                                    private vectorwise::QueryBuilder {
+   enum { rowIds, buildRowIds, probe_matches, buildValue, probeValue };
+   runtime::GlobalPool pool;
+   LateMaterializationBuilder(runtime::Database& db, size_t v = 1024)
+       : Query(), QueryBuilder(db, shared, v) {
+      previous = runtime::this_worker->allocator.setSource(&pool);
+   }
+   unique_ptr<vectorwise::Operator> getQuery() {
+      auto build = Scan("build");
+      // wide columns are fetched late if few rows reach the fetch
+      EXPECT_TRUE(materializeLate(build, "w", 1, 0.5));
+      EXPECT_FALSE(materializeLate(build, "w", 1, 1));
+      EXPECT_TRUE(materializeLate(build, "w", 3, 1));
+      EXPECT_FALSE(materializeLate(build, "k", 1, 0.1));
+      RowIds(build, Buffer(rowIds, sizeof(uint64_t)));
+      auto probe = Scan("probe");
+      HashJoin(Buffer(probe_matches, sizeof(pos_t)))
+          .addBuildKey(Column(build, "k"), conf.hash_int32_t_col(),
+                       primitives::scatter_int32_t_col)
+          .addProbeKey(Column(probe, "b"), conf.hash_int32_t_col(),
+                       primitives::keys_equal_int32_t_col)
+          .addBuildValue(Buffer(rowIds), primitives::scatter_int64_t_col,
+                         Buffer(buildRowIds, sizeof(uint64_t)),
+                         primitives::gather_col_int64_t_col);
+      Materialize()
+          .addColumn(build, "w", Buffer(buildRowIds),
+                     primitives::materialize_rowid_Char_25_col,
+                     Buffer(buildValue, sizeof(types::Char<25>)))
+          .addColumn(Column(probe, "p"), Buffer(probe_matches),
+                     primitives::materialize_sel_int32_t_col,
+                     Buffer(probeValue, sizeof(int32_t)));
+      return popOperator();
+   }
+   types::Char<25>* buildValues() {
+      return reinterpret_cast<types::Char<25>*>(Buffer(buildValue).data);
+   }
+   int32_t* probeValues() {
+      return reinterpret_cast<int32_t*>(Buffer(probeValue).data);
+   }
+};
+
+TEST(Join, lateMaterialization) {
+   runtime::Database db;
+   auto& build = db["build"];
+   build.insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 3, 4, 8};
+   auto& w = build.insert("w", make_unique<algebra::Char>(25))
+                 .typedAccessForChange<types::Char<25>>();
+   w.reset(4);
+   for (auto s : {"one", "three", "four", "eight"}) {
+      auto value = types::Char<25>::castString(s, strlen(s));
+      w.push_back(value);
+   }
+   db["probe"].insert("b", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{88, 1, 1, 17, 4, 3};
+   db["probe"].insert("p", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{0, 10, 11, 12, 40, 30};
+   build.nrTuples = 4;
+   db["probe"].nrTuples = 6;
+
+   // use small vectors to check that row ids are global
+   LateMaterializationBuilder b(db, 2);
+   auto root = b.getQuery();
+   std::map<int32_t, std::string> expected = {
+       {10, "one"}, {11, "one"}, {40, "four"}, {30, "three"}};
+   size_t found = 0;
+   while (auto n = root->next()) {
+      for (size_t i = 0; i < n; ++i) {
+         auto& buildValue = b.buildValues()[i];
+         ASSERT_EQ(expected[b.probeValues()[i]],
+                   std::string(buildValue.value, buildValue.len));
+      }
+      found += n;
+   }
+   ASSERT_EQ(expected.size(), found);
+}
+
 struct JoinBuildSelectBuilder : public Query, private vectorwise::QueryBuilder {
    enum { buildValue, sel_key, probe_matches };
    struct Result {
@@ -312,6 +391,7 @@ struct ProbeSelectBuilder : public Query, private vectorwise::QueryBuilder {
       std::unique_ptr<vectorwise::Operator> rootOp;
    };
    runtime::GlobalPool pool;
+   bool unique = false;
    ProbeSelectBuilder(runtime::Database& db, size_t v = 1024)
        : Query(), QueryBuilder(db, shared, v) {
       previous = runtime::this_worker->allocator.setSource(&pool);
@@ -325,6 +405,7 @@ struct ProbeSelectBuilder : public Query, private vectorwise::QueryBuilder {
                                 Column(probe, "b"), Value(&r->bound)));
       HashJoin(Buffer(probe_matches, sizeof(pos_t)))
           .setProbeSelVector(Buffer(sel_probe))
+          .setUniqueBuildKeys(unique)
           .addBuildKey(Column(build, "k"), primitives::hash_int64_t_col,
                        primitives::scatter_int64_t_col)
           .addProbeKey(Column(probe, "b"), Buffer(sel_probe),
@@ -364,6 +445,44 @@ TEST(Join, joinProbeSelection) {
       ASSERT_NE(e, vMatches.end());
    }
 }
+TEST(Join, uniqueJoinProbeSelection) {
+
+   runtime::Database db;
+   db["build"].insert("k", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>{1, 3, 4, 8};
+   db["probe"].insert("b", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>{88, 8, 1, 1, 17, 4, 3, 3, 3,
+                            3,  3, 3, 3, 3,  3, 3, 3, 3};
+   db["build"].nrTuples = 4;
+   db["probe"].nrTuples = 18;
+
+   // small vectors, every probe vector is handled in one join call
+   ProbeSelectBuilder b(db, 5);
+   b.unique = true;
+   auto query = b.getQuery();
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   auto select = dynamic_cast<Select*>(join->right.get());
+   ASSERT_NE(nullptr, select);
+   auto probe = dynamic_cast<Scan*>(select->child.get());
+   ASSERT_NE(nullptr, probe);
+   unordered_multiset<int64_t> expected{2,  3,  6,  7,  8,  9,  10,
+                                        11, 12, 13, 14, 15, 16, 17};
+   while (auto n = query->rootOp->next()) {
+      ASSERT_LE(n, pos_t(5));
+      for (size_t i = 0; i < n; ++i) {
+         int64_t row = *probe->currentOffset() + join->probeMatches[i];
+         auto e = expected.find(row);
+         ASSERT_NE(e, expected.end());
+         expected.erase(e);
+         auto key = *addBytes(reinterpret_cast<int64_t*>(join->buildMatches[i]),
+                              sizeof(runtime::Hashmap::EntryHeader));
+         ASSERT_EQ(row < 6 ? 1 : 3, key);
+      }
+   }
+   ASSERT_EQ(size_t(0), expected.size());
+}
+
 TEST(Join, joinProbeSelectionAndResultOverflow) {
 
    runtime::Database db;
@@ -398,6 +517,313 @@ TEST(Join, joinProbeSelectionAndResultOverflow) {
    ASSERT_EQ(expectedKeys.size(), found);
 }
 
+struct ModeJoinBuilder : public Query, private vectorwise::QueryBuilder {
+   enum { buildValue, marker, probe_matches };
+   struct Result {
+      int32_t* v = nullptr;
+      uint8_t* marker = nullptr;
+      std::unique_ptr<vectorwise::Operator> rootOp;
+   };
+   runtime::GlobalPool pool;
+   ModeJoinBuilder(runtime::Database& db, size_t v = 1024)
+       : Query(), QueryBuilder(db, shared, v) {
+      previous = runtime::this_worker->allocator.setSource(&pool);
+   }
+   unique_ptr<Result> getQuery(Hashjoin::Mode mode, bool withMarker = true) {
+      auto r = make_unique<Result>();
+      auto build = Scan("build");
+      auto probe = Scan("probe");
+      auto hj = HashJoin(Buffer(probe_matches, sizeof(pos_t)), mode);
+      hj.addBuildKey(Column(build, "k"), conf.hash_int32_t_col(),
+                     primitives::scatter_int32_t_col)
+          .addProbeKey(Column(probe, "b"), conf.hash_int32_t_col(),
+                       primitives::keys_equal_int32_t_col);
+      if (mode == Hashjoin::Mode::LeftOuter) {
+         hj.addBuildValue(Column(build, "v"), primitives::scatter_int32_t_col,
+                          Buffer(buildValue, sizeof(int32_t)),
+                          primitives::gather_col_int32_t_col);
+         r->v = reinterpret_cast<int32_t*>(Buffer(buildValue).data);
+      }
+      if (withMarker && (mode == Hashjoin::Mode::LeftOuter ||
+                         mode == Hashjoin::Mode::Mark)) {
+         hj.setMarker(Buffer(marker, sizeof(uint8_t)));
+         r->marker = reinterpret_cast<uint8_t*>(Buffer(marker).data);
+      }
+      r->rootOp = popOperator();
+      return r;
+   }
+};
+
+static void modeJoinData(runtime::Database& db) {
+   db["build"].insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 3, 3, 3, 4, 8};
+   db["build"].insert("v", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{101, 103, 203, 303, 104, 108};
+   db["probe"].insert("b", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{88, 1, 3, 17, 4, 2, 3, 5};
+   db["build"].nrTuples = 6;
+   db["probe"].nrTuples = 8;
+}
+
+TEST(Join, semiJoin) {
+   runtime::Database db;
+   modeJoinData(db);
+   ModeJoinBuilder b(db);
+   auto query = b.getQuery(Hashjoin::Mode::Semi);
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   std::vector<pos_t> found;
+   while (auto n = query->rootOp->next())
+      found.insert(found.end(), join->probeMatches, join->probeMatches + n);
+   // every probe tuple at most once, despite duplicate build keys
+   ASSERT_EQ(std::vector<pos_t>({1, 2, 4, 6}), found);
+}
+
+TEST(Join, antiJoin) {
+   runtime::Database db;
+   modeJoinData(db);
+   ModeJoinBuilder b(db);
+   auto query = b.getQuery(Hashjoin::Mode::Anti);
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   std::vector<pos_t> found;
+   while (auto n = query->rootOp->next())
+      found.insert(found.end(), join->probeMatches, join->probeMatches + n);
+   ASSERT_EQ(std::vector<pos_t>({0, 3, 5, 7}), found);
+}
+
+TEST(Join, antiJoinEmptyBuild) {
+   runtime::Database db;
+   db["build"].insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{};
+   db["build"].insert("v", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{};
+   db["probe"].insert("b", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 2, 3};
+   db["build"].nrTuples = 0;
+   db["probe"].nrTuples = 3;
+   ModeJoinBuilder b(db);
+   auto query = b.getQuery(Hashjoin::Mode::Anti);
+   ASSERT_EQ(size_t(3), query->rootOp->next());
+   ASSERT_EQ(size_t(0), query->rootOp->next());
+}
+
+TEST(Join, markJoin) {
+   runtime::Database db;
+   modeJoinData(db);
+   ModeJoinBuilder b(db);
+   auto query = b.getQuery(Hashjoin::Mode::Mark);
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   auto n = query->rootOp->next();
+   ASSERT_EQ(size_t(8), n);
+   std::vector<uint8_t> expected{0, 1, 1, 0, 1, 0, 1, 0};
+   for (size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(pos_t(i), join->probeMatches[i]);
+      ASSERT_EQ(expected[i], query->marker[i]);
+   }
+   ASSERT_EQ(size_t(0), query->rootOp->next());
+}
+
+TEST(Join, markJoinWithoutMarker) {
+   runtime::Database db;
+   modeJoinData(db);
+   // small vectors, so that the marker is written for several of them
+   ModeJoinBuilder b(db, 3);
+   auto query = b.getQuery(Hashjoin::Mode::Mark, false);
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   ASSERT_NE(nullptr, join->marker);
+   auto probe = dynamic_cast<Scan*>(join->right.get());
+   ASSERT_NE(nullptr, probe);
+   std::vector<uint8_t> expected{0, 1, 1, 0, 1, 0, 1, 0};
+   size_t found = 0;
+   while (auto n = query->rootOp->next()) {
+      ASSERT_LE(n, size_t(3));
+      for (size_t i = 0; i < n; ++i) {
+         auto row = *probe->currentOffset() + join->probeMatches[i];
+         ASSERT_EQ(expected[row], join->marker[i]);
+      }
+      found += n;
+   }
+   ASSERT_EQ(size_t(8), found);
+}
+
+TEST(Join, leftOuterJoin) {
+   runtime::Database db;
+   modeJoinData(db);
+   // small vectors, so that matches and outer tuples overflow
+   ModeJoinBuilder b(db, 3);
+   auto query = b.getQuery(Hashjoin::Mode::LeftOuter);
+   auto join = dynamic_cast<Hashjoin*>(query->rootOp.get());
+   ASSERT_NE(nullptr, join);
+   auto probe = dynamic_cast<Scan*>(join->right.get());
+   ASSERT_NE(nullptr, probe);
+   unordered_multiset<int64_t> expected{
+       // probe position * 1000 + build value, 0 for outer tuples
+       0, 1101, 2103, 2203, 2303, 3000, 4104, 5000, 6103, 6203, 6303, 7000};
+   size_t found = 0;
+   while (auto n = query->rootOp->next()) {
+      ASSERT_LE(n, size_t(3));
+      for (size_t i = 0; i < n; ++i) {
+         ASSERT_EQ(query->v[i] != 0, query->marker[i] == 1);
+         auto row = *probe->currentOffset() + join->probeMatches[i];
+         auto e = expected.find(row * 1000 + query->v[i]);
+         ASSERT_NE(e, expected.end());
+         expected.erase(e);
+      }
+      found += n;
+   }
+   ASSERT_EQ(size_t(12), found);
+   ASSERT_EQ(size_t(0), expected.size());
+}
+
+struct GroupJoinBuilder : public Query, private vectorwise::QueryBuilder {
+   enum { buildValue, sum, probe_matches };
+   struct Result {
+      int32_t* v;
+      int64_t* sum;
+      std::unique_ptr<vectorwise::Operator> rootOp;
+   };
+   runtime::GlobalPool pool;
+   GroupJoinBuilder(runtime::Database& db, size_t v = 1024)
+       : Query(), QueryBuilder(db, shared, v) {
+      previous = runtime::this_worker->allocator.setSource(&pool);
+   }
+   unique_ptr<Result> getQuery() {
+      auto r = make_unique<Result>();
+      auto build = Scan("build");
+      auto probe = Scan("probe");
+      HashJoin(Buffer(probe_matches, sizeof(pos_t)), Hashjoin::Mode::Group)
+          .addBuildKey(Column(build, "k"), conf.hash_int32_t_col(),
+                       primitives::scatter_int32_t_col)
+          .addProbeKey(Column(probe, "b"), conf.hash_int32_t_col(),
+                       primitives::keys_equal_int32_t_col)
+          .addBuildValue(Column(build, "v"), primitives::scatter_int32_t_col,
+                         Buffer(buildValue, sizeof(int32_t)),
+                         primitives::gather_col_int32_t_col)
+          .addGroupAggregate(Column(probe, "q"),
+                             primitives::aggr_init_plus_int64_t_col,
+                             primitives::aggr_sel_atomic_plus_int64_t_col,
+                             Buffer(sum, sizeof(int64_t)),
+                             primitives::gather_col_int64_t_col);
+      r->v = reinterpret_cast<int32_t*>(Buffer(buildValue).data);
+      r->sum = reinterpret_cast<int64_t*>(Buffer(sum).data);
+      r->rootOp = popOperator();
+      return r;
+   }
+};
+
+TEST(Join, groupJoin) {
+   runtime::Database db;
+   db["build"].insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 3, 4, 8, 9};
+   db["build"].insert("v", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{101, 103, 104, 108, 109};
+   db["probe"].insert("b", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{88, 1, 3, 17, 4, 1, 3, 5, 1, 9};
+   db["probe"].insert("q", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+   db["build"].nrTuples = 5;
+   db["probe"].nrTuples = 10;
+   // small vectors, so that groups are emitted in several batches
+   GroupJoinBuilder b(db, 3);
+   auto query = b.getQuery();
+   std::map<int32_t, int64_t> found;
+   while (auto n = query->rootOp->next()) {
+      ASSERT_LE(n, size_t(3));
+      for (size_t i = 0; i < n; ++i) {
+         ASSERT_EQ(0u, found.count(query->v[i]));
+         found[query->v[i]] = query->sum[i];
+      }
+   }
+   // build tuple 8 has no join partner and produces no group
+   std::map<int32_t, int64_t> expected{
+       {101, 2 + 6 + 9}, {103, 3 + 7}, {104, 5}, {109, 10}};
+   ASSERT_EQ(expected, found);
+}
+
+struct ConcurrentBuildsBuilder : public Query,
+                                 private vectorwise::QueryBuilder {
+   enum { matchesA, matchesB };
+   runtime::GlobalPool pool;
+   ConcurrentBuildsBuilder(runtime::Database& db)
+       : Query(), QueryBuilder(db, shared) {
+      previous = runtime::this_worker->allocator.setSource(&pool);
+   }
+   /// probe joined with a and then with b. If nested, the join with b is
+   /// built from the result of the join with a instead
+   std::unique_ptr<vectorwise::Operator> getQuery(bool nested) {
+      auto b = Scan("b");
+      auto a = Scan("a");
+      auto probe = Scan("probe");
+      HashJoin(Buffer(matchesA, sizeof(pos_t)))
+          .addBuildKey(Column(a, "k"), conf.hash_int32_t_col(),
+                       primitives::scatter_int32_t_col)
+          .addProbeKey(Column(probe, "x"), conf.hash_int32_t_col(),
+                       primitives::keys_equal_int32_t_col);
+      if (nested) {
+         // the join with a becomes the build side
+         auto joinA = popOperator();
+         auto scanB = popOperator();
+         pushOperator(move(joinA));
+         pushOperator(move(scanB));
+         HashJoin(Buffer(matchesB, sizeof(pos_t)))
+             .addBuildKey(Column(probe, "y"), Buffer(matchesA),
+                          conf.hash_sel_int32_t_col(),
+                          primitives::scatter_sel_int32_t_col)
+             .addProbeKey(Column(b, "k"), conf.hash_int32_t_col(),
+                          primitives::keys_equal_int32_t_col);
+      } else
+         HashJoin(Buffer(matchesB, sizeof(pos_t)))
+             .addBuildKey(Column(b, "k"), conf.hash_int32_t_col(),
+                          primitives::scatter_int32_t_col)
+             .setProbeSelVector(Buffer(matchesA), conf.joinSel())
+             .addProbeKey(Column(probe, "y"), Buffer(matchesA),
+                          conf.hash_sel_int32_t_col(),
+                          primitives::keys_equal_int32_t_col);
+      BuildConcurrently({Buffer(matchesB), Buffer(matchesA)});
+      return popOperator();
+   }
+};
+
+static void concurrentBuildsData(runtime::Database& db) {
+   db["a"].insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 2, 3};
+   db["b"].insert("k", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{10, 20};
+   db["probe"].insert("x", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{1, 2, 4, 3, 1};
+   db["probe"].insert("y", make_unique<algebra::Integer>()) =
+       std::vector<int32_t>{10, 30, 20, 20, 20};
+   db["a"].nrTuples = 3;
+   db["b"].nrTuples = 2;
+   db["probe"].nrTuples = 5;
+}
+
+TEST(Join, concurrentBuilds) {
+   runtime::Database db;
+   concurrentBuildsData(db);
+   ConcurrentBuildsBuilder b(db);
+   auto root = b.getQuery(false);
+   auto join = dynamic_cast<Hashjoin*>(root.get());
+   ASSERT_NE(nullptr, join);
+   ASSERT_EQ(size_t(2), join->concurrentBuilds.size());
+   std::vector<pos_t> found;
+   while (auto n = root->next())
+      found.insert(found.end(), join->probeMatches, join->probeMatches + n);
+   // probes with x in a and y in b
+   std::sort(found.begin(), found.end());
+   ASSERT_EQ(std::vector<pos_t>({0, 3, 4}), found);
+}
+
+TEST(Join, concurrentBuildsMustBeIndependent) {
+   runtime::Database db;
+   concurrentBuildsData(db);
+   ConcurrentBuildsBuilder b(db);
+   ASSERT_THROW(b.getQuery(true), std::runtime_error);
+}
+
 class HashGroupT : public ::testing::Test, public Query, public QueryBuilder {
 
  protected:
@@ -467,6 +893,286 @@ TEST_F(HashGroupT, simpleGroup) {
    ASSERT_EQ(found, size_t(5));
 }
 
+TEST_F(HashGroupT, groupWithoutLocality) {
+
+   enum { grouped_k, aggregated_v };
+   // unique keys disable pre-aggregation, repeated keys enable it again
+   std::vector<int64_t> keys;
+   for (int64_t i = 0; i < 8000; ++i) keys.push_back(i);
+   for (int64_t i = 0; i < 8000; ++i) keys.push_back(i % 10);
+   for (int64_t i = 0; i < 4000; ++i) keys.push_back(100000 + i);
+   auto& rel = db["t"];
+   rel.insert("k", make_unique<algebra::BigInt>()) = std::vector<int64_t>(keys);
+   rel.insert("v", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>(keys.size(), 1);
+   rel.nrTuples = keys.size();
+
+   auto t = Scan("t");
+   HashGroup()
+       .addKey(Column(t, "k"), primitives::hash_int64_t_col,
+               primitives::keys_not_equal_int64_t_col,
+               primitives::partition_by_key_int64_t_col,
+               primitives::scatter_sel_int64_t_col,
+               primitives::keys_not_equal_row_int64_t_col,
+               primitives::partition_by_key_row_int64_t_col,
+               primitives::scatter_sel_row_int64_t_col,
+               primitives::gather_val_int64_t_col,
+               Buffer(grouped_k, sizeof(int64_t)))
+       .addValue(Column(t, "v"), primitives::aggr_init_plus_int64_t_col,
+                 primitives::aggr_plus_int64_t_col,
+                 primitives::aggr_row_plus_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(aggregated_v, sizeof(int64_t)));
+   std::map<int64_t, int64_t> expectedGroups;
+   for (auto k : keys) expectedGroups[k]++;
+
+   auto root = popOperator();
+   auto group = dynamic_cast<vectorwise::HashGroup*>(root.get());
+   ASSERT_NE(nullptr, group);
+   size_t found = 0;
+   size_t smallVectors = 0;
+   while (auto n = root->next()) {
+      found += n;
+      // result vectors are filled across blocks and partitions
+      if (n * 2 < 1024) smallVectors++;
+      auto k = (int64_t*)Buffer(grouped_k).data;
+      auto aggrs = (int64_t*)Buffer(aggregated_v).data;
+      for (size_t i = 0; i < n; ++i) {
+         auto ex = expectedGroups.find(k[i]);
+         ASSERT_NE(ex, expectedGroups.end());
+         ASSERT_EQ(ex->second, aggrs[i]);
+         expectedGroups.erase(ex);
+      }
+   }
+   ASSERT_EQ(size_t(12000), found);
+   ASSERT_LE(smallVectors, size_t(1));
+   // the unique keys switched pre-aggregation off
+   ASSERT_GT(group->adaptivity.bypassed(), size_t(0));
+}
+
+TEST_F(HashGroupT, groupWithLocality) {
+
+   enum { grouped_k, aggregated_v };
+   // few distinct keys, pre-aggregation reduces the input
+   std::vector<int64_t> keys;
+   for (int64_t i = 0; i < 20000; ++i) keys.push_back(i % 1000);
+   auto& rel = db["t"];
+   rel.insert("k", make_unique<algebra::BigInt>()) = std::vector<int64_t>(keys);
+   rel.insert("v", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>(keys.size(), 1);
+   rel.nrTuples = keys.size();
+
+   auto t = Scan("t");
+   HashGroup()
+       .addKey(Column(t, "k"), primitives::hash_int64_t_col,
+               primitives::keys_not_equal_int64_t_col,
+               primitives::partition_by_key_int64_t_col,
+               primitives::scatter_sel_int64_t_col,
+               primitives::keys_not_equal_row_int64_t_col,
+               primitives::partition_by_key_row_int64_t_col,
+               primitives::scatter_sel_row_int64_t_col,
+               primitives::gather_val_int64_t_col,
+               Buffer(grouped_k, sizeof(int64_t)))
+       .addValue(Column(t, "v"), primitives::aggr_init_plus_int64_t_col,
+                 primitives::aggr_plus_int64_t_col,
+                 primitives::aggr_row_plus_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(aggregated_v, sizeof(int64_t)));
+
+   auto root = popOperator();
+   auto group = dynamic_cast<vectorwise::HashGroup*>(root.get());
+   ASSERT_NE(nullptr, group);
+   size_t found = 0;
+   while (auto n = root->next()) {
+      found += n;
+      auto aggrs = (int64_t*)Buffer(aggregated_v).data;
+      for (size_t i = 0; i < n; ++i) ASSERT_EQ(int64_t(20), aggrs[i]);
+   }
+   ASSERT_EQ(size_t(1000), found);
+   ASSERT_EQ(size_t(0), group->adaptivity.bypassed());
+}
+
+TEST_F(HashGroupT, wideSum) {
+
+   enum { grouped_k, aggregated_v };
+   // sums of group 0 and 1 exceed 64 bits, unique keys fill the tables
+   const int64_t big = std::numeric_limits<int64_t>::max() / 8;
+   std::vector<int64_t> keys, values;
+   for (int64_t i = 0; i < 3000; ++i) {
+      keys.push_back(i % 3);
+      values.push_back(i % 3 == 0 ? big : i % 3 == 1 ? -big : i);
+   }
+   for (int64_t i = 0; i < 5000; ++i) {
+      keys.push_back(100 + i);
+      values.push_back(i);
+   }
+   auto& rel = db["t"];
+   rel.insert("k", make_unique<algebra::BigInt>()) = std::vector<int64_t>(keys);
+   rel.insert("v", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>(values);
+   rel.nrTuples = keys.size();
+
+   auto t = Scan("t");
+   HashGroup()
+       .addKey(Column(t, "k"), primitives::hash_int64_t_col,
+               primitives::keys_not_equal_int64_t_col,
+               primitives::partition_by_key_int64_t_col,
+               primitives::scatter_sel_int64_t_col,
+               primitives::keys_not_equal_row_int64_t_col,
+               primitives::partition_by_key_row_int64_t_col,
+               primitives::scatter_sel_row_int64_t_col,
+               primitives::gather_val_int64_t_col,
+               Buffer(grouped_k, sizeof(int64_t)))
+       .addWideSum(Column(t, "v"),
+                   Buffer(aggregated_v, sizeof(types::Sum128)));
+   std::map<int64_t, __int128> expectedGroups;
+   for (size_t i = 0; i < keys.size(); ++i)
+      expectedGroups[keys[i]] += values[i];
+
+   auto root = popOperator();
+   size_t found = 0;
+   while (auto n = root->next()) {
+      found += n;
+      auto k = (int64_t*)Buffer(grouped_k).data;
+      auto aggrs = (types::Sum128*)Buffer(aggregated_v).data;
+      for (size_t i = 0; i < n; ++i) {
+         auto ex = expectedGroups.find(k[i]);
+         ASSERT_NE(ex, expectedGroups.end());
+         ASSERT_TRUE(ex->second == aggrs[i].getRaw());
+         expectedGroups.erase(ex);
+      }
+   }
+   ASSERT_EQ(size_t(5003), found);
+}
+
+TEST_F(HashGroupT, eagerAggregation) {
+
+   enum {
+      partial_k,
+      partial_sum,
+      partial_count,
+      partial_min,
+      partial_max,
+      probe_matches,
+      dim_g,
+      grouped_g,
+      sum,
+      count,
+      min,
+      max
+   };
+   // fact keys repeat after many groups, so the partial aggregation passes on
+   // the same key several times
+   std::vector<int64_t> keys, values;
+   for (int64_t i = 0; i < 9000; ++i) {
+      keys.push_back(i % 3000);
+      values.push_back(i);
+   }
+   auto& fact = db["fact"];
+   fact.insert("k", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>(keys);
+   fact.insert("v", make_unique<algebra::BigInt>()) =
+       std::vector<int64_t>(values);
+   fact.nrTuples = keys.size();
+   std::vector<int64_t> dimKeys;
+   std::vector<int32_t> dimGroups;
+   for (int64_t i = 0; i < 2000; ++i) {
+      dimKeys.push_back(i);
+      dimGroups.push_back(i % 7);
+   }
+   auto& dim = db["dim"];
+   dim.insert("k", make_unique<algebra::BigInt>()) = std::move(dimKeys);
+   dim.insert("g", make_unique<algebra::Integer>()) = std::move(dimGroups);
+   dim.nrTuples = 2000;
+
+   auto d = Scan("dim");
+   auto f = Scan("fact");
+   PartialHashGroup()
+       .addKey(Column(f, "k"), primitives::hash_int64_t_col,
+               primitives::keys_not_equal_int64_t_col,
+               primitives::partition_by_key_int64_t_col,
+               primitives::scatter_sel_int64_t_col,
+               primitives::keys_not_equal_row_int64_t_col,
+               primitives::partition_by_key_row_int64_t_col,
+               primitives::scatter_sel_row_int64_t_col,
+               primitives::gather_val_int64_t_col,
+               Buffer(partial_k, sizeof(int64_t)))
+       .addValue(Column(f, "v"), primitives::aggr_init_plus_int64_t_col,
+                 primitives::aggr_plus_int64_t_col,
+                 primitives::aggr_row_plus_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(partial_sum, sizeof(int64_t)))
+       .addValue(Column(f, "v"), primitives::aggr_init_plus_int64_t_col,
+                 primitives::aggr_count_star,
+                 primitives::aggr_row_plus_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(partial_count, sizeof(int64_t)))
+       .addValue(Column(f, "v"), primitives::aggr_init_minimum_int64_t_col,
+                 primitives::aggr_minimum_int64_t_col,
+                 primitives::aggr_row_minimum_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(partial_min, sizeof(int64_t)))
+       .addValue(Column(f, "v"), primitives::aggr_init_maximum_int64_t_col,
+                 primitives::aggr_maximum_int64_t_col,
+                 primitives::aggr_row_maximum_int64_t_col,
+                 primitives::gather_val_int64_t_col,
+                 Buffer(partial_max, sizeof(int64_t)));
+   HashJoin(Buffer(probe_matches, sizeof(pos_t)))
+       .addBuildKey(Column(d, "k"), primitives::hash_int64_t_col,
+                    primitives::scatter_int64_t_col)
+       .addProbeKey(Buffer(partial_k), primitives::hash_int64_t_col,
+                    primitives::keys_equal_int64_t_col)
+       .addBuildValue(Column(d, "g"), primitives::scatter_int32_t_col,
+                      Buffer(dim_g, sizeof(int32_t)),
+                      primitives::gather_col_int32_t_col);
+   HashGroup()
+       .addKey(Buffer(dim_g), primitives::hash_int32_t_col,
+               primitives::keys_not_equal_int32_t_col,
+               primitives::partition_by_key_int32_t_col,
+               primitives::scatter_sel_int32_t_col,
+               primitives::keys_not_equal_row_int32_t_col,
+               primitives::partition_by_key_row_int32_t_col,
+               primitives::scatter_sel_row_int32_t_col,
+               primitives::gather_val_int32_t_col,
+               Buffer(grouped_g, sizeof(int32_t)))
+       .mergeValue(Buffer(partial_sum), Buffer(probe_matches),
+                   Buffer(sum, sizeof(int64_t)))
+       .mergeValue(Buffer(partial_count), Buffer(probe_matches),
+                   Buffer(count, sizeof(int64_t)))
+       .mergeValue(Buffer(partial_min), Buffer(probe_matches),
+                   Buffer(min, sizeof(int64_t)))
+       .mergeValue(Buffer(partial_max), Buffer(probe_matches),
+                   Buffer(max, sizeof(int64_t)));
+   // sum, count, min and max per group of the dimension
+   std::map<int32_t, std::tuple<int64_t, int64_t, int64_t, int64_t>> expected;
+   for (size_t i = 0; i < keys.size(); ++i) {
+      if (keys[i] >= 2000) continue;
+      auto e = expected.emplace(keys[i] % 7,
+                                make_tuple(0, 0, values[i], values[i]));
+      auto& aggrs = e.first->second;
+      get<0>(aggrs) += values[i];
+      get<1>(aggrs) += 1;
+      get<2>(aggrs) = std::min(get<2>(aggrs), values[i]);
+      get<3>(aggrs) = std::max(get<3>(aggrs), values[i]);
+   }
+
+   auto root = popOperator();
+   size_t found = 0;
+   while (auto n = root->next()) {
+      found += n;
+      auto g = (int32_t*)Buffer(grouped_g).data;
+      for (size_t i = 0; i < n; ++i) {
+         auto ex = expected.find(g[i]);
+         ASSERT_NE(ex, expected.end());
+         ASSERT_EQ(get<0>(ex->second), ((int64_t*)Buffer(sum).data)[i]);
+         ASSERT_EQ(get<1>(ex->second), ((int64_t*)Buffer(count).data)[i]);
+         ASSERT_EQ(get<2>(ex->second), ((int64_t*)Buffer(min).data)[i]);
+         ASSERT_EQ(get<3>(ex->second), ((int64_t*)Buffer(max).data)[i]);
+      }
+   }
+   ASSERT_EQ(size_t(7), found);
+}
+
 class HashGroupSmallBuf : public ::testing::Test,
                           public Query,
                           public QueryBuilder {
@@ -1,8 +1,10 @@
 #include "vectorwise/Primitives.hpp"
 #include "common/runtime/Hash.hpp"
 #include "common/runtime/Hashmap.hpp"
+#include "common/runtime/StringSearch.hpp"
 #include "common/runtime/Types.hpp"
 #include <gtest/gtest.h>
+#include <limits>
 
 using types::Date;
 using namespace std;
@@ -27,6 +29,218 @@ TEST(GTEQ, Date) {
    for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
 }
 
+TEST(Between, int64_t) {
+   vector<int64_t> col = {5, 1, 7, 3, 9, 4, 6};
+   int64_t lower = 4, upper = 7;
+   vector<pos_t> result(col.size());
+   auto n = primitives::sel_between_int64_t_col_int64_t_val_int64_t_val(
+       col.size(), result.data(), col.data(), &lower, &upper);
+   vector<pos_t> expected = {0, 2, 5, 6};
+   ASSERT_EQ(pos_t(expected.size()), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+
+   // upper bound excluded, with input selection vector
+   vector<pos_t> sel = {1, 2, 4, 5, 6};
+   n = primitives::selsel_between_halfopen_int64_t_col_int64_t_val_int64_t_val_bf(
+       sel.size(), sel.data(), result.data(), col.data(), &lower, &upper);
+   expected = {5, 6};
+   ASSERT_EQ(pos_t(expected.size()), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+}
+
+TEST(In, smallList) {
+   vector<int32_t> col;
+   for (int32_t i = 0; i < 200; ++i) col.push_back(i % 10);
+   InList<int32_t> list({3, 7});
+   ASSERT_TRUE(list.isSmall());
+   vector<pos_t> result(col.size());
+   auto n = primitives::sel_in_int32_t_col_int32_t_list(
+       col.size(), result.data(), col.data(), &list);
+   ASSERT_EQ(pos_t(40), n);
+   for (pos_t i = 0; i < n; ++i) {
+      auto v = col[result[i]];
+      ASSERT_TRUE(v == 3 || v == 7);
+   }
+   auto nBf = primitives::sel_in_int32_t_col_int32_t_list_bf(
+       col.size(), result.data(), col.data(), &list);
+   ASSERT_EQ(n, nBf);
+}
+
+TEST(In, largeList) {
+   vector<int64_t> col;
+   for (int64_t i = 0; i < 1000; ++i) col.push_back(i * 1000003);
+   vector<int64_t> values;
+   for (int64_t i = 0; i < 1000; i += 50) values.push_back(i * 1000003);
+   values.push_back(-1);
+   InList<int64_t> hashed(values);
+   ASSERT_FALSE(hashed.isSmall());
+   vector<pos_t> sel;
+   for (pos_t i = 0; i < col.size(); i += 2) sel.push_back(i);
+   vector<pos_t> result(col.size());
+   auto n = primitives::selsel_in_int64_t_col_int64_t_list(
+       sel.size(), sel.data(), result.data(), col.data(), &hashed);
+   ASSERT_EQ(pos_t(20), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(result[i] % 50, pos_t(0));
+
+   // dense domain, answered with a bitmap
+   vector<int64_t> dense;
+   for (int64_t i = 0; i < 1000; i += 2) dense.push_back(i * 1000003);
+   for (auto& v : col) v /= 1000003;
+   for (auto& v : dense) v /= 1000003;
+   InList<int64_t> bitmap(dense);
+   n = primitives::sel_in_int64_t_col_int64_t_list_bf(
+       col.size(), result.data(), col.data(), &bitmap);
+   ASSERT_EQ(pos_t(500), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(result[i], 2 * i);
+}
+
+TEST(In, fullRange) {
+   // the domain of the list spans all int64 values, no bitmap fits
+   vector<int64_t> values = {numeric_limits<int64_t>::min(),
+                             numeric_limits<int64_t>::max()};
+   for (int64_t i = 0; i < 10; ++i) values.push_back(i * 3);
+   InList<int64_t> list(values);
+   ASSERT_FALSE(list.isSmall());
+   for (auto v : values) ASSERT_TRUE(list.contains(v));
+   ASSERT_FALSE(list.contains(1));
+   ASSERT_FALSE(list.contains(numeric_limits<int64_t>::min() + 1));
+   vector<int64_t> col = {numeric_limits<int64_t>::max(), 1, 27, -1,
+                          numeric_limits<int64_t>::min()};
+   vector<pos_t> result(col.size());
+   auto n = primitives::sel_in_int64_t_col_int64_t_list(
+       col.size(), result.data(), col.data(), &list);
+   vector<pos_t> expected = {0, 2, 4};
+   ASSERT_EQ(pos_t(expected.size()), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+}
+
+#ifdef __AVX512F__
+TEST(In, avx512) {
+   vector<int32_t> col32;
+   vector<int64_t> col64;
+   for (int32_t i = 0; i < 1001; ++i) {
+      col32.push_back(i % 13 - 6);
+      col64.push_back(int64_t(i % 13 - 6) << 33);
+   }
+   vector<pos_t> sel;
+   for (pos_t i = 0; i < col32.size(); i += 3) sel.push_back(i);
+   vector<pos_t> expected(col32.size()), result(col32.size());
+   // small lists in registers, larger ones fall back to the lookup
+   for (size_t size : {1, 3, 8, 9}) {
+      vector<int32_t> v32;
+      vector<int64_t> v64;
+      for (size_t i = 0; i < size; ++i) {
+         v32.push_back(int32_t(i) * 2 - 5);
+         v64.push_back(int64_t(int32_t(i) * 2 - 5) << 33);
+      }
+      InList<int32_t> l32(v32);
+      InList<int64_t> l64(v64);
+      auto compare = [&](pos_t n, pos_t m) {
+         ASSERT_EQ(n, m);
+         for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+      };
+      compare(primitives::sel_in_int32_t_col_int32_t_list(
+                  col32.size(), expected.data(), col32.data(), &l32),
+              primitives::sel_in_int32_t_col_int32_t_list_avx512(
+                  col32.size(), result.data(), col32.data(), &l32));
+      compare(primitives::selsel_in_int32_t_col_int32_t_list(
+                  sel.size(), sel.data(), expected.data(), col32.data(), &l32),
+              primitives::selsel_in_int32_t_col_int32_t_list_avx512(
+                  sel.size(), sel.data(), result.data(), col32.data(), &l32));
+      compare(primitives::sel_in_int64_t_col_int64_t_list(
+                  col64.size(), expected.data(), col64.data(), &l64),
+              primitives::sel_in_int64_t_col_int64_t_list_avx512(
+                  col64.size(), result.data(), col64.data(), &l64));
+      compare(primitives::selsel_in_int64_t_col_int64_t_list(
+                  sel.size(), sel.data(), expected.data(), col64.data(), &l64),
+              primitives::selsel_in_int64_t_col_int64_t_list_avx512(
+                  sel.size(), sel.data(), result.data(), col64.data(), &l64));
+   }
+}
+#endif
+
+TEST(In, Char) {
+   using primitives::Char_10;
+   vector<Char_10> col;
+   for (auto s : {"UNITED KI1", "UNITED KI5", "CHINA", "UNITED KI1"})
+      col.push_back(Char_10::castString(s, strlen(s)));
+   InList<Char_10> list({Char_10::castString("UNITED KI1", 10),
+                         Char_10::castString("UNITED KI5", 10)});
+   vector<pos_t> result(col.size());
+   auto n = primitives::sel_in_Char_10_col_Char_10_list(
+       col.size(), result.data(), col.data(), &list);
+   vector<pos_t> expected = {0, 1, 3};
+   ASSERT_EQ(pos_t(expected.size()), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+}
+
+TEST(In, largeChar) {
+   // strings have no dense domain, larger lists are probed in the hash set
+   using primitives::Char_10;
+   auto name = [](int i) {
+      auto s = "BRAND#" + to_string(i);
+      return Char_10::castString(s.data(), s.size());
+   };
+   vector<Char_10> col, values;
+   for (int i = 0; i < 300; ++i) col.push_back(name(i % 100));
+   for (int i = 0; i < 100; i += 4) values.push_back(name(i));
+   values.push_back(name(1000));
+   InList<Char_10> list(values);
+   ASSERT_FALSE(list.isSmall());
+   vector<pos_t> result(col.size());
+   auto n = primitives::sel_in_Char_10_col_Char_10_list(
+       col.size(), result.data(), col.data(), &list);
+   ASSERT_EQ(pos_t(75), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(result[i], 4 * i);
+
+   vector<pos_t> sel;
+   for (pos_t i = 0; i < col.size(); i += 2) sel.push_back(i);
+   auto m = primitives::selsel_in_Char_10_col_Char_10_list_bf(
+       sel.size(), sel.data(), result.data(), col.data(), &list);
+   ASSERT_EQ(pos_t(75), m);
+   for (pos_t i = 0; i < m; ++i) ASSERT_EQ(result[i] % 4, pos_t(0));
+}
+
+TEST(Like, Varchar) {
+   using primitives::Varchar_55;
+   vector<Varchar_55> col;
+   for (auto s : {"forest green antique", "green", "lavender", "dark greenery",
+                  "blanched almond goldenrod gainsboro navy powder green"})
+      col.push_back(Varchar_55::castString(s, strlen(s)));
+   runtime::StringPattern green("green");
+   vector<pos_t> result(col.size());
+
+   auto n = primitives::sel_like_contains_Varchar_55_col_pattern(
+       col.size(), result.data(), col.data(), &green);
+   vector<pos_t> expected = {0, 1, 3, 4};
+   ASSERT_EQ(pos_t(expected.size()), n);
+   for (pos_t i = 0; i < n; ++i) ASSERT_EQ(expected[i], result[i]);
+
+   n = primitives::sel_like_prefix_Varchar_55_col_pattern_bf(
+       col.size(), result.data(), col.data(), &green);
+   ASSERT_EQ(pos_t(1), n);
+   ASSERT_EQ(pos_t(1), result[0]);
+
+   vector<pos_t> sel = {0, 2, 4};
+   n = primitives::selsel_like_suffix_Varchar_55_col_pattern(
+       sel.size(), sel.data(), result.data(), col.data(), &green);
+   ASSERT_EQ(pos_t(1), n);
+   ASSERT_EQ(pos_t(4), result[0]);
+}
+
+TEST(Like, findIn) {
+   // exercise the vectorized part and the tail of the search
+   string text(100, 'a');
+   text.replace(70, 4, "abcd");
+   runtime::StringPattern p("abcd");
+   ASSERT_EQ(text.data() + 70, p.findIn(text.data(), text.size()));
+   ASSERT_EQ(nullptr, p.findIn(text.data(), 73));
+   runtime::StringPattern q("aab");
+   ASSERT_EQ(text.data() + 69, q.findIn(text.data(), text.size()));
+   runtime::StringPattern r("c");
+   ASSERT_EQ(text.data() + 72, r.findIn(text.data(), text.size()));
+}
+
 struct TestData {
    uint64_t a;
    uint8_t b;
@@ -145,3 +359,156 @@ TEST(Hash, SIMD32bits){
 
 }
 #endif
+
+#ifdef __AVX512F__
+TEST(Aggregation, StaticAVX512) {
+   // checks if scalar and simd variants compute the same aggregates
+   using namespace vectorwise::primitives;
+   const pos_t n = 1000 + 7;
+   vector<int64_t> values64(n);
+   vector<int32_t> values32(n);
+   vector<pos_t> sel;
+   for (pos_t i = 0; i < n; ++i) {
+      values64[i] = int64_t(i * 7919 % 1013) - 500;
+      values32[i] = int32_t(i * 104729 % 2039) - 1000;
+      if (i % 3) sel.push_back(i);
+   }
+   auto check = [&](auto scalar, auto simd, auto scalarSel, auto simdSel,
+                    auto& values, auto init) {
+      for (pos_t m : {pos_t(0), pos_t(5), pos_t(64), n}) {
+         auto expected = init, actual = init;
+         scalar(m, &expected, values.data());
+         simd(m, &actual, values.data());
+         ASSERT_EQ(expected, actual);
+         pos_t s = std::min<pos_t>(m, sel.size());
+         scalarSel(s, sel.data(), &expected, values.data());
+         simdSel(s, sel.data(), &actual, values.data());
+         ASSERT_EQ(expected, actual);
+      }
+   };
+   check(aggr_static_plus_int64_t_col, aggr_static_plus_int64_t_col_avx512,
+         aggr_static_sel_plus_int64_t_col,
+         aggr_static_sel_plus_int64_t_col_avx512, values64, int64_t(3));
+   check(aggr_static_minimum_int64_t_col,
+         aggr_static_minimum_int64_t_col_avx512,
+         aggr_static_sel_minimum_int64_t_col,
+         aggr_static_sel_minimum_int64_t_col_avx512, values64, int64_t(10));
+   check(aggr_static_maximum_int64_t_col,
+         aggr_static_maximum_int64_t_col_avx512,
+         aggr_static_sel_maximum_int64_t_col,
+         aggr_static_sel_maximum_int64_t_col_avx512, values64, int64_t(-10));
+   check(aggr_static_plus_int32_t_col, aggr_static_plus_int32_t_col_avx512,
+         aggr_static_sel_plus_int32_t_col,
+         aggr_static_sel_plus_int32_t_col_avx512, values32, int32_t(3));
+   check(aggr_static_minimum_int32_t_col,
+         aggr_static_minimum_int32_t_col_avx512,
+         aggr_static_sel_minimum_int32_t_col,
+         aggr_static_sel_minimum_int32_t_col_avx512, values32, int32_t(10));
+   check(aggr_static_maximum_int32_t_col,
+         aggr_static_maximum_int32_t_col_avx512,
+         aggr_static_sel_maximum_int32_t_col,
+         aggr_static_sel_maximum_int32_t_col_avx512, values32, int32_t(-10));
+}
+
+TEST(Aggregation, FewGroupsAVX512) {
+   // aggregates of few groups kept in registers must match the aggregates
+   // updated per tuple, also when the vector has too many groups
+   using namespace vectorwise::primitives;
+   const pos_t n = 1000 + 3;
+   struct Group {
+      int64_t sum, min, max, count;
+   };
+   vector<int64_t> values(n);
+   vector<pos_t> sel(n);
+   for (pos_t i = 0; i < n; ++i) {
+      values[i] = int64_t(i * 7919 % 1013) - 500;
+      sel[i] = n - 1 - i;
+   }
+   for (size_t nrGroups : {size_t(1), size_t(3), fewGroups, fewGroups + 1}) {
+      vector<Group> expected(nrGroups, Group{0, 1000, -1000, 0});
+      vector<Group> actual = expected;
+      vector<void*> entriesExpected(n), entriesActual(n);
+      for (pos_t i = 0; i < n; ++i) {
+         entriesExpected[i] = &expected[i * i % nrGroups];
+         entriesActual[i] = &actual[i * i % nrGroups];
+      }
+      auto ee = entriesExpected.data(), ea = entriesActual.data();
+      aggr_plus_int64_t_col(n, ee, values.data(), offsetof(Group, sum));
+      aggr_few_plus_int64_t_col_avx512(n, ea, values.data(),
+                                       offsetof(Group, sum));
+      aggr_sel_minimum_int64_t_col(n, ee, sel.data(), values.data(),
+                                   offsetof(Group, min));
+      aggr_few_sel_minimum_int64_t_col_avx512(n, ea, sel.data(), values.data(),
+                                              offsetof(Group, min));
+      aggr_maximum_int64_t_col(n - 5, ee, values.data(), offsetof(Group, max));
+      aggr_few_maximum_int64_t_col_avx512(n - 5, ea, values.data(),
+                                          offsetof(Group, max));
+      aggr_count_star(n, ee, nullptr, offsetof(Group, count));
+      aggr_few_count_star_avx512(n, ea, nullptr, offsetof(Group, count));
+      for (size_t g = 0; g < nrGroups; ++g) {
+         ASSERT_EQ(expected[g].sum, actual[g].sum);
+         ASSERT_EQ(expected[g].min, actual[g].min);
+         ASSERT_EQ(expected[g].max, actual[g].max);
+         ASSERT_EQ(expected[g].count, actual[g].count);
+      }
+   }
+}
+#endif
+
+TEST(Aggregation, WideSum) {
+   // 128 bit sums must not overflow, neither in the 64 bit fast path nor
+   // in the group aggregates
+   using namespace vectorwise::primitives;
+   const int64_t big = std::numeric_limits<int64_t>::max() / 4;
+   const pos_t n = 37;
+   vector<int64_t> small(n), large(n);
+   vector<pos_t> sel;
+   __int128 smallSum = 0, largeSum = 0;
+   for (pos_t i = 0; i < n; ++i) {
+      small[i] = int64_t(i) * 1000 - 9000;
+      large[i] = big - i;
+      smallSum += small[i];
+      largeSum += large[i];
+      if (i % 2) sel.push_back(i);
+   }
+   vector<F2> statics = {aggr_static_wide_plus_int64_t_col};
+#ifdef __AVX512F__
+   statics.push_back(aggr_static_wide_plus_int64_t_col_avx512);
+#endif
+   for (auto aggr : statics) {
+      types::Sum128 sum;
+      aggr(n, &sum, small.data());
+      ASSERT_TRUE(sum.getRaw() == smallSum);
+      aggr(n, &sum, large.data());
+      ASSERT_TRUE(sum.getRaw() == smallSum + largeSum);
+   }
+
+   // group aggregation into two groups, merged into a third one
+   struct Group {
+      void* next;
+      types::Sum128 sum;
+   };
+   vector<Group> groups(3);
+   Group* toInit = groups.data();
+   size_t groupSize = sizeof(Group);
+   aggr_init_wide_plus_col(3, (void**)&toInit, &groupSize,
+                           offsetof(Group, sum));
+   vector<void*> entries(n);
+   __int128 expected[2] = {0, 0};
+   for (pos_t i = 0; i < n; ++i) {
+      entries[i] = &groups[i % 2];
+      expected[i % 2] += large[i];
+   }
+   aggr_wide_plus_int64_t_col(n, entries.data(), large.data(),
+                              offsetof(Group, sum));
+   aggr_wide_sel_plus_int64_t_col(sel.size(), entries.data(), sel.data(),
+                                  large.data(), offsetof(Group, sum));
+   for (size_t i = 0; i < sel.size(); ++i) expected[i % 2] += large[sel[i]];
+   ASSERT_TRUE(groups[0].sum.getRaw() == expected[0]);
+   ASSERT_TRUE(groups[1].sum.getRaw() == expected[1]);
+   vector<void*> merged = {&groups[2], &groups[2]};
+   Group* rows = groups.data();
+   aggr_row_wide_plus_col(2, merged.data(), offsetof(Group, sum),
+                          (void**)&rows, &groupSize, offsetof(Group, sum));
+   ASSERT_TRUE(groups[2].sum.getRaw() == expected[0] + expected[1]);
+}
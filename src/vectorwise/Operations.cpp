@@ -89,4 +89,8 @@ pos_t F3_Op::run(pos_t n) {
 pos_t F4_Op::run(pos_t n) {
    return operation(n, inputSelectionV, outputSelectionV, param1, param2);
 }
+pos_t F5_Op::run(pos_t n) {
+   return operation(n, inputSelectionV, outputSelectionV, param1, param2,
+                    param3);
+}
 }
@@ -3,6 +3,7 @@
 #include "common/runtime/Concurrency.hpp"
 #include "common/runtime/SIMD.hpp"
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include <tuple>
@@ -56,10 +57,19 @@ void Scan::addConsumer(void** colPtr, size_t typeSize) {
 
 size_t Scan::next() {
    auto step = 1;
+   if (auto query = runtime::this_worker->query)
+      query->cancellation->checkpoint();
 
    if (vecInChunk == scanChunkSize) {
       auto prevChunk = currentChunk;
       currentChunk = shared.pos.fetch_add(1);
+      if (runtime::ReadAhead::enabled) {
+         std::call_once(shared.readAheadOnce, [&]() {
+            shared.readAhead = runtime::ReadAhead::create(columns, nrTuples);
+         });
+         runtime::ReadAhead::advance(shared.readAhead.get(),
+                                     currentChunk * scanChunkSize * vecSize);
+      }
       auto chunkSkip = currentChunk - prevChunk;
       if (needsInit) {
          step = chunkSkip * scanChunkSize;
@@ -105,6 +115,8 @@ size_t ResultWriter::next() {
       // update result relation size
       currentBlock.addedElements(n);
    }
+   // the last writer publishes the blocks of all workers
+   barrier([&]() { shared.result->result->finalize(); });
    return found;
 }
 
@@ -750,53 +762,253 @@ pos_t Hashjoin::joinBoncz() {
    return 0;
 }
 
-size_t Hashjoin::next() {
-   using runtime::Hashmap;
-   // --- build
-   if (!consumed) {
+void Hashjoin::findFirstMatches() {
+   const auto end = shared.ht.end();
+   for (size_t i = 0; i < cont.numProbes; ++i) probeMatched[probePos(i)] = 0;
+   // first round: start of the hash chains
+   size_t candidates = 0;
+   for (size_t i = 0; i < cont.numProbes; ++i) {
+      auto entry = shared.ht.find_chain_tagged(probeHashes[i]);
+      if (entry != end) {
+         followupIds[candidates] = i;
+         followupEntries[candidates++] = entry;
+      }
+   }
+   while (candidates) {
+      // check keys of all candidates with matching hash at once
       size_t found = 0;
-      // --- build phase 1: materialize ht entries
-      for (auto n = left->next(); n != EndOfStream; n = left->next()) {
-         found += n;
-         // build hashes
-         buildHash.evaluate(n);
-         // scatter hash, keys and values into ht entries
-         auto alloc =
-             runtime::this_worker->allocator.allocate(n * ht_entry_size);
-         if (!alloc) throw std::runtime_error("malloc failed");
-         allocations.push_back(std::make_pair(alloc, n));
-         scatterStart = reinterpret_cast<decltype(scatterStart)>(alloc);
-         buildScatter.evaluate(n);
-      }
-
-      // --- build phase 2: insert ht entries
-      shared.found.fetch_add(found);
-      barrier([&]() {
-         auto globalFound = shared.found.load();
-         if (globalFound) shared.ht.setSize(globalFound);
-      });
-      auto globalFound = shared.found.load();
-      if (globalFound == 0) {
-         consumed = true;
-         return EndOfStream;
+      for (size_t j = 0; j < candidates; ++j) {
+         auto i = followupIds[j];
+         auto entry = followupEntries[j];
+         if (entry->hash == probeHashes[i]) {
+            buildMatches[found] = entry;
+            probeMatches[found++] = probePos(i);
+         }
       }
-      insertAllEntries(allocations, shared.ht, ht_entry_size);
-      consumed = true;
-      barrier(); // wait for all threads to finish build phase
+      found = keyEquality.evaluate(found);
+      for (size_t j = 0; j < found; ++j) probeMatched[probeMatches[j]] = 1;
+      if (firstMatch)
+         for (size_t j = 0; j < found; ++j)
+            firstMatch[probeMatches[j]] = buildMatches[j];
+      // advance in the chains of all probes without match
+      size_t next = 0;
+      for (size_t j = 0; j < candidates; ++j) {
+         auto i = followupIds[j];
+         auto entry = followupEntries[j];
+         if (!probeMatched[probePos(i)] && entry->next != end) {
+            followupIds[next] = i;
+            followupEntries[next++] = entry->next;
+         }
+      }
+      candidates = next;
+   }
+   cont.nextProbe = cont.numProbes;
+}
+
+pos_t Hashjoin::joinSemi() {
+   findFirstMatches();
+   size_t found = 0;
+   for (size_t i = 0; i < cont.numProbes; ++i) {
+      auto pos = probePos(i);
+      probeMatches[found] = pos;
+      found += probeMatched[pos];
+   }
+   return found;
+}
+
+pos_t Hashjoin::joinAnti() {
+   findFirstMatches();
+   size_t found = 0;
+   for (size_t i = 0; i < cont.numProbes; ++i) {
+      auto pos = probePos(i);
+      probeMatches[found] = pos;
+      found += !probeMatched[pos];
+   }
+   return found;
+}
+
+pos_t Hashjoin::joinMark() {
+   findFirstMatches();
+   for (size_t i = 0; i < cont.numProbes; ++i) {
+      auto pos = probePos(i);
+      probeMatches[i] = pos;
+      marker[i] = probeMatched[pos];
+   }
+   return cont.numProbes;
+}
+
+pos_t Hashjoin::joinUnique() {
+   findFirstMatches();
+   size_t found = 0;
+   for (size_t i = 0; i < cont.numProbes; ++i) {
+      auto pos = probePos(i);
+      buildMatches[found] = firstMatch[pos];
+      probeMatches[found] = pos;
+      found += probeMatched[pos];
+   }
+   return found;
+}
+
+pos_t Hashjoin::joinOuterRest() {
+   size_t found = 0;
+   for (size_t i = outerNext; i < cont.numProbes; ++i) {
+      auto pos = probePos(i);
+      if (probeMatched[pos]) continue;
+      buildMatches[found] = nullEntry;
+      probeMatches[found] = pos;
+      if (marker) marker[found] = 0;
+      if (++found == batchSize) {
+         outerNext = i + 1;
+         return found;
+      }
+   }
+   outerNext = cont.numProbes;
+   return found;
+}
+
+size_t Hashjoin::nextGroup() {
+   using runtime::Hashmap;
+   if (!probed) {
+      // aggregate all probe tuples into their build entries
+      for (auto n = right->next(); n != EndOfStream; n = right->next()) {
+         cont.numProbes = n;
+         cont.nextProbe = 0;
+         probeHash.evaluate(n);
+         auto found = (this->*join)();
+         for (size_t i = 0; i < found; ++i) {
+            auto matched = reinterpret_cast<uint8_t*>(
+                addBytes(buildMatches[i], groupMatchedOffset));
+            if (!__atomic_load_n(matched, __ATOMIC_RELAXED))
+               __atomic_store_n(matched, 1, __ATOMIC_RELAXED);
+         }
+         probeAggregates.evaluate(found);
+      }
+      probed = true;
+      barrier(); // wait until all aggregates are complete
+   }
+   // emit matched entries which were materialized by this thread
+   size_t n = 0;
+   while (nextAllocation < allocations.size() && n < batchSize) {
+      auto& alloc = allocations[nextAllocation];
+      auto entries = static_cast<uint8_t*>(alloc.first);
+      for (; nextEntry < alloc.second && n < batchSize; ++nextEntry) {
+         auto entry = entries + nextEntry * ht_entry_size;
+         buildMatches[n] = reinterpret_cast<Hashmap::EntryHeader*>(entry);
+         n += entry[groupMatchedOffset];
+      }
+      if (nextEntry == alloc.second) {
+         nextAllocation++;
+         nextEntry = 0;
+      }
+   }
+   if (n == 0) return EndOfStream;
+   buildGather.evaluate(n);
+   return n;
+}
+
+bool Hashjoin::needsMatch() const {
+   return mode == Mode::Inner || mode == Mode::Semi || mode == Mode::Group;
+}
+
+void Hashjoin::materialize() {
+   runtime::MemoryScope scope(shared.memory);
+   size_t found = 0;
+   for (auto n = left->next(); n != EndOfStream; n = left->next()) {
+      found += n;
+      // build hashes
+      buildHash.evaluate(n);
+      // scatter hash, keys and values into ht entries
+      auto alloc = runtime::this_worker->allocator.allocate(n * ht_entry_size);
+      if (!alloc) throw std::runtime_error("malloc failed");
+      allocations.push_back(std::make_pair(alloc, n));
+      scatterStart = reinterpret_cast<decltype(scatterStart)>(alloc);
+      buildScatter.evaluate(n);
+   }
+   shared.found.fetch_add(found);
+}
+
+void Hashjoin::insert() {
+   using runtime::Hashmap;
+   runtime::MemoryScope scope(shared.memory);
+   consumed = true;
+   empty = shared.found.load() == 0 && needsMatch();
+   if (empty) return;
+   insertAllEntries(allocations, shared.ht, ht_entry_size);
+   if (mode == Mode::LeftOuter) {
+      auto entry = runtime::this_worker->allocator.allocate(ht_entry_size);
+      // the entry header and all build columns of the null entry are zero
+      std::memset(entry, 0, ht_entry_size);
+      nullEntry = reinterpret_cast<Hashmap::EntryHeader*>(entry);
    }
+}
+
+void Hashjoin::build() {
+   // joins of the group which are not built yet, all threads see them in
+   // the same order and therefore pass the same barriers
+   std::vector<Hashjoin*> joins;
+   if (concurrentBuilds.empty())
+      joins.push_back(this);
+   else
+      for (auto join : concurrentBuilds)
+         if (!join->consumed) joins.push_back(join);
+   // --- build phase 1: materialize ht entries
+   for (auto join : joins) join->materialize();
+   // --- build phase 2: insert ht entries
+   barrier([&]() {
+      for (auto join : joins) {
+         auto globalFound = join->shared.found.load();
+         if (globalFound || !join->needsMatch())
+            join->shared.ht.setSize(std::max(globalFound, size_t(1)));
+      }
+   });
+   for (auto join : joins) join->insert();
+   barrier(); // wait for all threads to finish build phase
+}
+
+size_t Hashjoin::next() {
+   runtime::MemoryScope scope(shared.memory);
+   // semi, anti and mark joins check keys themselves and have no payload
+   const bool pairs = mode == Mode::Inner || mode == Mode::LeftOuter;
+   // --- build
+   if (!consumed) build();
+   if (empty) return EndOfStream;
+   if (mode == Mode::Group) return nextGroup();
    // --- lookup
    while (true) {
       if (cont.nextProbe >= cont.numProbes) {
+         if (mode == Mode::LeftOuter && outerNext < cont.numProbes) {
+            // all matches of probe vector are produced, add the rest
+            auto n = joinOuterRest();
+            if (n == 0) continue;
+            buildGather.evaluate(n);
+            return n;
+         }
          cont.numProbes = right->next();
          cont.nextProbe = 0;
          if (cont.numProbes == EndOfStream) return EndOfStream;
          probeHash.evaluate(cont.numProbes);
+         if (mode == Mode::LeftOuter) {
+            outerNext = 0;
+            for (size_t i = 0; i < cont.numProbes; ++i)
+               probeMatched[probePos(i)] = 0;
+         }
       }
       // create join pair vectors with matching hashes (Entry*, pos), where
       // Entry* is for the build side, pos a selection index to the right side
       auto n = (this->*join)();
-      // check key equality and remove non equal keys from join result
-      n = keyEquality.evaluate(n);
+      if (!pairs) {
+         if (n == 0) continue;
+         return n;
+      }
+      // check key equality and remove non equal keys from join result,
+      // joinUnique only returns pairs with equal keys
+      if (!uniqueBuildKeys) n = keyEquality.evaluate(n);
+      probeLookup.evaluate(n);
+      if (mode == Mode::LeftOuter)
+         for (size_t i = 0; i < n; ++i) {
+            probeMatched[probeMatches[i]] = 1;
+            if (marker) marker[i] = 1;
+         }
       if (n == 0) continue;
       // materialize build side
       buildGather.evaluate(n);
@@ -819,101 +1031,223 @@ HashGroup::~HashGroup() {
    // for (auto& alloc : globalAggregation.allocations) free(alloc.first);
 }
 
+void HashGroup::aggregatePartition(size_t partNr) {
+   // for all thread local partitions
+   for (auto& threadPartitions : shared.spillStorage) {
+      // aggregate data from thread local partition
+      auto& partition = threadPartitions.getPartitions()[partNr];
+      for (auto chunk = partition.first; chunk; chunk = chunk->next) {
+         auto elementSize = threadPartitions.entrySize;
+         auto nPart = partition.size(chunk, elementSize);
+         for (size_t n = std::min(nPart, vecSize), pos = 0; n;
+              nPart -= n, pos += n, n = std::min(nPart, vecSize)) {
+
+            // communicate data position of current chunk to primitives
+            // for group lookup and creation
+            auto data = addBytes(chunk->data<void>(), pos * elementSize);
+            globalAggregation.rowData = data;
+            findGroupsFromPartition(data, n);
+            auto cGroups = [&]() INTERPRET_SEPARATE {
+               globalAggregation.createMissingGroups(ht, true);
+            };
+            cGroups();
+            updateGroupsFromPartition.evaluate(n);
+         }
+      }
+   }
+}
+
 pos_t HashGroup::findGroupsFromPartition(void* data, size_t n) {
    globalAggregation.groupHashes = reinterpret_cast<hash_t*>(data);
    return globalAggregation.findGroups(n, ht);
 }
 
+size_t HashGroup::nextPartial() {
+   using header_t = decltype(ht)::EntryHeader;
+   for (;;) {
+      // pass on the groups of the local hashtable block by block
+      auto& blocks = preAggregation.allocations;
+      while (cont.partialBlock < blocks.size()) {
+         auto& block = blocks[cont.partialBlock++];
+         if (!block.second) continue;
+         *globalAggregation.htMatches =
+             reinterpret_cast<header_t*>(block.first);
+         gatherGroups.evaluate(block.second);
+         return block.second;
+      }
+      preAggregation.clearHashtable(ht);
+      cont.partialBlock = 0;
+      if (cont.consumed) return EndOfStream;
+      // aggregate input until the hashtable is full
+      size_t groups = 0;
+      for (;;) {
+         auto n = child->next();
+         if (n == EndOfStream) {
+            cont.consumed = true;
+            break;
+         }
+         groupHash.evaluate(n);
+         adaptivity.consumed(n);
+         if (!adaptivity.aggregate()) {
+            // only combine equal keys within the vector and pass them on
+            groups += preAggregation.createVectorGroups(n, ht);
+            updateGroups.evaluate(n);
+            break;
+         }
+         preAggregation.findGroups(n, ht);
+         groups += preAggregation.createMissingGroups(ht, false);
+         updateGroups.evaluate(n);
+         if (groups >= maxFill) break;
+      }
+      if (groups) adaptivity.flushed(groups);
+   }
+}
+
 size_t HashGroup::next() {
    using header_t = decltype(ht)::EntryHeader;
+   runtime::MemoryScope scope(shared.memory);
+   if (partial) return nextPartial();
    if (!cont.consumed) {
       /// ------ phase 1: local preaggregation
       /// aggregate all incoming tuples into local hashtable
       size_t groups = 0;
+      size_t spilled = 0;
       auto& spill = shared.spillStorage.local();
       auto entry_size = preAggregation.ht_entry_size;
 
-      auto flushAndClear = [&]() INTERPRET_SEPARATE {
+      auto spillGroups = [&]() INTERPRET_SEPARATE {
          assert(offsetof(header_t, next) + sizeof(header_t::next) ==
                 offsetof(header_t, hash));
          // flush ht entries into spillStorage
          for (auto& alloc : preAggregation.allocations) {
+            spilled += alloc.second;
             for (auto entry = reinterpret_cast<header_t*>(alloc.first),
                       end = addBytes(entry, alloc.second * entry_size);
                  entry < end; entry = addBytes(entry, entry_size))
                spill.push_back(&entry->hash, entry->hash);
          }
          preAggregation.allocations.clear();
+      };
+      auto flushAndClear = [&]() INTERPRET_SEPARATE {
+         spillGroups();
          preAggregation.clearHashtable(ht);
+         adaptivity.flushed(groups);
+         groups = 0;
       };
 
       for (pos_t n = child->next(); n != EndOfStream; n = child->next()) {
          groupHash.evaluate(n);
-         preAggregation.findGroups(n, ht);
-         auto groupsCreated = preAggregation.createMissingGroups(ht, false);
-         updateGroups.evaluate(n);
-         groups += groupsCreated;
-         if (groups >= maxFill) flushAndClear();
+         adaptivity.consumed(n);
+         if (adaptivity.aggregate()) {
+            preAggregation.findGroups(n, ht);
+            auto groupsCreated = preAggregation.createMissingGroups(ht, false);
+            updateGroups.evaluate(n);
+            groups += groupsCreated;
+            if (groups >= maxFill) flushAndClear();
+         } else {
+            // pre-aggregation does not reduce the input, only combine equal
+            // keys within the vector and spill the groups right away
+            groups += preAggregation.createVectorGroups(n, ht);
+            updateGroups.evaluate(n);
+            spillGroups();
+            groupStore.reset();
+            preAggregation.entries_in_ht = 0;
+            if (groups >= maxFill) {
+               adaptivity.flushed(groups);
+               groups = 0;
+            }
+         }
       }
       flushAndClear(); // flush remaining entries into spillStorage
-      barrier();       // Wait until all workers have finished phase 1
+      spill.flush();
+      shared.spilledGroups.fetch_add(spilled);
+      // Wait until all workers have finished phase 1, then order partitions
+      // by size so that large partitions do not end up in the tail
+      barrier([&]() {
+         std::vector<std::pair<size_t, size_t>> sizes;
+         for (size_t partNr = 0; partNr < nrPartitions; ++partNr) {
+            size_t size = 0;
+            for (auto& threadPartitions : shared.spillStorage) {
+               auto& partition = threadPartitions.getPartitions()[partNr];
+               for (auto chunk = partition.first; chunk; chunk = chunk->next)
+                  size += partition.size(chunk, threadPartitions.entrySize);
+            }
+            sizes.emplace_back(size, partNr);
+         }
+         std::sort(sizes.begin(), sizes.end(), std::greater<>());
+         shared.partitionOrder.clear();
+         for (auto& size : sizes) shared.partitionOrder.push_back(size.second);
+      });
 
       cont.consumed = true;
       cont.partition = shared.partition.fetch_add(1);
       cont.partitionNeedsAggregation = true;
+      // with few groups, the first worker merges all partitions in one pass
+      // and the others are done
+      cont.singlePhase =
+          shared.spilledGroups.load() <= runtime::singlePhaseGroupLimit;
+      if (cont.singlePhase && cont.partition) cont.partition = nrPartitions;
    }
 
    /// ------ phase 2: global aggregation
-   // get a partition
-   for (; cont.partition < nrPartitions;) {
+   // fill the result vector with groups of as many blocks and partitions as
+   // needed. Blocks of at least half a vector are passed on in place, smaller
+   // ones are copied into resultBuffer
+   auto entrySize = globalAggregation.ht_entry_size;
+   size_t filled = 0;
+   for (;;) {
       if (cont.partitionNeedsAggregation) {
-         auto partNr = cont.partition;
-         // for all thread local partitions
-         for (auto& threadPartitions : shared.spillStorage.threadData) {
-            // aggregate data from thread local partition
-            auto& partition = threadPartitions.second.getPartitions()[partNr];
-            for (auto chunk = partition.first; chunk; chunk = chunk->next) {
-               auto elementSize = threadPartitions.second.entrySize;
-               auto nPart = partition.size(chunk, elementSize);
-               for (size_t n = std::min(nPart, vecSize), pos = 0; n;
-                    nPart -= n, pos += n, n = std::min(nPart, vecSize)) {
-
-                  // communicate data position of current chunk to primitives
-                  // for group lookup and creation
-                  auto data = addBytes(chunk->data<void>(), pos * elementSize);
-                  globalAggregation.rowData = data;
-                  findGroupsFromPartition(data, n);
-                  auto cGroups = [&]() INTERPRET_SEPARATE {
-                     globalAggregation.createMissingGroups(ht, true);
-                  };
-                  cGroups();
-                  updateGroupsFromPartition.evaluate(n);
-               }
-            }
-         }
+         // get a partition
+         if (cont.partition >= nrPartitions) break;
+         if (cont.singlePhase)
+            for (size_t partNr = 0; partNr < nrPartitions; ++partNr)
+               aggregatePartition(partNr);
+         else
+            aggregatePartition(shared.partitionOrder[cont.partition]);
          cont.partitionNeedsAggregation = false;
          cont.iter = globalAggregation.allocations.begin();
+         cont.blockPos = 0;
       }
-      // send aggregation result to parent operator
-      // TODO: refill result instead of sending all allocations separately
-      if (cont.iter != globalAggregation.allocations.end()) {
-         auto& block = *cont.iter;
-         // write current block start to htMatches so the the gather primitives
-         // can read the offset from there
+      if (cont.iter == globalAggregation.allocations.end()) {
+         auto htClear = [&]() INTERPRET_SEPARATE {
+            globalAggregation.clearHashtable(ht);
+         };
+         htClear();
+         cont.partitionNeedsAggregation = true;
+         cont.partition =
+             cont.singlePhase ? nrPartitions : shared.partition.fetch_add(1);
+         continue;
+      }
+      auto& block = *cont.iter;
+      if (filled == 0 && cont.blockPos == 0 && block.second * 2 >= vecSize) {
+         // write current block start to htMatches so the the gather
+         // primitives can read the offset from there
          *globalAggregation.htMatches =
              reinterpret_cast<header_t*>(block.first);
          auto n = block.second;
          gatherGroups.evaluate(n);
          cont.iter++;
          return n;
-      } else {
-         auto htClear = [&]() INTERPRET_SEPARATE {
-            globalAggregation.clearHashtable(ht);
-         };
-         htClear();
-         cont.partitionNeedsAggregation = true;
-         cont.partition = shared.partition.fetch_add(1);
       }
+      if (!resultBuffer)
+         resultBuffer =
+             runtime::this_worker->allocator.allocate(vecSize * entrySize);
+      auto n = std::min(block.second - cont.blockPos, vecSize - filled);
+      std::memcpy(addBytes(resultBuffer, filled * entrySize),
+                  addBytes(block.first, cont.blockPos * entrySize),
+                  n * entrySize);
+      filled += n;
+      cont.blockPos += n;
+      if (cont.blockPos == block.second) {
+         cont.iter++;
+         cont.blockPos = 0;
+      }
+      if (filled == vecSize) break;
+   }
+   if (filled) {
+      *globalAggregation.htMatches = reinterpret_cast<header_t*>(resultBuffer);
+      gatherGroups.evaluate(filled);
+      return filled;
    }
    return EndOfStream;
 }
@@ -1,5 +1,7 @@
 #include "vectorwise/QueryBuilder.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <unistd.h>
 
 using namespace std;
 
@@ -15,6 +17,8 @@ size_t padding(size_t size, size_t align) {
 size_t QueryBuilder::nextOpNr() { return opNr++; }
 size_t QueryBuilder::nextOnceNr() { return onceNr++; }
 QueryBuilder::~QueryBuilder() {
+   // leave the query, also when unwinding after a failure
+   runtime::this_worker->query = nullptr;
    runtime::this_worker->allocator.setSource(previous);
 }
 
@@ -98,6 +102,55 @@ QueryBuilder::ProjectionBuilder& QueryBuilder::ProjectionBuilder::addExpression(
    return *this;
 }
 
+QueryBuilder::MaterializeBuilder QueryBuilder::Materialize() {
+   auto project = make_unique<class Project>();
+   auto p = project.get();
+   p->child = popOperator();
+   pushOperator(move(project));
+   return {*this, *p};
+}
+
+QueryBuilder::MaterializeBuilder&
+QueryBuilder::MaterializeBuilder::addColumn(DS col, DS sel,
+                                            primitives::F3 materialize,
+                                            DS out) {
+   project.expressions.push_back(
+       base.Expression().addOp(materialize, sel, out, col));
+   return *this;
+}
+
+QueryBuilder::MaterializeBuilder& QueryBuilder::MaterializeBuilder::addColumn(
+    ScanBuilder& scan, std::string attribute, DS rowIds,
+    primitives::F3 materialize, DS out) {
+   // the base pointer of the column is passed as value, it must not be
+   // advanced by the scan
+   auto column = base.Value(scan.rel[attribute].data());
+   project.expressions.push_back(
+       base.Expression().addOp(materialize, rowIds, out, column));
+   return *this;
+}
+
+QueryBuilder::DS QueryBuilder::RowIds(ScanBuilder& scan, DS out) {
+   Project().addExpression(Expression().addOp(
+       primitives::rowid_col, out, Value(scan.scan.currentOffset())));
+   return out;
+}
+
+bool QueryBuilder::materializeLate(ScanBuilder& scan, std::string attribute,
+                                   size_t copies, double selectivity) {
+   const double size = scan.rel[attribute].type->rt_size();
+   // fetches by row id are random accesses, which miss the cache unless the
+   // column fits into it
+   long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+   size_t cache = l2 > 0 ? size_t(l2) : 256 * 1024;
+   double fetch = size * scan.rel.nrTuples <= cache
+                      ? size
+                      : std::max(size, double(cacheMissCost));
+   double early = copies * size;
+   double late = copies * sizeof(uint64_t) + selectivity * fetch;
+   return late < early;
+}
+
 QueryBuilder::ExpressionBuilder QueryBuilder::Expression() {
    QueryBuilder::ExpressionBuilder b;
    b.expression = make_unique<class Expression>();
@@ -129,6 +182,9 @@ QueryBuilder::DS QueryBuilder::Column(ScanBuilder& scan,
    r.dataSize = attr.type->rt_size();
    r.data = attr.data();
    r.scan = &scan.scan;
+   auto& columns = scan.scan.columns;
+   if (find(columns.begin(), columns.end(), &attr) == columns.end())
+      columns.push_back(&attr);
    return r;
 }
 
@@ -204,6 +260,18 @@ QueryBuilder::ExpressionBuilder::addOp(primitives::F4 op, DS a, DS b, DS c,
    expression->ops.push_back(move(f4));
    return *this;
 }
+QueryBuilder::ExpressionBuilder&
+QueryBuilder::ExpressionBuilder::addOp(primitives::F5 op, DS a, DS b, DS c,
+                                       DS d, DS e) {
+   auto f5 = make_unique<F5_Op>(a, b, c, d, e, op);
+   a.registerDS(&f5->inputSelectionV);
+   b.registerDS(&f5->outputSelectionV);
+   c.registerDS(&f5->param1);
+   d.registerDS(&f5->param2);
+   e.registerDS(&f5->param3);
+   expression->ops.push_back(move(f5));
+   return *this;
+}
 QueryBuilder::ExpressionBuilder::
 operator std::unique_ptr<vectorwise::Expression>() {
    return move(expression);
@@ -249,10 +317,76 @@ QueryBuilder::HashJoin(DS probeMatches, pos_t (Hashjoin::*joinFun)()) {
    b.join->buildScatter += move(scatter_hash);
    b.join->right = popOperator();
    b.join->left = popOperator();
+   joins[probeMatches] = b.join;
    pushOperator(move(join));
    return b;
 }
 
+/// op is part of tree
+static bool contains(Operator* tree, Operator* op) {
+   if (!tree) return false;
+   if (tree == op) return true;
+   if (auto unary = dynamic_cast<UnaryOperator*>(tree))
+      return contains(unary->child.get(), op);
+   if (auto binary = dynamic_cast<BinaryOperator*>(tree))
+      return contains(binary->left.get(), op) ||
+             contains(binary->right.get(), op);
+   return false;
+}
+
+void QueryBuilder::BuildConcurrently(std::vector<DS> probeMatches) {
+   std::vector<Hashjoin*> group;
+   for (auto& matches : probeMatches) {
+      auto join = joins.find(matches);
+      if (join == joins.end())
+         throw std::runtime_error("No hash join produces these matches");
+      if (!join->second->concurrentBuilds.empty())
+         throw std::runtime_error("Hash join is already built concurrently");
+      group.push_back(join->second);
+   }
+   for (auto join : group)
+      for (auto other : group)
+         if (join != other && contains(join->left.get(), other))
+            throw std::runtime_error(
+                "Build side of a concurrently built hash join depends on "
+                "another one of them");
+   for (auto join : group) join->concurrentBuilds = group;
+}
+
+/// join loop which computes the result of mode without payload
+static pos_t (Hashjoin::*modeJoin(Hashjoin::Mode mode))() {
+   switch (mode) {
+   case Hashjoin::Mode::Semi: return &Hashjoin::joinSemi;
+   case Hashjoin::Mode::Anti: return &Hashjoin::joinAnti;
+   case Hashjoin::Mode::Mark: return &Hashjoin::joinMark;
+   default: return nullptr;
+   }
+}
+
+QueryBuilder::HashJoinBuilder QueryBuilder::HashJoin(DS probeMatches,
+                                                     Hashjoin::Mode mode) {
+   auto b = HashJoin(probeMatches);
+   b.join->mode = mode;
+   if (mode != Hashjoin::Mode::Inner)
+      b.join->probeMatched = static_cast<uint8_t*>(vecs.get(sizeof(uint8_t)));
+   if (auto joinFun = modeJoin(mode)) b.join->join = joinFun;
+   // joinMark writes the marker of every probe, setMarker may replace it
+   if (mode == Hashjoin::Mode::Mark)
+      b.join->marker = static_cast<uint8_t*>(vecs.get(sizeof(uint8_t)));
+   if (mode == Hashjoin::Mode::Group) {
+      // flag for build entries with a match, cleared on build
+      b.join->groupMatchedOffset = b.join->ht_entry_size;
+      b.join->ht_entry_size += sizeof(uint8_t);
+      b.join->buildScatter += make_unique<FAggrInitOp>(
+          primitives::aggr_init_plus_int8_t_col,
+          reinterpret_cast<void**>(&b.join->scatterStart),
+          &b.join->ht_entry_size, b.join->groupMatchedOffset);
+      // aggregates are updated for the single matching build entry
+      b.setUniqueBuildKeys();
+   }
+   return b;
+}
+
 QueryBuilder::HashJoinBuilder&
 QueryBuilder::HashJoinBuilder::addBuildKey(DS col, primitives::F2 hash,
                                            primitives::FScatter scatter) {
@@ -376,6 +510,9 @@ QueryBuilder::HashJoinBuilder::addProbeKey(DS col, DS sel, primitives::F3 hash,
 QueryBuilder::HashJoinBuilder& QueryBuilder::HashJoinBuilder::addBuildValue(
     DS source, primitives::FScatter scatter, DS target,
     primitives::FGather gather) {
+   if (modeJoin(join->mode))
+      throw runtime_error("Build values are not available in semi, anti and "
+                          "mark joins.");
    auto entryOffset = join->ht_entry_size;
    join->ht_entry_size += source.dataSize;
 
@@ -395,6 +532,9 @@ QueryBuilder::HashJoinBuilder& QueryBuilder::HashJoinBuilder::addBuildValue(
 QueryBuilder::HashJoinBuilder& QueryBuilder::HashJoinBuilder::addBuildValue(
     DS source, DS sel, primitives::FScatterSel scatter, DS target,
     primitives::FGather gather) {
+   if (modeJoin(join->mode))
+      throw runtime_error("Build values are not available in semi, anti and "
+                          "mark joins.");
 
    auto entryOffset = join->ht_entry_size;
    join->ht_entry_size += source.dataSize;
@@ -419,7 +559,9 @@ QueryBuilder::HashJoinBuilder::setProbeSelVector(DS sel,
       throw runtime_error("Probe selection vector was added when probe keys "
                           "were already present");
    join->probeSel = sel;
-   join->join = joinFun;
+   // semi, anti, mark and unique joins keep their loop, it handles probeSel
+   // itself
+   if (!modeJoin(join->mode) && !join->uniqueBuildKeys) join->join = joinFun;
    probeHasSelection = true;
    return *this;
 }
@@ -429,10 +571,68 @@ QueryBuilder::HashJoinBuilder::pushProbeSelVector(DS sel, DS target) {
    if (probeHasSelection)
       throw runtime_error("Pushing a probe selection vector is in conflict "
                           "with first setting a probe selection vector.");
-   // add lookup to keys_equal
+   if (join->mode != Hashjoin::Mode::Inner)
+      throw runtime_error("Pushing a probe selection vector is only possible "
+                          "for inner joins.");
+   // lookup after the key check
    auto lookup = move(base.Expression().addOp(
        primitives::lookup_sel, target, base.Value(join->probeMatches), sel));
-   join->keyEquality.ops.push_back(move(lookup.expression->ops.back()));
+   join->probeLookup.ops.push_back(move(lookup.expression->ops.back()));
+   return *this;
+}
+
+QueryBuilder::HashJoinBuilder&
+QueryBuilder::HashJoinBuilder::setMarker(DS target) {
+   if (join->mode != Hashjoin::Mode::Mark &&
+       join->mode != Hashjoin::Mode::LeftOuter)
+      throw runtime_error("Markers are only available in mark and left outer "
+                          "joins.");
+   join->marker = static_cast<uint8_t*>((void*)target);
+   return *this;
+}
+
+QueryBuilder::HashJoinBuilder&
+QueryBuilder::HashJoinBuilder::setUniqueBuildKeys(bool unique) {
+   // semi, anti and mark joins stop at the first match anyway
+   if (!unique || modeJoin(join->mode)) return *this;
+   join->uniqueBuildKeys = true;
+   join->join = &Hashjoin::joinUnique;
+   if (!join->probeMatched)
+      join->probeMatched =
+          static_cast<uint8_t*>(base.vecs.get(sizeof(uint8_t)));
+   join->firstMatch = static_cast<runtime::Hashmap::EntryHeader**>(
+       base.vecs.get(sizeof(runtime::Hashmap::EntryHeader*)));
+   return *this;
+}
+
+QueryBuilder::HashJoinBuilder&
+QueryBuilder::HashJoinBuilder::addGroupAggregate(DS col,
+                                                 primitives::FAggrInit aggrInit,
+                                                 primitives::FAggrSel aggr,
+                                                 DS target,
+                                                 primitives::FGather gather) {
+   if (join->mode != Hashjoin::Mode::Group)
+      throw runtime_error("Group aggregates are only available in group "
+                          "joins.");
+   // aggregates are updated atomically and need to be aligned
+   join->ht_entry_size += padding(join->ht_entry_size, col.dataSize);
+   auto entryOffset = join->ht_entry_size;
+   join->ht_entry_size += col.dataSize;
+
+   auto aggregateInitOp = make_unique<FAggrInitOp>(
+       aggrInit, reinterpret_cast<void**>(&join->scatterStart),
+       &join->ht_entry_size, entryOffset);
+   join->buildScatter += move(aggregateInitOp);
+
+   auto aggr_op = make_unique<FAggrSelOp>(
+       aggr, reinterpret_cast<void**>(join->buildMatches), join->probeMatches,
+       col, entryOffset);
+   col.registerDS(&aggr_op->get<2>());
+   join->probeAggregates += move(aggr_op);
+
+   auto gather_build = make_unique<GatherOpCol>(
+       gather, (void**)join->buildMatches, entryOffset, target);
+   join->buildGather.ops.push_back(move(gather_build));
    return *this;
 }
 
@@ -517,6 +717,65 @@ QueryBuilder::HashGroupBuilder QueryBuilder::HashGroup() {
    return b;
 }
 
+QueryBuilder::HashGroupBuilder QueryBuilder::PartialHashGroup() {
+   auto b = HashGroup();
+   b.group->partial = true;
+   return b;
+}
+
+QueryBuilder::HashGroupBuilder&
+QueryBuilder::HashGroupBuilder::mergeValue(DS col, DS out) {
+   auto partial = base.partialAggregates.find(col.data);
+   if (partial == base.partialAggregates.end())
+      throw runtime_error("Merged value is not produced by a partial "
+                          "aggregation.");
+   auto merge = primitives::aggrMergeOf(partial->second);
+   return addValue(col, merge.init, merge.aggr, merge.aggrRow, merge.gather,
+                   out);
+}
+
+QueryBuilder::HashGroupBuilder&
+QueryBuilder::HashGroupBuilder::mergeValue(DS col, DS sel, DS out) {
+   auto partial = base.partialAggregates.find(col.data);
+   if (partial == base.partialAggregates.end())
+      throw runtime_error("Merged value is not produced by a partial "
+                          "aggregation.");
+   auto merge = primitives::aggrMergeOf(partial->second);
+   return addValue(col, sel, merge.init, merge.aggrSel, merge.aggrRow,
+                   merge.gather, out);
+}
+
+QueryBuilder::HashGroupBuilder&
+QueryBuilder::HashGroupBuilder::addWideSum(DS col, DS out) {
+   if (col.dataSize != sizeof(int64_t))
+      throw runtime_error("Wide sums need a 64 bit input column.");
+   addValue(col, primitives::aggr_init_wide_plus_col,
+            primitives::aggr_wide_plus_int64_t_col,
+            primitives::aggr_row_wide_plus_col,
+            primitives::gather_val_Sum128_col, out);
+   widenLastValue(col);
+   return *this;
+}
+
+QueryBuilder::HashGroupBuilder&
+QueryBuilder::HashGroupBuilder::addWideSum(DS col, DS sel, DS out) {
+   if (col.dataSize != sizeof(int64_t))
+      throw runtime_error("Wide sums need a 64 bit input column.");
+   addValue(col, sel, primitives::aggr_init_wide_plus_col,
+            primitives::aggr_wide_sel_plus_int64_t_col,
+            primitives::aggr_row_wide_plus_col,
+            primitives::gather_val_Sum128_col, out);
+   widenLastValue(col);
+   return *this;
+}
+
+void QueryBuilder::HashGroupBuilder::widenLastValue(DS col) {
+   // the aggregate was sized like col, the entry grows behind it
+   auto growth = sizeof(types::Sum128) - col.dataSize;
+   group->preAggregation.ht_entry_size += growth;
+   group->globalAggregation.ht_entry_size += growth;
+}
+
 QueryBuilder::HashGroupBuilder::~HashGroupBuilder() {
 
    // set partitioning buffers in operator
@@ -534,14 +793,13 @@ QueryBuilder::HashGroupBuilder::~HashGroupBuilder() {
    global.ht_entry_size += padding(local.ht_entry_size, 8);
 
    // create spillStorage for this thread
-   // use 8 * <number of workers> partitions
 
    // next pointer is not copied to spillStorage
    auto rowSize =
        local.ht_entry_size - sizeof(runtime::Hashmap::EntryHeader::next);
-   // TODO: this seems wrong!
    auto& spill = op.shared.spillStorage.create(
-       runtime::this_worker->group->size * 4, rowSize);
+       runtime::spillFanOut(runtime::this_worker->group->size, rowSize),
+       rowSize);
    op.nrPartitions = spill.getPartitions().size();
    global.rowSize = rowSize;
 }
@@ -739,6 +997,7 @@ QueryBuilder::HashGroupBuilder& QueryBuilder::HashGroupBuilder::addValue(
        gather, reinterpret_cast<void**>(global.htMatches), entryOffset,
        &global.ht_entry_size, out);
    op.gatherGroups.ops.push_back(move(gather_groups));
+   if (op.partial) base.partialAggregates[out.data] = aggrGlobal;
    return *this;
 }
 
@@ -781,6 +1040,7 @@ QueryBuilder::HashGroupBuilder& QueryBuilder::HashGroupBuilder::addValue(
        gather, reinterpret_cast<void**>(global.htMatches), entryOffset,
        &global.ht_entry_size, out);
    op.gatherGroups.ops.push_back(move(gather_groups));
+   if (op.partial) base.partialAggregates[out.data] = aggrGlobal;
    return *this;
 }
 
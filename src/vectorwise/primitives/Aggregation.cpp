@@ -1,7 +1,10 @@
 #include "common/runtime/Hash.hpp"
 #include "vectorwise/Operations.hpp"
 #include "vectorwise/Primitives.hpp"
+#include <algorithm>
 #include <functional>
+#include <immintrin.h>
+#include <stdexcept>
 
 using namespace types;
 using namespace std;
@@ -22,6 +25,9 @@ namespace primitives {
    FAggrRow aggr_row_##op##_##type##_col = (FAggrRow)&aggr_row<type, op>;
 #define MK_AGGR_INIT(type, op)                                                 \
    FAggrInit aggr_init_##op##_##type##_col = (FAggrInit)&aggr_init<type, op>;
+#define MK_AGGR_SEL_ATOMIC_PLUS(type)                                          \
+   FAggrSel aggr_sel_atomic_plus_##type##_col =                                \
+       (FAggrSel)&aggr_sel_atomic_plus_col<type>;
 
 pos_t aggr_static_count_star_(pos_t n, int64_t* RES result)
 /// aggregate column
@@ -43,11 +49,335 @@ pos_t aggr_count_star_(pos_t n, int64_t* RES entries[], void* RES /*param1*/,
 }
 FAggr aggr_count_star = (FAggr)&aggr_count_star_;
 
+F2 aggr_static_wide_plus_int64_t_col = (F2)&aggr_static_wide_col<int64_t>;
+FAggr aggr_wide_plus_int64_t_col = (FAggr)&aggr_wide_col<int64_t>;
+FAggrSel aggr_wide_sel_plus_int64_t_col = (FAggrSel)&aggr_wide_sel_col<int64_t>;
+
+pos_t aggr_row_wide_plus_col_(pos_t n, Sum128* RES entries[], size_t offset,
+                              Sum128** RES dataPtr, size_t* inSizePtr,
+                              size_t inOffset)
+/// add the 128 bit sums of rows into the 128 bit sums given by entries
+{
+   auto data = addBytes(*dataPtr, inOffset);
+   auto inSize = *inSizePtr;
+   for (uint64_t i = 0; i < n; ++i, data = addBytes(data, inSize))
+      addBytes(entries[i], offset)->add(*data);
+   return n;
+}
+FAggrRow aggr_row_wide_plus_col = (FAggrRow)&aggr_row_wide_plus_col_;
+
+pos_t aggr_init_wide_plus_col_(pos_t n, Sum128** RES toInit,
+                               size_t* struct_size, size_t offset) {
+   auto step = *struct_size;
+   auto current = addBytes(*toInit, offset);
+   for (size_t i = 0; i < n; ++i, current = addBytes(current, step))
+      *current = Sum128();
+   return n;
+}
+FAggrInit aggr_init_wide_plus_col = (FAggrInit)&aggr_init_wide_plus_col_;
+
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_STATIC_COL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_STATIC_SEL_COL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_COL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_SEL_COL)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_ROW)
 EACH_ARITH(EACH_TYPE_FULL, MK_AGGR_INIT)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_STATIC_COL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_STATIC_SEL_COL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_COL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_SEL_COL)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_ROW)
+EACH_EXTREMUM(EACH_TYPE_FULL, MK_AGGR_INIT)
+EACH_TYPE_FULL(NIL, MK_AGGR_SEL_ATOMIC_PLUS)
+
+#ifdef __AVX512F__
+/// AVX-512 operations of the aggregations, selected by the scalar operation
+template <typename T> struct Avx512Aggr;
+template <> struct Avx512Aggr<int32_t> {
+   static const size_t lanes = 16;
+   static __m512i set1(int32_t v) { return _mm512_set1_epi32(v); }
+   static __m512i load(const int32_t* p) { return _mm512_loadu_si512(p); }
+   static __m512i gather(const pos_t* sel, const int32_t* p) {
+      return _mm512_i32gather_epi32(_mm512_loadu_si512(sel), p, 4);
+   }
+   static __m512i apply(plus<int32_t>, __m512i a, __m512i b) {
+      return _mm512_add_epi32(a, b);
+   }
+   static __m512i apply(minimum<int32_t>, __m512i a, __m512i b) {
+      return _mm512_min_epi32(a, b);
+   }
+   static __m512i apply(maximum<int32_t>, __m512i a, __m512i b) {
+      return _mm512_max_epi32(a, b);
+   }
+   static int32_t reduce(plus<int32_t>, __m512i a) {
+      return _mm512_reduce_add_epi32(a);
+   }
+   static int32_t reduce(minimum<int32_t>, __m512i a) {
+      return _mm512_reduce_min_epi32(a);
+   }
+   static int32_t reduce(maximum<int32_t>, __m512i a) {
+      return _mm512_reduce_max_epi32(a);
+   }
+};
+template <> struct Avx512Aggr<int64_t> {
+   static const size_t lanes = 8;
+   static __m512i set1(int64_t v) { return _mm512_set1_epi64(v); }
+   static __m512i load(const int64_t* p) { return _mm512_loadu_si512(p); }
+   static __m512i gather(const pos_t* sel, const int64_t* p) {
+      auto idxs = _mm256_loadu_si256((const __m256i*)sel);
+      return _mm512_i32gather_epi64(idxs, (const long long int*)p, 8);
+   }
+   static __m512i apply(plus<int64_t>, __m512i a, __m512i b) {
+      return _mm512_add_epi64(a, b);
+   }
+   static __m512i apply(minimum<int64_t>, __m512i a, __m512i b) {
+      return _mm512_min_epi64(a, b);
+   }
+   static __m512i apply(maximum<int64_t>, __m512i a, __m512i b) {
+      return _mm512_max_epi64(a, b);
+   }
+   static __m512i apply(plus<int64_t>, __m512i a, __mmask8 m, __m512i b) {
+      return _mm512_mask_add_epi64(a, m, a, b);
+   }
+   static __m512i apply(minimum<int64_t>, __m512i a, __mmask8 m, __m512i b) {
+      return _mm512_mask_min_epi64(a, m, a, b);
+   }
+   static __m512i apply(maximum<int64_t>, __m512i a, __mmask8 m, __m512i b) {
+      return _mm512_mask_max_epi64(a, m, a, b);
+   }
+   static int64_t reduce(plus<int64_t>, __m512i a) {
+      return _mm512_reduce_add_epi64(a);
+   }
+   static int64_t reduce(minimum<int64_t>, __m512i a) {
+      return _mm512_reduce_min_epi64(a);
+   }
+   static int64_t reduce(maximum<int64_t>, __m512i a) {
+      return _mm512_reduce_max_epi64(a);
+   }
+};
+
+template <typename T, template <typename> class Op, bool selective>
+pos_t aggr_static_avx512(pos_t n, pos_t* RES inSel, T* RES result,
+                         T* RES param1)
+/// aggregate column into single value. Four independent accumulators hide
+/// the latency of the vector operations, the rest is aggregated scalar
+{
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   using V = Avx512Aggr<T>;
+   const Op<T> op;
+   auto load = [&](uint64_t i) {
+      return selective ? V::gather(inSel + i, param1) : V::load(param1 + i);
+   };
+   auto a0 = V::set1(OpTraits<T, Op>::neutral), a1 = a0, a2 = a0, a3 = a0;
+   uint64_t i = 0;
+   for (; i + 4 * V::lanes <= n; i += 4 * V::lanes) {
+      a0 = V::apply(op, a0, load(i));
+      a1 = V::apply(op, a1, load(i + V::lanes));
+      a2 = V::apply(op, a2, load(i + 2 * V::lanes));
+      a3 = V::apply(op, a3, load(i + 3 * V::lanes));
+   }
+   for (; i + V::lanes <= n; i += V::lanes) a0 = V::apply(op, a0, load(i));
+   a0 = V::apply(op, V::apply(op, a0, a1), V::apply(op, a2, a3));
+   auto aggregator = op(V::reduce(op, a0), *result);
+   for (; i < n; ++i)
+      aggregator = op(param1[selective ? inSel[i] : i], aggregator);
+   *result = aggregator;
+   return selective ? n : n > 0;
+}
+
+template <typename T, template <typename> class Op>
+pos_t aggr_static_col_avx512(pos_t n, T* RES result, T* RES param1)
+/// aggregate column into single value
+{
+   return aggr_static_avx512<T, Op, false>(n, nullptr, result, param1);
+}
+
+static inline __mmask8 lanesFrom(pos_t n, uint64_t i)
+/// mask of the lanes of a vector of 8 starting at i which are below n
+{
+   return n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+}
+
+template <typename T>
+size_t few_groups_avx512(pos_t n, T* RES entries[], T* RES found[],
+                         __m512i* groups)
+/// collect the distinct entries of a vector into found, broadcast into
+/// groups. Unused groups are null. Returns fewGroups + 1 if the vector has
+/// more distinct entries
+{
+   size_t nrGroups = 0;
+   for (size_t g = 0; g < fewGroups; ++g) groups[g] = _mm512_setzero_si512();
+   for (uint64_t i = 0; i < n;) {
+      auto lanes = lanesFrom(n, i);
+      auto e = _mm512_maskz_loadu_epi64(lanes, entries + i);
+      __mmask8 known = ~lanes;
+      for (size_t g = 0; g < fewGroups; ++g)
+         known |= _mm512_cmpeq_epi64_mask(e, groups[g]);
+      if (known == 0xff) {
+         i += 8;
+         continue;
+      }
+      if (nrGroups == fewGroups) return fewGroups + 1;
+      found[nrGroups] = entries[i + __builtin_ctz(~known)];
+      groups[nrGroups] = _mm512_set1_epi64((int64_t)found[nrGroups]);
+      ++nrGroups;
+   }
+   return nrGroups;
+}
+
+/// number of tuples aggr_few_* aggregate at once, one pass per group
+const size_t fewBlock = 256;
+
+template <typename T, template <typename> class Op, bool selective>
+pos_t aggr_few_avx512(pos_t n, T* RES entries[], pos_t* RES selParam1,
+                      T* RES param1, size_t offset)
+/// aggregate each of the few groups of the vector in a register, passing
+/// over blocks of the vector once per group. Selected values are gathered
+/// into a dense block first
+{
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   using V = Avx512Aggr<T>;
+   const Op<T> op;
+   T* found[fewGroups];
+   __m512i groups[fewGroups];
+   auto nrGroups = few_groups_avx512(n, entries, found, groups);
+   if (nrGroups > fewGroups) {
+      if (selective)
+         return aggr_sel_col<T, Op>(n, entries, selParam1, param1, offset);
+      return aggr_col<T, Op>(n, entries, param1, offset);
+   }
+   T partial[fewGroups];
+   for (size_t g = 0; g < nrGroups; ++g) partial[g] = OpTraits<T, Op>::neutral;
+   T gathered[fewBlock];
+   for (uint64_t b = 0; b < n; b += fewBlock) {
+      pos_t m = std::min<uint64_t>(fewBlock, n - b);
+      auto e = entries + b;
+      auto values = param1 + b;
+      if (selective) {
+         for (uint64_t i = 0; i < m; i += 8) {
+            auto lanes = lanesFrom(m, i);
+            auto idxs = _mm512_castsi512_si256(
+                _mm512_maskz_loadu_epi32(lanes, selParam1 + b + i));
+            _mm512_storeu_si512(gathered + i,
+                                _mm512_mask_i32gather_epi64(
+                                    _mm512_setzero_si512(), lanes, idxs,
+                                    (const long long int*)param1, 8));
+         }
+         values = gathered;
+      }
+      for (size_t g = 0; g < nrGroups; ++g) {
+         auto aggr = V::set1(OpTraits<T, Op>::neutral);
+         for (uint64_t i = 0; i < m; i += 8) {
+            auto lanes = lanesFrom(m, i);
+            auto matches = _mm512_mask_cmpeq_epi64_mask(
+                lanes, _mm512_maskz_loadu_epi64(lanes, e + i), groups[g]);
+            aggr = V::apply(op, aggr, matches,
+                            _mm512_maskz_loadu_epi64(lanes, values + i));
+         }
+         partial[g] = op(V::reduce(op, aggr), partial[g]);
+      }
+   }
+   for (size_t g = 0; g < nrGroups; ++g) {
+      auto aggregate = addBytes(found[g], offset);
+      *aggregate = op(partial[g], *aggregate);
+   }
+   return n;
+}
+
+template <typename T, template <typename> class Op>
+pos_t aggr_few_col_avx512(pos_t n, T* RES entries[], T* RES param1,
+                          size_t offset)
+/// aggregate into the few groups of the vector
+{
+   return aggr_few_avx512<T, Op, false>(n, entries, nullptr, param1, offset);
+}
+
+pos_t aggr_few_count_star_avx512_(pos_t n, int64_t* RES entries[],
+                                  void* RES param1, size_t offset)
+/// update count aggregates of the few groups of the vector
+{
+   int64_t* found[fewGroups];
+   __m512i groups[fewGroups];
+   auto nrGroups = few_groups_avx512(n, entries, found, groups);
+   if (nrGroups > fewGroups)
+      return aggr_count_star_(n, entries, param1, offset);
+   for (size_t g = 0; g < nrGroups; ++g) {
+      int64_t count = 0;
+      for (uint64_t i = 0; i < n; i += 8) {
+         auto lanes = lanesFrom(n, i);
+         auto e = _mm512_maskz_loadu_epi64(lanes, entries + i);
+         count += __builtin_popcount(
+             _mm512_mask_cmpeq_epi64_mask(lanes, e, groups[g]));
+      }
+      auto aggregate = addBytes(found[g], offset);
+      *aggregate += count;
+   }
+   return n;
+}
+FAggr aggr_few_count_star_avx512 = (FAggr)&aggr_few_count_star_avx512_;
+
+pos_t aggr_static_wide_col_avx512(pos_t n, Sum128* RES result,
+                                  int64_t* RES param1)
+/// sum column into a 128 bit sum. Sums in 64 bit lanes are exact if the
+/// largest magnitude times n fits into 63 bits, which is tracked alongside
+/// the sums as the or of all magnitudes. Otherwise the values are added to
+/// the 128 bit sum one by one
+{
+   using V = Avx512Aggr<int64_t>;
+   // v ^ (v >> 63) is |v| for positive and |v| - 1 for negative v
+   auto magnitude = [](__m512i v) {
+      return _mm512_xor_si512(v, _mm512_srai_epi64(v, 63));
+   };
+   auto sums = _mm512_setzero_si512(), magnitudes = sums;
+   uint64_t i = 0;
+   for (; i + V::lanes <= n; i += V::lanes) {
+      auto values = V::load(param1 + i);
+      sums = _mm512_add_epi64(sums, values);
+      magnitudes = _mm512_or_si512(magnitudes, magnitude(values));
+   }
+   uint64_t maxMagnitude = _mm512_reduce_or_epi64(magnitudes);
+   for (; i < n; ++i) maxMagnitude |= param1[i] ^ (param1[i] >> 63);
+   if (n == 0 || maxMagnitude + 1 <= uint64_t(INT64_MAX) / n) {
+      auto sum = _mm512_reduce_add_epi64(sums);
+      for (i = i - i % V::lanes; i < n; ++i) sum += param1[i];
+      result->add(sum);
+   } else
+      for (i = 0; i < n; ++i) result->add(param1[i]);
+   return n > 0;
+}
+F2 aggr_static_wide_plus_int64_t_col_avx512 =
+    (F2)&aggr_static_wide_col_avx512;
+
+#define MK_AGGR_STATIC_COL_AVX512(type, op)                                    \
+   F2 aggr_static_##op##_##type##_col_avx512 =                                 \
+       (F2)&aggr_static_col_avx512<type, op>;
+#define MK_AGGR_STATIC_SEL_COL_AVX512(type, op)                                \
+   F3 aggr_static_sel_##op##_##type##_col_avx512 =                             \
+       (F3)&aggr_static_avx512<type, op, true>;
+#define MK_AGGR_FEW_COL_AVX512(type, op)                                       \
+   FAggr aggr_few_##op##_##type##_col_avx512 =                                 \
+       (FAggr)&aggr_few_col_avx512<type, op>;
+#define MK_AGGR_FEW_SEL_COL_AVX512(type, op)                                   \
+   FAggrSel aggr_few_sel_##op##_##type##_col_avx512 =                          \
+       (FAggrSel)&aggr_few_avx512<type, op, true>;
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_AGGR, MK_AGGR_STATIC_COL_AVX512)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_AGGR, MK_AGGR_STATIC_SEL_COL_AVX512)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_FEW, MK_AGGR_FEW_COL_AVX512)
+EACH_DECOMPOSABLE(EACH_TYPE_AVX512_FEW, MK_AGGR_FEW_SEL_COL_AVX512)
+#endif
+
+AggrMerge aggrMergeOf(FAggrRow aggrRow) {
+#define MK_AGGR_MERGE(type, op)                                                \
+   if (aggrRow == aggr_row_##op##_##type##_col)                                \
+      return {aggr_init_##op##_##type##_col, aggr_##op##_##type##_col,         \
+              aggr_sel_##op##_##type##_col, aggr_row_##op##_##type##_col,      \
+              gather_val_##type##_col};
+   EACH_DECOMPOSABLE(EACH_TYPE_FULL, MK_AGGR_MERGE)
+#undef MK_AGGR_MERGE
+   throw std::runtime_error("Aggregation can not be merged from partial "
+                            "aggregates.");
+}
 }
 }
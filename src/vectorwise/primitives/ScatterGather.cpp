@@ -32,5 +32,22 @@ EACH_TYPE(NIL, MK_SCATTER_SEL_ROW)
 EACH_TYPE(NIL, MK_GATHER_COL)
 EACH_TYPE(NIL, MK_GATHER_SEL_COL)
 EACH_TYPE(NIL, MK_GATHER_VAL)
+using Sum128 = types::Sum128;
+MK_GATHER_VAL(Sum128)
+
+#define MK_MATERIALIZE_SEL(type)                                               \
+   F3 materialize_sel_##type##_col = (F3)&materialize_sel<type>;
+#define MK_MATERIALIZE_ROWID(type)                                             \
+   F3 materialize_rowid_##type##_col = (F3)&materialize_rowid<type>;
+
+EACH_TYPE(NIL, MK_MATERIALIZE_SEL)
+EACH_TYPE(NIL, MK_MATERIALIZE_ROWID)
+
+pos_t rowid_col_(pos_t n, uint64_t* RES result, size_t* RES offset) {
+   const uint64_t first = *offset;
+   for (uint64_t i = 0; i < n; ++i) result[i] = first + i;
+   return n;
+}
+F2 rowid_col = (F2)&rowid_col_;
 }
 }
@@ -53,6 +53,40 @@ EACH_COMP(EACH_TYPE, MK_SEL_COLVAL_BF)    // with second arg const
 EACH_COMP(EACH_TYPE, MK_SELSEL_COLCOL_BF) // with input selection vector
 EACH_COMP(EACH_TYPE, MK_SELSEL_COLVAL_BF) // with above and second arg const
 
+#define MK_SEL_RANGE(type, op)                                                 \
+   F4 sel_##op##_##type##_col_##type##_val_##type##_val =                      \
+       (F4)&sel_col_range<type, op>;
+#define MK_SELSEL_RANGE(type, op)                                              \
+   F5 selsel_##op##_##type##_col_##type##_val_##type##_val =                   \
+       (F5)&selsel_col_range<type, op>;
+#define MK_SEL_RANGE_BF(type, op)                                              \
+   F4 sel_##op##_##type##_col_##type##_val_##type##_val_bf =                   \
+       (F4)&sel_col_range_bf<type, op>;
+#define MK_SELSEL_RANGE_BF(type, op)                                           \
+   F5 selsel_##op##_##type##_col_##type##_val_##type##_val_bf =                \
+       (F5)&selsel_col_range_bf<type, op>;
+
+// instantiate range selection primitives for each type
+EACH_RANGE(EACH_TYPE, MK_SEL_RANGE)
+EACH_RANGE(EACH_TYPE, MK_SELSEL_RANGE) // with input selection vector
+EACH_RANGE(EACH_TYPE, MK_SEL_RANGE_BF)
+EACH_RANGE(EACH_TYPE, MK_SELSEL_RANGE_BF) // with input selection vector
+
+#define MK_SEL_IN(type)                                                        \
+   F3 sel_in_##type##_col_##type##_list = (F3)&sel_col_in<type>;
+#define MK_SELSEL_IN(type)                                                     \
+   F4 selsel_in_##type##_col_##type##_list = (F4)&selsel_col_in<type>;
+#define MK_SEL_IN_BF(type)                                                     \
+   F3 sel_in_##type##_col_##type##_list_bf = (F3)&sel_col_in_bf<type>;
+#define MK_SELSEL_IN_BF(type)                                                  \
+   F4 selsel_in_##type##_col_##type##_list_bf = (F4)&selsel_col_in_bf<type>;
+
+// instantiate IN-list selection primitives for each type
+EACH_TYPE(NIL, MK_SEL_IN)
+EACH_TYPE(NIL, MK_SELSEL_IN) // with input selection vector
+EACH_TYPE(NIL, MK_SEL_IN_BF)
+EACH_TYPE(NIL, MK_SELSEL_IN_BF) // with input selection vector
+
 template <typename T> struct Contains {
    bool operator()(const T& haystack, const T& needle) {
       return memmem(haystack.value, haystack.len, needle.value, needle.len) !=
@@ -62,6 +96,22 @@ template <typename T> struct Contains {
 F3 sel_contains_Varchar_55_col_Varchar_55_val =
     (F3)&sel_col_val<Varchar_55, Contains>;
 
+#define MK_SEL_PATTERN(type, op)                                               \
+   F3 sel_##op##_##type##_col_pattern = (F3)&sel_col_pattern<type, op>;
+#define MK_SELSEL_PATTERN(type, op)                                            \
+   F4 selsel_##op##_##type##_col_pattern = (F4)&selsel_col_pattern<type, op>;
+#define MK_SEL_PATTERN_BF(type, op)                                            \
+   F3 sel_##op##_##type##_col_pattern_bf = (F3)&sel_col_pattern_bf<type, op>;
+#define MK_SELSEL_PATTERN_BF(type, op)                                         \
+   F4 selsel_##op##_##type##_col_pattern_bf =                                  \
+       (F4)&selsel_col_pattern_bf<type, op>;
+
+// instantiate LIKE selection primitives for each string type
+EACH_LIKE(EACH_TYPE_STRING, MK_SEL_PATTERN)
+EACH_LIKE(EACH_TYPE_STRING, MK_SELSEL_PATTERN) // with input selection vector
+EACH_LIKE(EACH_TYPE_STRING, MK_SEL_PATTERN_BF)
+EACH_LIKE(EACH_TYPE_STRING, MK_SELSEL_PATTERN_BF) // with input selection vector
+
 #ifdef __AVX512F__
 
 // #define PREFETCH(E) __builtin_prefetch(E);
@@ -315,6 +365,147 @@ pos_t selsel_less_equal_int64_t_col_int64_t_val_avx512_impl(
 
 #endif
 
+pos_t sel_in_int32_t_col_int32_t_list_avx512_impl(pos_t n, pos_t* RES result,
+                                                  int32_t* RES param1,
+                                                  InList<int32_t>* RES param2) {
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   const auto& list = *param2;
+   if (!list.isSmall()) return sel_col_in(n, result, param1, param2);
+   __m512i consts[InList<int32_t>::smallLimit];
+   const auto nrConsts = list.values.size();
+   for (size_t c = 0; c < nrConsts; ++c)
+      consts[c] = _mm512_set1_epi32(list.values[c]);
+   uint64_t found = 0;
+   size_t rest = n % 16;
+   auto ids =
+       _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+   for (uint64_t i = 0; i < n - rest; i += 16) {
+      auto in = _mm512_loadu_si512(param1 + i);
+      __mmask16 match = 0;
+      for (size_t c = 0; c < nrConsts; ++c)
+         match |= _mm512_cmpeq_epi32_mask(in, consts[c]);
+      _mm512_mask_compressstoreu_epi32(result + found, match, ids);
+      found += __builtin_popcount(match);
+      ids = _mm512_add_epi32(ids, _mm512_set1_epi32(16));
+   }
+   for (uint64_t i = n - rest; i < n; ++i)
+      for (const auto& con : list.values)
+         if (param1[i] == con) {
+            result[found++] = i;
+            break;
+         }
+   return found;
+}
+
+pos_t selsel_in_int32_t_col_int32_t_list_avx512_impl(
+    pos_t n, pos_t* RES inSel, pos_t* RES result, int32_t* RES param1,
+    InList<int32_t>* RES param2) {
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   const auto& list = *param2;
+   if (!list.isSmall()) return selsel_col_in(n, inSel, result, param1, param2);
+   __m512i consts[InList<int32_t>::smallLimit];
+   const auto nrConsts = list.values.size();
+   for (size_t c = 0; c < nrConsts; ++c)
+      consts[c] = _mm512_set1_epi32(list.values[c]);
+   uint64_t found = 0;
+   size_t rest = n % 16;
+   for (uint64_t i = 0; i < n - rest; i += 16) {
+      auto idxs = _mm512_loadu_si512(inSel + i);
+      auto in = _mm512_i32gather_epi32(idxs, (const int*)param1, 4);
+      __mmask16 match = 0;
+      for (size_t c = 0; c < nrConsts; ++c)
+         match |= _mm512_cmpeq_epi32_mask(in, consts[c]);
+      _mm512_mask_compressstoreu_epi32(result + found, match, idxs);
+      found += __builtin_popcount(match);
+   }
+   for (uint64_t i = n - rest; i < n; ++i) {
+      const auto idx = inSel[i];
+      for (const auto& con : list.values)
+         if (param1[idx] == con) {
+            result[found++] = idx;
+            break;
+         }
+   }
+   return found;
+}
+
+pos_t sel_in_int64_t_col_int64_t_list_avx512_impl(pos_t n, pos_t* RES result,
+                                                  int64_t* RES param1,
+                                                  InList<int64_t>* RES param2) {
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   const auto& list = *param2;
+   if (!list.isSmall()) return sel_col_in(n, result, param1, param2);
+   __m512i consts[InList<int64_t>::smallLimit];
+   const auto nrConsts = list.values.size();
+   for (size_t c = 0; c < nrConsts; ++c)
+      consts[c] = _mm512_set1_epi64(list.values[c]);
+   uint64_t found = 0;
+   size_t rest = n % 16;
+   auto ids =
+       _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+   for (uint64_t i = 0; i < n - rest; i += 16) {
+      // two vectors of eight values give the mask of 16 row ids
+      auto lo = _mm512_loadu_si512(param1 + i);
+      auto hi = _mm512_loadu_si512(param1 + i + 8);
+      __mmask16 match = 0;
+      for (size_t c = 0; c < nrConsts; ++c)
+         match |= _mm512_cmpeq_epi64_mask(lo, consts[c]) |
+                  (_mm512_cmpeq_epi64_mask(hi, consts[c]) << 8);
+      _mm512_mask_compressstoreu_epi32(result + found, match, ids);
+      found += __builtin_popcount(match);
+      ids = _mm512_add_epi32(ids, _mm512_set1_epi32(16));
+   }
+   for (uint64_t i = n - rest; i < n; ++i)
+      for (const auto& con : list.values)
+         if (param1[i] == con) {
+            result[found++] = i;
+            break;
+         }
+   return found;
+}
+
+pos_t selsel_in_int64_t_col_int64_t_list_avx512_impl(
+    pos_t n, pos_t* RES inSel, pos_t* RES result, int64_t* RES param1,
+    InList<int64_t>* RES param2) {
+   static_assert(sizeof(pos_t) == 4,
+                 "This implementation only supports sizeof(pos_t) == 4");
+   const auto& list = *param2;
+   if (!list.isSmall()) return selsel_col_in(n, inSel, result, param1, param2);
+   __m512i consts[InList<int64_t>::smallLimit];
+   const auto nrConsts = list.values.size();
+   for (size_t c = 0; c < nrConsts; ++c)
+      consts[c] = _mm512_set1_epi64(list.values[c]);
+   uint64_t found = 0;
+   size_t rest = n % 16;
+   for (uint64_t i = 0; i < n - rest; i += 16) {
+      auto lo = _mm512_i32gather_epi64(
+          _mm256_loadu_si256((const __m256i*)(inSel + i)),
+          (const long long int*)param1, 8);
+      auto hi = _mm512_i32gather_epi64(
+          _mm256_loadu_si256((const __m256i*)(inSel + i + 8)),
+          (const long long int*)param1, 8);
+      __mmask16 match = 0;
+      for (size_t c = 0; c < nrConsts; ++c)
+         match |= _mm512_cmpeq_epi64_mask(lo, consts[c]) |
+                  (_mm512_cmpeq_epi64_mask(hi, consts[c]) << 8);
+      _mm512_mask_compressstoreu_epi32(result + found, match,
+                                       _mm512_loadu_si512(inSel + i));
+      found += __builtin_popcount(match);
+   }
+   for (uint64_t i = n - rest; i < n; ++i) {
+      const auto idx = inSel[i];
+      for (const auto& con : list.values)
+         if (param1[idx] == con) {
+            result[found++] = idx;
+            break;
+         }
+   }
+   return found;
+}
+
 F3 sel_less_int32_t_col_int32_t_val_avx512 =
     (F3)&sel_less_int32_t_col_int32_t_val_avx512_impl;
 F4 selsel_greater_equal_int32_t_col_int32_t_val_avx512 =
@@ -325,6 +516,14 @@ F4 selsel_greater_equal_int64_t_col_int64_t_val_avx512 =
     (F4)&selsel_greater_equal_int64_t_col_int64_t_val_avx512_impl;
 F4 selsel_less_equal_int64_t_col_int64_t_val_avx512 =
     (F4)&selsel_less_equal_int64_t_col_int64_t_val_avx512_impl;
+F3 sel_in_int32_t_col_int32_t_list_avx512 =
+    (F3)&sel_in_int32_t_col_int32_t_list_avx512_impl;
+F4 selsel_in_int32_t_col_int32_t_list_avx512 =
+    (F4)&selsel_in_int32_t_col_int32_t_list_avx512_impl;
+F3 sel_in_int64_t_col_int64_t_list_avx512 =
+    (F3)&sel_in_int64_t_col_int64_t_list_avx512_impl;
+F4 selsel_in_int64_t_col_int64_t_list_avx512 =
+    (F4)&selsel_in_int64_t_col_int64_t_list_avx512_impl;
 #endif
 }
 } // namespace vectorwise